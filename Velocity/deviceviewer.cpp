@@ -41,9 +41,35 @@ DeviceViewer::DeviceViewer(QStatusBar *statusBar, QList<QAction *> gpdActions,
 
 DeviceViewer::~DeviceViewer()
 {
+    SaveSnapshots();
     delete ui;
 }
 
+QString DeviceViewer::SnapshotPath(FatxDrive *drive)
+{
+    QString directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/DriveSnapshots";
+    QDir().mkpath(directory);
+
+    QString identity = QString::fromStdString(drive->GetDriveIdentity()).trimmed();
+    return directory + "/" + QString(identity.toUtf8().toHex()) + ".snapshot";
+}
+
+void DeviceViewer::SaveSnapshots()
+{
+    // the snapshots let the drives open without reading everything again the next time they're connected
+    for (std::unique_ptr<FatxDrive> &drive : loadedDrives)
+    {
+        try
+        {
+            drive->SaveSnapshot(SnapshotPath(drive.get()).toStdString());
+        }
+        catch (...)
+        {
+            // the drive just gets read like usual next time
+        }
+    }
+}
+
 void DeviceViewer::DrawMemoryGraph()
 {
     UINT64 totalFreeSpace = 0;
@@ -343,6 +369,7 @@ void DeviceViewer::LoadDrives()
     // clear all the items
     ui->treeWidget->clear();
 
+    SaveSnapshots();
     loadedDrives.clear();
     currentDrive = nullptr;
     currentDriveItem = nullptr;
@@ -360,6 +387,8 @@ void DeviceViewer::LoadDrives()
         for (size_t i = 0; i < loadedDrives.size(); i++)
         {
             FatxDrive *drive = loadedDrives.at(i).get();
+            drive->LoadSnapshot(SnapshotPath(drive).toStdString());
+
             QTreeWidgetItem *driveItem = new QTreeWidgetItem(ui->treeWidget_2);
             driveItem->setData(0, Qt::UserRole, QVariant::fromValue(drive));
 
@@ -813,7 +842,13 @@ void DeviceViewer::on_btnBackup_clicked()
     if (savePath == "")
         return;
 
-    SingleProgressDialog *dialog = new SingleProgressDialog(FileSystemFATX, currentDrive, OpBackup, "",
+    // a sparse backup leaves out the free clusters, so it's only as big as what's on the drive
+    bool sparse = QMessageBox::question(this, "Backup Type", "Do you want to back up only the space that's in use? "
+            "The backup will be much smaller, but it can only be restored to a drive of the same size.",
+            QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes;
+
+    SingleProgressDialog *dialog = new SingleProgressDialog(FileSystemFATX, currentDrive,
+            sparse ? OpSparseBackup : OpBackup, "",
             savePath, nullptr, this);
     dialog->setModal(true);
     dialog->show();
@@ -15,6 +15,8 @@
 #include <QProgressBar>
 #include <QPixmap>
 #include <QAction>
+#include <QDir>
+#include <QStandardPaths>
 #include "qthelpers.h"
 
 // forms
@@ -102,6 +104,8 @@ private:
     void InjectFiles(QList<void *> files, QString rootPath);
     void DrawHeader(QString driveName);
     void SetWidgetsEnabled(bool enabled);
+    QString SnapshotPath(FatxDrive *drive);
+    void SaveSnapshots();
 
     friend void updateUI(void *arg, bool finished);
     friend void updateUIDelete(void *arg);
@@ -149,7 +149,8 @@ void IsoDialog::loadIsoContents(const QString& path) {
 
     if (!iso_) iso_.reset(new XboxInternals::Iso::IsoImage());
     
-    if (!iso_->open(path.toStdString())) {
+    // map the image, the dialog only reads it
+    if (!iso_->open(path.toStdString(), true)) {
         QMessageBox::warning(this, tr("Error"), 
             tr("Failed to open ISO file:\n%1\n\nThis could be due to:\n"
                "- File is not a valid Xbox 360 ISO\n"
@@ -651,7 +651,8 @@ void MainWindow::on_actionPackage_triggered()
 
     try
     {
-        auto package = std::make_unique<StfsPackage>(fileName.toStdString());
+        // map the package, the viewer walks its hash tables and file listing straight out of the mapping
+        auto package = std::make_unique<StfsPackage>(fileName.toStdString(), StfsPackageMapFile);
 
         auto viewer = new PackageViewer(ui->statusBar, package.release(), gpdActions, gameActions, this);
         viewer->setAttribute(Qt::WA_DeleteOnClose);
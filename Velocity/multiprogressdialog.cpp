@@ -1,7 +1,7 @@
 #include "multiprogressdialog.h"
 #include "ui_multiprogressdialog.h"
 #include <QTimer>
-#include <QMutexLocker>
+#include <algorithm>
 
 // ExtractionWorker implementation
 ExtractionWorker::ExtractionWorker(MultiProgressDialog *dialog)
@@ -16,7 +16,7 @@ void ExtractionWorker::run()
     {
         for (int i = 0; i < dialog_->internalFiles.size(); i++)
         {
-            if (isInterruptionRequested())
+            if (isInterruptionRequested() || dialog_->context_.IsCancelled())
             {
                 emit extractionComplete(false, "Extraction cancelled by user");
                 return;
@@ -48,7 +48,7 @@ void ExtractionWorker::run()
                         }
 
                         StfsPackage *package = reinterpret_cast<StfsPackage*>(dialog_->device);
-                        package->ExtractFile(entry->entry, dirPathStd, updateProgress, dialog_);
+                        package->ExtractFile(entry->entry, dirPathStd, nullptr, nullptr, &dialog_->context_);
                         
                         delete entry;
                     }
@@ -88,7 +88,8 @@ void ExtractionWorker::run()
 
                     try
                     {
-                        io.SaveFile(dialog_->outDir.toStdString() + entry->name, updateProgress, dialog_);
+                        io.SaveFile(dialog_->outDir.toStdString() + entry->name, nullptr, nullptr,
+                                &dialog_->context_);
                         io.Close();
                     }
                     catch (string error)
@@ -125,7 +126,7 @@ void ExtractionWorker::run()
                         if (!saveDir.exists())
                             saveDir.mkpath(dirPath);
 
-                        io.SaveFile(dirPath.toStdString() + entry->name, updateProgress, dialog_);
+                        io.SaveFile(dirPath.toStdString() + entry->name, nullptr, nullptr, &dialog_->context_);
                     }
                     catch (string error)
                     {
@@ -160,7 +161,7 @@ MultiProgressDialog::MultiProgressDialog(Operation op, FileSystem fileSystem, vo
     QDialog(parent),ui(new Ui::MultiProgressDialog), system(fileSystem), device(device), outDir(outDir),
     internalFiles(internalFiles),
     fileIndex(0), overallProgress(0), overallProgressTotal(0), prevProgress(0), rootPath(rootPath),
-    op(op), parentEntry(parentEntry), worker_(nullptr)
+    op(op), parentEntry(parentEntry), worker_(nullptr), pollTimer_(nullptr)
 {
     setWindowFlags(windowFlags() & ~Qt::WindowContextHelpButtonHint);
     ui->setupUi(this);
@@ -177,6 +178,7 @@ MultiProgressDialog::MultiProgressDialog(Operation op, FileSystem fileSystem, vo
             ui->lblIcon->setPixmap(QPixmap(":/Images/inject.png"));
             break;
         case OpBackup:
+        case OpSparseBackup:
             break;
         case OpRestore:
             break;
@@ -187,6 +189,8 @@ MultiProgressDialog::~MultiProgressDialog()
 {
     if (worker_)
     {
+        // stop the worker in the middle of the file it's on
+        context_.Cancel();
         worker_->requestInterruption();
         worker_->wait(5000);  // Wait up to 5 seconds
         delete worker_;
@@ -196,42 +200,49 @@ MultiProgressDialog::~MultiProgressDialog()
 
 void MultiProgressDialog::start()
 {
-    // calculate the total overall progress
-    switch(system)
+    // For extraction operations, use worker thread
+    if (op == OpExtract)
     {
-        case FileSystemSTFS:
-            for (int i = 0; i < internalFiles.size(); i++)
-            {
-                StfsFileEntry *entry = reinterpret_cast<StfsFileEntry*>(internalFiles.at(i));
-                if (entry->blocksForFile == 0)
-                    overallProgressTotal++;
-                else
-                    overallProgressTotal += entry->blocksForFile;
-            }
-            break;
-        case FileSystemSVOD:
-            for (int i = 0; i < internalFiles.size(); i++)
+        // the worker counts bytes against these as it goes
+        UINT64 totalBytes = 0;
+        UINT64 totalFiles = 0;
+        for (int i = 0; i < internalFiles.size(); i++)
+        {
+            switch (system)
             {
-                GdfxFileEntry *entry = reinterpret_cast<GdfxFileEntry*>(internalFiles.at(i));
-                overallProgressTotal += (entry->size + 0xFFFF) / 0x10000;
+                case FileSystemSTFS:
+                    totalBytes += reinterpret_cast<StfsExtractEntry*>(internalFiles.at(i))->entry->fileSize;
+                    totalFiles++;
+                    break;
+                case FileSystemSVOD:
+                    totalBytes += reinterpret_cast<GdfxFileEntry*>(internalFiles.at(i))->size;
+                    totalFiles++;
+                    break;
+                case FileSystemFATX:
+                {
+                    FatxFileEntry *entry = reinterpret_cast<FatxFileEntry*>(internalFiles.at(i));
+                    if (!(entry->fileAttributes & FatxDirectory))
+                    {
+                        totalBytes += entry->fileSize;
+                        totalFiles++;
+                    }
+                    break;
+                }
             }
-            break;
-        case FileSystemFATX:
-            overallProgressTotal = 0;
-            ui->progressBar_2->setTextVisible(false);
-            break;
-    }
+        }
+        context_.SetTotals(totalBytes, totalFiles);
+
+        // the bars show thousandths, the byte counts don't fit in an int
+        ui->progressBar->setMaximum(1000);
+        ui->progressBar_2->setMaximum(1000);
+
+        pollTimer_ = new QTimer(this);
+        connect(pollTimer_, &QTimer::timeout, this, &MultiProgressDialog::onPollProgress);
+        pollTimer_->start(100);
 
-    ui->progressBar_2->setMaximum(overallProgressTotal);
-    
-    // For extraction operations, use worker thread
-    if (op == OpExtract)
-    {
         worker_ = new ExtractionWorker(this);
         
         // Connect signals from worker to UI update slots
-        connect(worker_, &ExtractionWorker::progressUpdate, this, &MultiProgressDialog::onProgressUpdate);
-        connect(worker_, &ExtractionWorker::fileComplete, this, &MultiProgressDialog::onFileComplete);
         connect(worker_, &ExtractionWorker::extractionComplete, this, &MultiProgressDialog::onExtractionComplete);
         connect(worker_, &ExtractionWorker::windowTitleUpdate, this, &MultiProgressDialog::onWindowTitleUpdate);
         connect(worker_, &ExtractionWorker::groupBoxTitleUpdate, this, &MultiProgressDialog::onGroupBoxTitleUpdate);
@@ -240,33 +251,73 @@ void MultiProgressDialog::start()
     }
     else
     {
+        // calculate the total overall progress
+        switch(system)
+        {
+            case FileSystemSTFS:
+                for (int i = 0; i < internalFiles.size(); i++)
+                {
+                    StfsFileEntry *entry = reinterpret_cast<StfsExtractEntry*>(internalFiles.at(i))->entry;
+                    if (entry->blocksForFile == 0)
+                        overallProgressTotal++;
+                    else
+                        overallProgressTotal += entry->blocksForFile;
+                }
+                break;
+            case FileSystemSVOD:
+                for (int i = 0; i < internalFiles.size(); i++)
+                {
+                    GdfxFileEntry *entry = reinterpret_cast<GdfxFileEntry*>(internalFiles.at(i));
+                    overallProgressTotal += (entry->size + 0xFFFF) / 0x10000;
+                }
+                break;
+            case FileSystemFATX:
+                overallProgressTotal = 0;
+                ui->progressBar_2->setTextVisible(false);
+                break;
+        }
+
+        ui->progressBar_2->setMaximum(overallProgressTotal);
+
         // For other operations (inject, etc.), use original synchronous approach
         operateOnNextFile();
     }
 }
 
-void MultiProgressDialog::onProgressUpdate(int fileIndex, DWORD curProgress, DWORD total)
+void MultiProgressDialog::closeEvent(QCloseEvent *event)
 {
-    QMutexLocker locker(&progressMutex_);
-    
-    ui->progressBar->setValue(curProgress);
-    ui->progressBar->setMaximum(total);
+    // closing the dialog while extracting cancels whatever's left
+    if (worker_ && worker_->isRunning())
+        context_.Cancel();
 
-    if (system != FileSystemFATX)
-    {
-        overallProgress += (curProgress - prevProgress);
-        ui->progressBar_2->setValue(overallProgress);
-        prevProgress = curProgress;
-    }
+    QDialog::closeEvent(event);
 }
 
-void MultiProgressDialog::onFileComplete(int fileIndex)
+void MultiProgressDialog::onPollProgress()
 {
-    // File completed, progress update already handled
+    auto thousandths = [](UINT64 done, UINT64 total)
+    {
+        if (total == 0)
+            return 0;
+        return (int)(std::min(done, total) * 1000 / total);
+    };
+
+    ui->progressBar->setValue(thousandths(context_.ItemBytesDone(), context_.ItemBytesTotal()));
+    ui->progressBar_2->setValue(thousandths(context_.BytesDone(), context_.BytesTotal()));
 }
 
 void MultiProgressDialog::onExtractionComplete(bool success, QString errorMessage)
 {
+    if (pollTimer_)
+        pollTimer_->stop();
+
+    // the user cancelled it by closing the dialog, they already know
+    if (!success && context_.IsCancelled())
+    {
+        close();
+        return;
+    }
+
     if (success)
     {
         close();
@@ -489,38 +540,25 @@ void updateProgress(void *form, DWORD curProgress, DWORD total)
     // get the dialog back
     MultiProgressDialog *dialog = reinterpret_cast<MultiProgressDialog*>(form);
 
-    // If worker thread exists, emit signals for thread-safe UI updates
-    if (dialog->worker_ && QThread::currentThread() == dialog->worker_)
-    {
-        // We're on the worker thread - use signals
-        emit dialog->worker_->progressUpdate(dialog->fileIndex, curProgress, total);
-        
-        if (curProgress == total && dialog->system != FileSystemFATX)
-        {
-            emit dialog->worker_->fileComplete(dialog->fileIndex);
-        }
-    }
-    else
-    {
-        // We're on the main thread (old synchronous path for inject operations)
-        dialog->ui->progressBar->setValue(curProgress);
-        dialog->ui->progressBar->setMaximum(total);
-
-        if (dialog->system != FileSystemFATX)
-        {
-            dialog->overallProgress += (curProgress - dialog->prevProgress);
-            dialog->ui->progressBar_2->setValue(dialog->overallProgress);
-            dialog->prevProgress = curProgress;
+    // extraction counts its progress through the context, so this is only the synchronous path for
+    // inject operations on the main thread
+    dialog->ui->progressBar->setValue(curProgress);
+    dialog->ui->progressBar->setMaximum(total);
 
-            if (curProgress == total)
-                dialog->operateOnNextFile();
-        }
+    if (dialog->system != FileSystemFATX)
+    {
+        dialog->overallProgress += (curProgress - dialog->prevProgress);
+        dialog->ui->progressBar_2->setValue(dialog->overallProgress);
+        dialog->prevProgress = curProgress;
 
-        // Process events for non-threaded operations
         if (curProgress == total)
-        {
-            QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
-        }
+            dialog->operateOnNextFile();
+    }
+
+    // Process events for non-threaded operations
+    if (curProgress == total)
+    {
+        QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
     }
 }
 
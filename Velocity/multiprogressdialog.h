@@ -6,7 +6,8 @@
 #include <QMessageBox>
 #include <QDir>
 #include <QThread>
-#include <QMutex>
+#include <QTimer>
+#include <QCloseEvent>
 #include "qthelpers.h"
 
 // xbox
@@ -16,6 +17,7 @@
 #include <XboxInternals/Stfs/StfsPackage.h>
 #include <XboxInternals/Fatx/FatxConstants.h>
 #include <XboxInternals/Fatx/FatxDrive.h>
+#include <XboxInternals/IO/OperationContext.h>
 
 enum Operation
 {
@@ -23,6 +25,7 @@ enum Operation
     OpReplace,
     OpInject,
     OpBackup,
+    OpSparseBackup,
     OpRestore
 };
 
@@ -52,8 +55,6 @@ public:
     void run() override;
 
 signals:
-    void progressUpdate(int fileIndex, DWORD curProgress, DWORD total);
-    void fileComplete(int fileIndex);
     void extractionComplete(bool success, QString errorMessage);
     void windowTitleUpdate(QString title);
     void groupBoxTitleUpdate(QString title);
@@ -74,9 +75,11 @@ public:
 
     void start();
 
+protected:
+    void closeEvent(QCloseEvent *event) override;
+
 private slots:
-    void onProgressUpdate(int fileIndex, DWORD curProgress, DWORD total);
-    void onFileComplete(int fileIndex);
+    void onPollProgress();
     void onExtractionComplete(bool success, QString errorMessage);
     void onWindowTitleUpdate(QString title);
     void onGroupBoxTitleUpdate(QString title);
@@ -94,9 +97,12 @@ private:
     QString rootPath;
     Operation op;
     FatxFileEntry *parentEntry;
-    QMutex progressMutex_;  // Protect progress updates from multiple threads
     ExtractionWorker *worker_;
 
+    // the worker counts its progress here, and the timer polls it into the progress bars
+    OperationContext context_;
+    QTimer *pollTimer_;
+
     void operateOnNextFile();
 
     friend void updateProgress(void *form, DWORD curProgress, DWORD total);
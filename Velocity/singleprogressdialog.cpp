@@ -23,6 +23,7 @@ SingleProgressDialog::SingleProgressDialog(FileSystem system, void *device, Oper
             ui->lblIcon->setPixmap(QPixmap(":/Images/add.png"));
             break;
         case OpBackup:
+        case OpSparseBackup:
             setWindowTitle("Creating Backup");
             ui->lblIcon->setPixmap(QPixmap(":/Images/save.png"));
             break;
@@ -82,12 +83,15 @@ void SingleProgressDialog::start()
                                 "An error occurred while copy the file to your device.\n\n" + QString::fromStdString(error));
                     }
                 }
-                else if (op == OpBackup)
+                else if (op == OpBackup || op == OpSparseBackup)
                 {
                     try
                     {
                         FatxDrive *drive = reinterpret_cast<FatxDrive*>(device);
-                        drive->CreateBackup(externalPath.toStdString(), UpdateProgress, this);
+                        if (op == OpSparseBackup)
+                            drive->CreateSparseBackup(externalPath.toStdString(), UpdateProgress, this);
+                        else
+                            drive->CreateBackup(externalPath.toStdString(), UpdateProgress, this);
                     }
                     catch (string error)
                     {
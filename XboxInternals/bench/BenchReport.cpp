@@ -0,0 +1,186 @@
+#include "BenchReport.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <Windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+#ifndef XBOXINTERNALS_BENCH_VERSION
+    #define XBOXINTERNALS_BENCH_VERSION "unknown"
+#endif
+
+BenchReport::BenchReport(DWORD iterations) : iterations(std::max<DWORD>(iterations, 1))
+{
+}
+
+void BenchReport::Run(std::string fixture, std::string operation, UINT64 bytes, UINT64 items,
+        std::function<void()> op, std::function<void()> setup)
+{
+    BenchResult result = { fixture, operation, bytes, items, {}, 0 };
+
+    try
+    {
+        for (DWORD i = 0; i < iterations; i++)
+        {
+            if (setup)
+                setup();
+
+            auto start = std::chrono::steady_clock::now();
+            op();
+            auto end = std::chrono::steady_clock::now();
+
+            result.seconds.push_back(std::chrono::duration<double>(end - start).count());
+        }
+    }
+    catch (const std::string &error)
+    {
+        Fail(fixture, operation, error);
+        return;
+    }
+    catch (const std::exception &error)
+    {
+        Fail(fixture, operation, error.what());
+        return;
+    }
+
+    result.peakResidentBytes = PeakResidentBytes();
+    results.push_back(result);
+
+    std::cerr << fixture << " " << operation << ": " << std::fixed << std::setprecision(4) <<
+            *std::min_element(result.seconds.begin(), result.seconds.end()) << "s\n";
+}
+
+void BenchReport::Fail(std::string fixture, std::string operation, std::string error)
+{
+    failures.push_back({ fixture, operation, error });
+    std::cerr << fixture << " " << operation << " failed: " << error << "\n";
+}
+
+bool BenchReport::HasFailures()
+{
+    return !failures.empty();
+}
+
+void BenchReport::WriteJson(std::ostream &out)
+{
+    char timestamp[32] = { 0 };
+    std::time_t now = std::time(nullptr);
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    std::ostringstream json;
+    json << std::setprecision(6) << std::fixed;
+
+    json << "{\n";
+    json << "  \"benchmark\": \"XboxInternalsBench\",\n";
+    json << "  \"version\": \"" << XBOXINTERNALS_BENCH_VERSION << "\",\n";
+    json << "  \"timestamp\": \"" << timestamp << "\",\n";
+    json << "  \"iterations\": " << iterations << ",\n";
+    json << "  \"peakResidentBytes\": " << PeakResidentBytes() << ",\n";
+
+    json << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchResult &result = results.at(i);
+
+        // the fastest run is the one least disturbed by everything else going on
+        double best = *std::min_element(result.seconds.begin(), result.seconds.end());
+        double mean = std::accumulate(result.seconds.begin(), result.seconds.end(), 0.0) /
+                result.seconds.size();
+
+        json << ((i == 0) ? "\n" : ",\n");
+        json << "    {\n";
+        json << "      \"fixture\": \"" << escape(result.fixture) << "\",\n";
+        json << "      \"operation\": \"" << escape(result.operation) << "\",\n";
+        json << "      \"bytes\": " << result.bytes << ",\n";
+        json << "      \"items\": " << result.items << ",\n";
+        json << "      \"minSeconds\": " << best << ",\n";
+        json << "      \"meanSeconds\": " << mean << ",\n";
+        json << "      \"megabytesPerSecond\": " << ((best > 0) ? result.bytes / best / 1000000.0 : 0.0) << ",\n";
+        json << "      \"opsPerSecond\": " << ((best > 0) ? result.items / best : 0.0) << ",\n";
+        json << "      \"peakResidentBytes\": " << result.peakResidentBytes << "\n";
+        json << "    }";
+    }
+    json << (results.empty() ? "],\n" : "\n  ],\n");
+
+    json << "  \"failures\": [";
+    for (size_t i = 0; i < failures.size(); i++)
+    {
+        const Failure &failure = failures.at(i);
+
+        json << ((i == 0) ? "\n" : ",\n");
+        json << "    { \"fixture\": \"" << escape(failure.fixture) << "\", \"operation\": \"" <<
+                escape(failure.operation) << "\", \"error\": \"" << escape(failure.error) << "\" }";
+    }
+    json << (failures.empty() ? "]\n" : "\n  ]\n");
+    json << "}\n";
+
+    out << json.str();
+}
+
+UINT64 BenchReport::PeakResidentBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0;
+    return counters.PeakWorkingSetSize;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+    // linux reports it in kilobytes, macOS in bytes
+#ifdef __APPLE__
+    return (UINT64)usage.ru_maxrss;
+#else
+    return (UINT64)usage.ru_maxrss * 1024;
+#endif
+#endif
+}
+
+std::string BenchReport::escape(const std::string &str)
+{
+    std::ostringstream escaped;
+    for (char c : str)
+    {
+        switch (c)
+        {
+            case '"':
+                escaped << "\\\"";
+                break;
+            case '\\':
+                escaped << "\\\\";
+                break;
+            case '\n':
+                escaped << "\\n";
+                break;
+            case '\r':
+                escaped << "\\r";
+                break;
+            case '\t':
+                escaped << "\\t";
+                break;
+            default:
+                if ((unsigned char)c < 0x20)
+                    escaped << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec;
+                else
+                    escaped << c;
+        }
+    }
+    return escaped.str();
+}
@@ -0,0 +1,63 @@
+#ifndef BENCHREPORT_H
+#define BENCHREPORT_H
+
+#include <XboxInternals/TypeDefinitions.h>
+
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// the timings of one operation on one fixture
+struct BenchResult
+{
+    std::string fixture;
+    std::string operation;
+
+    // the amount of data and items (files, entries, clusters) handled by a single run
+    UINT64 bytes;
+    UINT64 items;
+
+    std::vector<double> seconds;
+
+    // the peak resident set size of the process once the operation had finished
+    UINT64 peakResidentBytes;
+};
+
+class BenchReport
+{
+public:
+    explicit BenchReport(DWORD iterations);
+
+    // time op iterations times, setup is run before every iteration and isn't timed
+    void Run(std::string fixture, std::string operation, UINT64 bytes, UINT64 items,
+            std::function<void()> op, std::function<void()> setup = nullptr);
+
+    // report an operation that couldn't be run on a fixture
+    void Fail(std::string fixture, std::string operation, std::string error);
+
+    // whether any operation failed
+    bool HasFailures();
+
+    // write everything that's been run so far as a JSON document
+    void WriteJson(std::ostream &out);
+
+    // the largest amount of memory the process has had resident so far, 0 if it isn't known
+    static UINT64 PeakResidentBytes();
+
+private:
+    struct Failure
+    {
+        std::string fixture;
+        std::string operation;
+        std::string error;
+    };
+
+    static std::string escape(const std::string &str);
+
+    DWORD iterations;
+    std::vector<BenchResult> results;
+    std::vector<Failure> failures;
+};
+
+#endif // BENCHREPORT_H
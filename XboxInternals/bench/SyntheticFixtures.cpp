@@ -0,0 +1,613 @@
+#include "SyntheticFixtures.h"
+
+#include <XboxInternals/Disc/Gdfx.h>
+#include <XboxInternals/Fatx/FatxConstants.h>
+#include <XboxInternals/Gpd/XdbfDefinitions.h>
+#include <XboxInternals/IO/MemoryIO.h>
+#include <XboxInternals/Utils.h>
+#include <XboxInternals/Xex/XexDefinitions.h>
+
+#include <botan_all.h>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <sstream>
+
+// where the dev kit partition table puts the content partition, after the security sector
+#define FIXTURE_FATX_CONTENT_ADDRESS 0x80000
+
+#define FIXTURE_XDBF_MAGIC 0x58444246
+#define FIXTURE_XDBF_FREE_MEM_TABLE_LENGTH 0x200
+
+#define FIXTURE_XEX_SECURITY_INFO_ADDRESS 0x1000
+#define FIXTURE_XEX_DATA_ADDRESS 0x2000
+#define FIXTURE_XEX_BASE_ADDRESS 0x82000000
+
+// a zero compressed image alternates between this much data and this many zeros
+#define FIXTURE_XEX_DATA_RUN 0x10000
+#define FIXTURE_XEX_ZERO_RUN 0x30000
+
+#define FIXTURE_GDFX_SECTOR_SIZE 0x800
+#define FIXTURE_GDFX_HEADER_ADDRESS 0x10000
+
+namespace
+{
+
+// spread the sizes of consecutive files out over a range, the same index always gets the same size
+DWORD sizeForIndex(DWORD index, DWORD minSize, DWORD maxSize)
+{
+    if (maxSize <= minSize)
+        return minSize;
+    return minSize + (DWORD)(((UINT64)index * 2654435761u) % (maxSize - minSize + 1));
+}
+
+// lays out a directory tree in a single FATX partition, directly in the drive image
+class FatxPartitionWriter
+{
+public:
+    FatxPartitionWriter(MemoryIO &io, UINT64 address, const FixturePartition &partition, DWORD partitionId) :
+        io(io), nextCluster(1)
+    {
+        clusterSize = partition.sectorsPerCluster * FATX_SECTOR_SIZE;
+
+        // the same geometry FatxDrive works out for the partition
+        UINT64 totalClusters = partition.size / clusterSize + 1;
+        clusterEntrySize = (totalClusters >= FAT_CLUSTER16_RESERVED) ? FAT32 : FAT16;
+        UINT64 chainmapSize = Utils::RoundToNearestHex1000(totalClusters * clusterEntrySize);
+
+        clusterCount = (DWORD)((partition.size - FATX_HEADER_SIZE - chainmapSize) / clusterSize);
+        chainmapAddress = address + FATX_HEADER_SIZE;
+        clusterStartingAddress = chainmapAddress + chainmapSize;
+
+        io.SetEndian(BigEndian);
+        io.SetPosition(address);
+        io.Write((DWORD)FATX_MAGIC);
+        io.Write(partitionId);
+        io.Write(partition.sectorsPerCluster);
+        io.Write((DWORD)1);
+
+        // the first entry in the chainmap is never used for a cluster
+        writeLink(0, (clusterEntrySize == FAT16) ? FAT_CLUSTER16_LAST - 7 : FAT_CLUSTER_LAST - 7);
+
+        // the root directory is always the first cluster
+        writeDirectory(partition.root);
+    }
+
+private:
+    // allocate count clusters, a stride of more than 1 leaves gaps between them
+    std::vector<DWORD> allocate(DWORD count, DWORD stride)
+    {
+        std::vector<DWORD> chain;
+        for (DWORD i = 0; i < count; i++)
+        {
+            if (nextCluster > clusterCount)
+                throw std::string("Bench: The synthetic FATX partition is too small for its files.\n");
+
+            chain.push_back(nextCluster);
+            nextCluster += stride;
+        }
+
+        // link the clusters together in the chainmap
+        for (size_t i = 0; i < chain.size(); i++)
+        {
+            DWORD next = (i + 1 < chain.size()) ? chain.at(i + 1) :
+                    ((clusterEntrySize == FAT16) ? FAT_CLUSTER16_LAST : FAT_CLUSTER_LAST);
+            writeLink(chain.at(i), next);
+        }
+
+        return chain;
+    }
+
+    void writeLink(DWORD cluster, DWORD next)
+    {
+        io.SetPosition(chainmapAddress + (UINT64)cluster * clusterEntrySize);
+        if (clusterEntrySize == FAT16)
+            io.Write((WORD)next);
+        else
+            io.Write(next);
+    }
+
+    UINT64 clusterToOffset(DWORD cluster)
+    {
+        return clusterStartingAddress + (UINT64)(cluster - 1) * clusterSize;
+    }
+
+    DWORD writeFile(const FixtureNode &file, DWORD seed)
+    {
+        if (file.size == 0)
+            return 0;
+
+        DWORD count = (file.size + clusterSize - 1) / clusterSize;
+        std::vector<DWORD> chain = allocate(count, file.fragmented ? 2 : 1);
+
+        DWORD remaining = file.size;
+        for (size_t i = 0; i < chain.size(); i++)
+        {
+            DWORD len = std::min(remaining, clusterSize);
+            SyntheticFixtures::FillPattern(io.GetBuffer() + clusterToOffset(chain.at(i)), len, seed + (DWORD)i);
+            remaining -= len;
+        }
+
+        return chain.at(0);
+    }
+
+    DWORD writeDirectory(const FixtureNode &directory)
+    {
+        DWORD entriesPerCluster = clusterSize / FATX_ENTRY_SIZE;
+        DWORD count = std::max<DWORD>(1, ((DWORD)directory.children.size() + entriesPerCluster - 1) /
+                entriesPerCluster);
+        std::vector<DWORD> chain = allocate(count, 1);
+
+        // everything past the last entry has to be 0xFF so it isn't picked up as one
+        for (DWORD cluster : chain)
+            memset(io.GetBuffer() + clusterToOffset(cluster), 0xFF, clusterSize);
+
+        for (size_t i = 0; i < directory.children.size(); i++)
+        {
+            const FixtureNode &child = directory.children.at(i);
+            DWORD startingCluster = child.directory ? writeDirectory(child) :
+                    writeFile(child, chain.at(0) * 0x1000 + (DWORD)i);
+
+            io.SetPosition(clusterToOffset(chain.at(i / entriesPerCluster)) +
+                    (i % entriesPerCluster) * FATX_ENTRY_SIZE);
+            io.Write((BYTE)child.name.length());
+            io.Write((BYTE)(child.directory ? FatxDirectory : 0));
+            io.Write(child.name, FATX_ENTRY_MAX_NAME_LENGTH, false, 0xFF);
+            io.Write(startingCluster);
+            io.Write((DWORD)(child.directory ? 0 : child.size));
+
+            // creation, last write and last access, all on the same day
+            for (int time = 0; time < 3; time++)
+                io.Write((DWORD)0x4A210000);
+        }
+
+        return chain.at(0);
+    }
+
+    MemoryIO &io;
+    DWORD clusterSize;
+    BYTE clusterEntrySize;
+    DWORD clusterCount;
+    UINT64 chainmapAddress;
+    UINT64 clusterStartingAddress;
+    DWORD nextCluster;
+};
+
+void writeXdbfEntry(BaseIO &table, EntryType type, UINT64 id, DWORD specifier, DWORD length)
+{
+    table.Write((WORD)type);
+    table.Write(id);
+    table.Write(specifier);
+    table.Write(length);
+}
+
+// the amount of sectors a GDFX directory listing of the node's children takes up
+DWORD gdfxListingSectors(const FixtureNode &directory)
+{
+    DWORD sectors = 1, offset = 0;
+    for (const FixtureNode &child : directory.children)
+    {
+        DWORD len = (child.name.length() + 0x11) & 0xFFFFFFFC;
+
+        // entries can't run over the end of a sector, and there's always room left for the end marker
+        if (offset + len + 4 > FIXTURE_GDFX_SECTOR_SIZE)
+        {
+            sectors++;
+            offset = 0;
+        }
+        offset += len;
+    }
+    return sectors;
+}
+
+void assignGdfxDirectorySectors(const FixtureNode &directory, std::map<const FixtureNode*, DWORD> &sectors,
+        DWORD *nextSector)
+{
+    sectors[&directory] = *nextSector;
+    *nextSector += gdfxListingSectors(directory);
+
+    for (const FixtureNode &child : directory.children)
+        if (child.directory)
+            assignGdfxDirectorySectors(child, sectors, nextSector);
+}
+
+void assignGdfxFileSectors(const FixtureNode &directory, std::map<const FixtureNode*, DWORD> &sectors,
+        DWORD *nextSector)
+{
+    for (const FixtureNode &child : directory.children)
+    {
+        if (child.directory)
+        {
+            assignGdfxFileSectors(child, sectors, nextSector);
+        }
+        else
+        {
+            sectors[&child] = *nextSector;
+            *nextSector += (child.size + FIXTURE_GDFX_SECTOR_SIZE - 1) / FIXTURE_GDFX_SECTOR_SIZE;
+        }
+    }
+}
+
+void writeGdfxDirectory(MemoryIO &io, const FixtureNode &directory, std::map<const FixtureNode*, DWORD> &sectors)
+{
+    DWORD sector = sectors[&directory];
+    UINT64 listingAddress = (UINT64)sector * FIXTURE_GDFX_SECTOR_SIZE;
+    DWORD listingSectors = gdfxListingSectors(directory);
+
+    // 0xFF fills the space after the last entry in every sector, which marks the end of it
+    memset(io.GetBuffer() + listingAddress, 0xFF, listingSectors * FIXTURE_GDFX_SECTOR_SIZE);
+
+    DWORD offset = 0;
+    for (const FixtureNode &child : directory.children)
+    {
+        DWORD len = (child.name.length() + 0x11) & 0xFFFFFFFC;
+        if (offset + len + 4 > FIXTURE_GDFX_SECTOR_SIZE)
+        {
+            sector++;
+            offset = 0;
+        }
+
+        GdfxFileEntry entry;
+        entry.unknown = 0;
+        entry.sector = sectors[&child];
+        entry.size = child.directory ? gdfxListingSectors(child) * FIXTURE_GDFX_SECTOR_SIZE : child.size;
+        entry.attributes = child.directory ? GdfxDirectory : GdfxNormal;
+        entry.nameLen = (BYTE)child.name.length();
+        entry.name = child.name;
+
+        UINT64 entryAddress = (UINT64)sector * FIXTURE_GDFX_SECTOR_SIZE + offset;
+        io.SetPosition(entryAddress);
+        GdfxWriteFileEntry(&io, &entry);
+
+        // the name is written null terminated, put back the fill that terminator went over
+        io.GetBuffer()[entryAddress + 14 + entry.nameLen] = 0xFF;
+        offset += len;
+
+        if (child.directory)
+            writeGdfxDirectory(io, child, sectors);
+        else
+            SyntheticFixtures::FillPattern(io.GetBuffer() + (UINT64)entry.sector * FIXTURE_GDFX_SECTOR_SIZE,
+                    child.size, entry.sector);
+    }
+}
+
+}
+
+FixtureNode SyntheticFixtures::BuildTree(DWORD depth, DWORD fanout, DWORD filesPerDirectory, DWORD minFileSize,
+        DWORD maxFileSize, DWORD fragmentEvery)
+{
+    FixtureNode root = { "", true, 0, false, {} };
+    DWORD fileIndex = 0;
+    addTreeLevel(root, depth, fanout, filesPerDirectory, minFileSize, maxFileSize, fragmentEvery, &fileIndex);
+    return root;
+}
+
+void SyntheticFixtures::addTreeLevel(FixtureNode &directory, DWORD depth, DWORD fanout, DWORD filesPerDirectory,
+        DWORD minFileSize, DWORD maxFileSize, DWORD fragmentEvery, DWORD *fileIndex)
+{
+    for (DWORD i = 0; i < filesPerDirectory; i++)
+    {
+        std::stringstream name;
+        name << "file" << i << ".bin";
+
+        bool fragmented = fragmentEvery != 0 && (*fileIndex % fragmentEvery) == fragmentEvery - 1;
+        directory.children.push_back({ name.str(), false, sizeForIndex(*fileIndex, minFileSize, maxFileSize),
+                fragmented, {} });
+        (*fileIndex)++;
+    }
+
+    if (depth == 0)
+        return;
+
+    for (DWORD i = 0; i < fanout; i++)
+    {
+        std::stringstream name;
+        name << "dir" << i;
+
+        FixtureNode child = { name.str(), true, 0, false, {} };
+        addTreeLevel(child, depth - 1, fanout, filesPerDirectory, minFileSize, maxFileSize, fragmentEvery,
+                fileIndex);
+        directory.children.push_back(child);
+    }
+}
+
+void SyntheticFixtures::AddDeepChain(FixtureNode &root, DWORD depth, DWORD fileSize)
+{
+    FixtureNode *current = &root;
+    for (DWORD i = 0; i < depth; i++)
+    {
+        std::stringstream name;
+        name << "deep" << i;
+
+        current->children.push_back({ name.str(), true, 0, false, {} });
+        current = &current->children.back();
+        current->children.push_back({ "leaf.bin", false, fileSize, false, {} });
+    }
+}
+
+void SyntheticFixtures::Measure(const FixtureNode &root, UINT64 *fileCount, UINT64 *directoryCount,
+        UINT64 *totalSize)
+{
+    for (const FixtureNode &child : root.children)
+    {
+        if (child.directory)
+        {
+            (*directoryCount)++;
+            Measure(child, fileCount, directoryCount, totalSize);
+        }
+        else
+        {
+            (*fileCount)++;
+            *totalSize += child.size;
+        }
+    }
+}
+
+void SyntheticFixtures::FillPattern(BYTE *buffer, size_t len, DWORD seed)
+{
+    // xorshift, cheap enough to fill hundreds of megabytes
+    DWORD state = seed * 0x9E3779B9 + 0x6D2B79F5;
+    size_t i = 0;
+    for (; i + 4 <= len; i += 4)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        memcpy(buffer + i, &state, 4);
+    }
+    for (; i < len; i++)
+        buffer[i] = (BYTE)(state >> (8 * (i & 3)));
+}
+
+std::vector<BYTE> SyntheticFixtures::BuildFatxImage(const FixturePartition &content, const FixturePartition &dashboard)
+{
+    UINT64 dashboardAddress = FIXTURE_FATX_CONTENT_ADDRESS + content.size;
+
+    std::vector<BYTE> image(dashboardAddress + dashboard.size, 0);
+    MemoryIO io(image.data(), image.size());
+    io.SetEndian(BigEndian);
+
+    // a format recovery version new enough for the drive to have a partition table
+    io.Write((WORD)2);
+    io.Write((WORD)0);
+    io.Write((WORD)1525);
+    io.Write((WORD)1);
+
+    // the partition table, in sectors
+    io.Write((DWORD)(FIXTURE_FATX_CONTENT_ADDRESS / FATX_SECTOR_SIZE));
+    io.Write((DWORD)(content.size / FATX_SECTOR_SIZE));
+    io.Write((DWORD)(dashboardAddress / FATX_SECTOR_SIZE));
+    io.Write((DWORD)(dashboard.size / FATX_SECTOR_SIZE));
+
+    FatxPartitionWriter contentWriter(io, FIXTURE_FATX_CONTENT_ADDRESS, content, 0x20000001);
+    FatxPartitionWriter dashboardWriter(io, dashboardAddress, dashboard, 0x20000002);
+
+    return image;
+}
+
+std::vector<BYTE> SyntheticFixtures::BuildXdbf(DWORD achievementCount, DWORD settingCount, DWORD imageCount,
+        DWORD imageSize, DWORD spareEntries)
+{
+    // every group with syncs has a sync list and sync data entry on top of its own entries
+    DWORD entryCount = achievementCount + imageCount + settingCount + 4;
+    DWORD entryTableLength = entryCount + spareEntries;
+    DWORD dataAddress = 0x18 + entryTableLength * 0x12 + FIXTURE_XDBF_FREE_MEM_TABLE_LENGTH * 8;
+
+    MemoryIO io;
+    io.SetEndian(BigEndian);
+
+    io.Write((DWORD)FIXTURE_XDBF_MAGIC);
+    io.Write((DWORD)0x10000);
+    io.Write(entryTableLength);
+    io.Write(entryCount);
+    io.Write((DWORD)FIXTURE_XDBF_FREE_MEM_TABLE_LENGTH);
+    io.Write((DWORD)1);
+
+    // the entries are written into a separate table, then the data straight after the header space
+    MemoryIO table;
+    table.SetEndian(BigEndian);
+    io.SetPosition(dataAddress);
+
+    auto specifier = [&]() { return (DWORD)(io.GetPosition() - dataAddress); };
+
+    auto writeSyncs = [&](EntryType type, UINT64 firstID, DWORD count)
+    {
+        DWORD listAddress = specifier();
+        for (DWORD i = 0; i < count; i++)
+        {
+            io.Write((UINT64)(firstID + i));
+            io.Write((UINT64)0);
+        }
+        writeXdbfEntry(table, type, 0x100000000, listAddress, count * 0x10);
+
+        DWORD dataSpecifier = specifier();
+        io.Write((UINT64)count);
+        io.Write((UINT64)count);
+        io.Write((UINT64)0);
+        writeXdbfEntry(table, type, 0x200000000, dataSpecifier, 0x18);
+    };
+
+    for (DWORD i = 0; i < achievementCount; i++)
+    {
+        DWORD address = specifier();
+
+        std::wstringstream name;
+        name << L"Achievement " << (i + 1);
+
+        io.Write((DWORD)0x1C);
+        io.Write((DWORD)(i + 1));
+        io.Write((DWORD)(0x8000 + (i % std::max<DWORD>(imageCount, 1))));
+        io.Write((DWORD)(5 + (i % 20) * 5));
+        io.Write((DWORD)((i % 3 == 0) ? (Unlocked | Completion) : Completion));
+        io.Write((UINT64)0);
+        io.Write(name.str());
+        io.Write(std::wstring(L"Do the thing a few more times."));
+        io.Write(std::wstring(L"Did the thing a few more times."));
+
+        writeXdbfEntry(table, Achievement, i + 1, address, specifier() - address);
+    }
+    if (achievementCount != 0)
+        writeSyncs(Achievement, 1, achievementCount);
+
+    std::vector<BYTE> imageData(imageSize);
+    for (DWORD i = 0; i < imageCount; i++)
+    {
+        DWORD address = specifier();
+        FillPattern(imageData.data(), imageSize, i);
+        io.Write(imageData.data(), imageSize);
+
+        writeXdbfEntry(table, Image, 0x8000 + i, address, imageSize);
+    }
+
+    for (DWORD i = 0; i < settingCount; i++)
+    {
+        DWORD address = specifier();
+        DWORD id = 0x10040000 + i;
+
+        // the setting id, then the type and an int32 value
+        io.Write(id);
+        io.Write((DWORD)0);
+        io.Write((BYTE)Int32);
+        io.Write((BYTE)0);
+        io.Write((WORD)0);
+        io.Write((DWORD)0);
+        io.Write((DWORD)i);
+        io.Write((DWORD)0);
+
+        writeXdbfEntry(table, Setting, id, address, 0x18);
+    }
+    if (settingCount != 0)
+        writeSyncs(Setting, 0x10040000, settingCount);
+
+    // all the space past the end of the data is free
+    DWORD end = specifier();
+
+    // the entry table and a single free memory entry
+    io.SetPosition(0x18);
+    io.Write(table.GetBuffer(), (DWORD)table.Length());
+
+    io.SetPosition(0x18 + entryTableLength * 0x12);
+    io.Write(end);
+    io.Write((DWORD)(0xFFFFFFFF - end));
+
+    return std::vector<BYTE>(io.GetBuffer(), io.GetBuffer() + io.Length());
+}
+
+std::vector<BYTE> SyntheticFixtures::BuildXex(DWORD imageSize, bool zeroCompressed)
+{
+    DWORD blockSize = FIXTURE_XEX_DATA_RUN + FIXTURE_XEX_ZERO_RUN;
+    DWORD blockCount = zeroCompressed ? std::max<DWORD>(1, imageSize / blockSize) : 0;
+    if (zeroCompressed)
+        imageSize = blockCount * blockSize;
+    imageSize = (imageSize + 0xFFF) & ~0xFFF;
+
+    DWORD dataSize = zeroCompressed ? blockCount * FIXTURE_XEX_DATA_RUN : imageSize;
+
+    MemoryIO io;
+    io.SetEndian(BigEndian);
+
+    // header, with the base file descriptor, image base address and entry point optional headers
+    io.Write((DWORD)XEX_HEADER_MAGIC);
+    io.Write((DWORD)1);
+    io.Write((DWORD)FIXTURE_XEX_DATA_ADDRESS);
+    io.Write((DWORD)0);
+    io.Write((DWORD)FIXTURE_XEX_SECURITY_INFO_ADDRESS);
+    io.Write((DWORD)3);
+
+    io.Write((DWORD)BaseFileDescriptor);
+    io.Write((DWORD)0x200);
+    io.Write((DWORD)ImageBaseAddress);
+    io.Write((DWORD)FIXTURE_XEX_BASE_ADDRESS);
+    io.Write((DWORD)EntryPoint);
+    io.Write((DWORD)(FIXTURE_XEX_BASE_ADDRESS + 0x1000));
+
+    io.SetPosition(0x200);
+    io.Write((DWORD)(8 + blockCount * XEX_COMPRESSION_BLOCK_SIZE));
+    io.Write((WORD)1);
+    io.Write((WORD)(zeroCompressed ? XexCompressed : XexDecompressed));
+    for (DWORD i = 0; i < blockCount; i++)
+    {
+        io.Write((DWORD)FIXTURE_XEX_DATA_RUN);
+        io.Write((DWORD)FIXTURE_XEX_ZERO_RUN);
+    }
+
+    // the session key, stored encrypted with the retail key
+    BYTE sessionKey[XEX_AES_BLOCK_SIZE];
+    FillPattern(sessionKey, XEX_AES_BLOCK_SIZE, imageSize);
+
+    auto aes = Botan::BlockCipher::create("AES-128");
+    BYTE encryptedKey[XEX_AES_BLOCK_SIZE];
+    memcpy(encryptedKey, sessionKey, XEX_AES_BLOCK_SIZE);
+    aes->set_key(XEX_RETAIL_KEY, XEX_AES_BLOCK_SIZE);
+    aes->encrypt(encryptedKey);
+
+    BYTE zeros[0x100] = { 0 };
+    io.SetPosition(FIXTURE_XEX_SECURITY_INFO_ADDRESS);
+    io.Write((DWORD)0x180);
+    io.Write(imageSize);
+    io.Write(zeros, 0x100);
+    io.Write((DWORD)0x174);
+    io.Write((DWORD)PageSize4KB);
+    io.Write((DWORD)FIXTURE_XEX_BASE_ADDRESS);
+    io.Write(zeros, 0x14);
+    io.Write((DWORD)0);
+    io.Write(zeros, 0x14);
+    io.Write(zeros, 0x10);
+    io.Write(encryptedKey, XEX_AES_BLOCK_SIZE);
+    io.Write((DWORD)0);
+    io.Write(zeros, 0x14);
+    io.Write((DWORD)0xFFFFFFFF);
+    io.Write((DWORD)0xFFFFFFFF);
+
+    // a single code section covering the whole image
+    io.Write((DWORD)1);
+    io.Write((DWORD)(((imageSize / 0x1000) << 4) | 1));
+    io.Write(zeros, 0x14);
+
+    // the data that's in the file, which starts with the PE magic
+    std::vector<BYTE> data(dataSize);
+    FillPattern(data.data(), dataSize, dataSize);
+    data[0] = 'M';
+    data[1] = 'Z';
+
+    // it's all one AES-128-CBC stream, even when it's split into blocks
+    aes->set_key(sessionKey, XEX_AES_BLOCK_SIZE);
+    BYTE iv[XEX_AES_BLOCK_SIZE] = { 0 };
+    for (DWORD i = 0; i < dataSize; i += XEX_AES_BLOCK_SIZE)
+    {
+        BYTE *block = data.data() + i;
+        for (DWORD x = 0; x < XEX_AES_BLOCK_SIZE; x++)
+            block[x] ^= iv[x];
+        aes->encrypt(block);
+        memcpy(iv, block, XEX_AES_BLOCK_SIZE);
+    }
+
+    io.SetPosition(FIXTURE_XEX_DATA_ADDRESS);
+    io.Write(data.data(), dataSize);
+
+    return std::vector<BYTE>(io.GetBuffer(), io.GetBuffer() + io.Length());
+}
+
+std::vector<BYTE> SyntheticFixtures::BuildGdfxImage(const FixtureNode &root)
+{
+    // the header sits at the start of sector 0x20, the listings come straight after it and then the files
+    std::map<const FixtureNode*, DWORD> sectors;
+    DWORD nextSector = FIXTURE_GDFX_HEADER_ADDRESS / FIXTURE_GDFX_SECTOR_SIZE + 1;
+    assignGdfxDirectorySectors(root, sectors, &nextSector);
+    assignGdfxFileSectors(root, sectors, &nextSector);
+
+    std::vector<BYTE> image((size_t)nextSector * FIXTURE_GDFX_SECTOR_SIZE, 0);
+    MemoryIO io(image.data(), image.size());
+
+    io.SetPosition(FIXTURE_GDFX_HEADER_ADDRESS);
+    io.Write((BYTE*)"MICROSOFT*XBOX*MEDIA", 0x14);
+    io.SetEndian(LittleEndian);
+    io.Write(sectors[&root]);
+    io.Write((DWORD)(gdfxListingSectors(root) * FIXTURE_GDFX_SECTOR_SIZE));
+    io.Write((UINT64)0);
+
+    writeGdfxDirectory(io, root, sectors);
+
+    return image;
+}
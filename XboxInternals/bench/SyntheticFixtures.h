@@ -0,0 +1,71 @@
+#ifndef SYNTHETICFIXTURES_H
+#define SYNTHETICFIXTURES_H
+
+#include <XboxInternals/TypeDefinitions.h>
+
+#include <string>
+#include <vector>
+
+// a file or directory laid out in a synthetic image
+struct FixtureNode
+{
+    std::string name;
+    bool directory;
+    DWORD size;
+
+    // FATX only, spread the file's clusters out so its chain isn't one consecutive run
+    bool fragmented;
+
+    std::vector<FixtureNode> children;
+};
+
+// the contents of a FATX partition in a synthetic drive image
+struct FixturePartition
+{
+    UINT64 size;
+    DWORD sectorsPerCluster;
+    FixtureNode root;
+};
+
+// Generates the images the benchmarks run against, everything is made up from scratch so no console
+// data is needed. All the generators are deterministic, the same arguments always give the same bytes.
+class SyntheticFixtures
+{
+public:
+    // build a directory tree depth levels deep, every directory has fanout sub directories (until the
+    // bottom level) and filesPerDirectory files, file sizes are spread between minFileSize and maxFileSize
+    // and every fragmentEvery'th file is fragmented (0 for none)
+    static FixtureNode BuildTree(DWORD depth, DWORD fanout, DWORD filesPerDirectory, DWORD minFileSize,
+            DWORD maxFileSize, DWORD fragmentEvery = 0);
+
+    // add a chain of directories depth levels deep to root, each holding one file of fileSize bytes
+    static void AddDeepChain(FixtureNode &root, DWORD depth, DWORD fileSize);
+
+    // count the files and directories in the tree, and the total size of the files
+    static void Measure(const FixtureNode &root, UINT64 *fileCount, UINT64 *directoryCount, UINT64 *totalSize);
+
+    // fill buffer with data that's different for every seed, but not all the same byte
+    static void FillPattern(BYTE *buffer, size_t len, DWORD seed);
+
+    // build a dev kit hard drive image with the content and dashboard partitions from its partition table,
+    // whether a partition is FAT16 or FAT32 follows from its size and cluster size
+    static std::vector<BYTE> BuildFatxImage(const FixturePartition &content, const FixturePartition &dashboard);
+
+    // build an XDBF file with the given amount of achievements, settings and images (each imageSize bytes),
+    // with room in the entry table for spareEntries more
+    static std::vector<BYTE> BuildXdbf(DWORD achievementCount, DWORD settingCount, DWORD imageCount,
+            DWORD imageSize, DWORD spareEntries);
+
+    // build a retail encrypted XEX holding imageSize bytes of image data, when zeroCompressed is set the
+    // image is mostly runs of zeros and those are left out of the file with basic compression
+    static std::vector<BYTE> BuildXex(DWORD imageSize, bool zeroCompressed);
+
+    // build an XGD1 disc image with a GDFX file system holding root's children
+    static std::vector<BYTE> BuildGdfxImage(const FixtureNode &root);
+
+private:
+    static void addTreeLevel(FixtureNode &directory, DWORD depth, DWORD fanout, DWORD filesPerDirectory,
+            DWORD minFileSize, DWORD maxFileSize, DWORD fragmentEvery, DWORD *fileIndex);
+};
+
+#endif // SYNTHETICFIXTURES_H
@@ -0,0 +1,481 @@
+// XboxInternalsBench - times the main XboxInternals operations against synthetic fixtures
+//
+// Usage: XboxInternalsBench [--iterations N] [--filter TEXT] [--output PATH] [--work-dir PATH]
+//
+// Every fixture is generated on the fly, so no console data is needed. The results are written as
+// JSON to stdout (or to --output), progress goes to stderr.
+
+#include "BenchReport.h"
+#include "SyntheticFixtures.h"
+
+#include <XboxInternals/Disc/ISO.h>
+#include <XboxInternals/Fatx/FatxDrive.h>
+#include <XboxInternals/Gpd/Xdbf.h>
+#include <XboxInternals/IO/FatxIO.h>
+#include <XboxInternals/IO/MemoryIO.h>
+#include <XboxInternals/Stfs/StfsPackage.h>
+#include <XboxInternals/Xex/Xex.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+
+struct BenchOptions
+{
+    DWORD iterations = 3;
+    std::string filter;
+    std::string outputPath;
+    fs::path workDirectory;
+};
+
+bool selected(const BenchOptions &options, const std::string &fixture)
+{
+    return options.filter.empty() || fixture.find(options.filter) != std::string::npos;
+}
+
+void writeFile(const fs::path &path, const std::vector<BYTE> &data)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(data.data()), data.size());
+    if (!out)
+        throw std::string("Bench: Error writing " + path.string() + ".\n");
+}
+
+// an empty directory in the work directory, for an operation to write into
+fs::path freshDirectory(const BenchOptions &options, const std::string &name)
+{
+    fs::path directory = options.workDirectory / name;
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+    return directory;
+}
+
+void benchStfs(BenchReport &report, const BenchOptions &options, const std::string &fixture, DWORD fileCount,
+        DWORD fileSize)
+{
+    if (!selected(options, fixture))
+        return;
+
+    UINT64 totalSize = (UINT64)fileCount * fileSize;
+    std::vector<BYTE> fileData(fileSize);
+    SyntheticFixtures::FillPattern(fileData.data(), fileSize, fileSize);
+
+    // creating the package is the inject benchmark, the result is what everything else runs against
+    std::unique_ptr<MemoryIO> packageIO;
+    report.Run(fixture, "inject", totalSize, fileCount, [&]()
+    {
+        auto created = std::make_unique<MemoryIO>();
+        {
+            StfsPackage package(created.get(), StfsPackageCreate);
+
+            package.metaData->contentType = SavedGame;
+            package.metaData->titleID = 0x58410000;
+            package.metaData->displayName = L"XboxInternalsBench";
+            package.metaData->titleName = L"XboxInternalsBench";
+            package.metaData->WriteMetaData();
+
+            for (DWORD i = 0; i < fileCount; i++)
+            {
+                std::stringstream name;
+                name << "file" << i << ".bin";
+                package.InjectData(fileData.data(), fileSize, name.str());
+            }
+        }
+        packageIO = std::move(created);
+    });
+    if (!packageIO)
+        return;
+
+    std::vector<BYTE> image(packageIO->GetBuffer(), packageIO->GetBuffer() + packageIO->Length());
+    packageIO.reset();
+
+    std::unique_ptr<StfsPackage> package;
+    std::unique_ptr<MemoryIO> io;
+    auto close = [&]()
+    {
+        package.reset();
+        io.reset();
+    };
+
+    // rehashing writes to the package, so it always gets a copy of its own
+    report.Run(fixture, "rehash", image.size(), fileCount, [&]() { package->Rehash(); }, [&]()
+    {
+        close();
+        io = std::make_unique<MemoryIO>(image);
+        package = std::make_unique<StfsPackage>(io.get());
+    });
+
+    report.Run(fixture, "open", image.size(), 1, [&]() { package = std::make_unique<StfsPackage>(io.get()); },
+            [&]()
+    {
+        close();
+        io = std::make_unique<MemoryIO>(image.data(), image.size());
+    });
+    if (!package)
+        return;
+
+    report.Run(fixture, "list", 0, fileCount, [&]() { package->GetFileListing(true); });
+
+    StfsFileListing listing = package->GetFileListing();
+    fs::path extractDirectory;
+    report.Run(fixture, "extract", totalSize, fileCount, [&]()
+    {
+        for (StfsFileEntry &entry : listing.fileEntries)
+            package->ExtractFile(&entry, (extractDirectory / entry.name).string());
+    }, [&]() { extractDirectory = freshDirectory(options, fixture); });
+
+    close();
+    fs::remove_all(extractDirectory);
+}
+
+// read every directory under entry, adding the files in them to files
+void listFatxDirectory(FatxDrive &drive, FatxFileEntry *entry, std::vector<FatxFileEntry*> &files, UINT64 *entryCount)
+{
+    drive.GetChildFileEntries(entry);
+
+    for (FatxFileEntry &child : entry->cachedFiles)
+    {
+        (*entryCount)++;
+        if (child.fileAttributes & FatxDirectory)
+            listFatxDirectory(drive, &child, files, entryCount);
+        else
+            files.push_back(&child);
+    }
+}
+
+void benchFatxPartition(BenchReport &report, const BenchOptions &options, const std::vector<BYTE> &image,
+        const std::string &fixture, BYTE clusterEntrySize, const FixtureNode &tree)
+{
+    if (!selected(options, fixture))
+        return;
+
+    UINT64 fileCount = 0, directoryCount = 0, totalSize = 0;
+    SyntheticFixtures::Measure(tree, &fileCount, &directoryCount, &totalSize);
+
+    std::unique_ptr<FatxDrive> drive;
+    Partition *partition = nullptr;
+
+    // most operations only read, those can run against the image itself
+    auto open = [&](bool copy)
+    {
+        drive.reset();
+        BaseIO *io = copy ? new MemoryIO(image) : new MemoryIO(const_cast<BYTE*>(image.data()), image.size());
+        drive = std::make_unique<FatxDrive>(io, FatxHarddrive);
+
+        partition = nullptr;
+        for (Partition *part : drive->GetPartitions())
+            if (part->clusterEntrySize == clusterEntrySize)
+                partition = part;
+        if (partition == nullptr)
+            throw std::string("Bench: The synthetic drive is missing a partition.\n");
+    };
+
+    std::vector<FatxFileEntry*> files;
+    UINT64 entryCount = 0;
+    report.Run(fixture, "list", 0, fileCount + directoryCount, [&]()
+    {
+        listFatxDirectory(*drive, &partition->root, files, &entryCount);
+    }, [&]()
+    {
+        open(false);
+        files.clear();
+        entryCount = 0;
+    });
+    if (partition == nullptr)
+        return;
+
+    fs::path extractDirectory;
+    report.Run(fixture, "extract", totalSize, fileCount, [&]()
+    {
+        for (size_t i = 0; i < files.size(); i++)
+        {
+            std::stringstream name;
+            name << i << ".bin";
+
+            FatxIO io = drive->GetFatxIO(files.at(i));
+            io.SaveFile((extractDirectory / name.str()).string());
+        }
+    }, [&]() { extractDirectory = freshDirectory(options, fixture); });
+    fs::remove_all(extractDirectory);
+
+    report.Run(fixture, "free-space-scan", (UINT64)partition->clusterCount * clusterEntrySize,
+            partition->clusterCount, [&]() { drive->GetFreeMemory(partition); }, [&]() { open(false); });
+
+    // inject a handful of files into the root of a copy of the drive
+    const DWORD injectCount = 16, injectSize = 0x40000;
+    fs::path sourceDirectory = freshDirectory(options, fixture + "-source");
+    std::vector<BYTE> injectData(injectSize);
+    SyntheticFixtures::FillPattern(injectData.data(), injectSize, injectSize);
+    writeFile(sourceDirectory / "inject.bin", injectData);
+
+    report.Run(fixture, "inject", (UINT64)injectCount * injectSize, injectCount, [&]()
+    {
+        for (DWORD i = 0; i < injectCount; i++)
+        {
+            std::stringstream name;
+            name << "inject" << i << ".bin";
+            drive->InjectFile(&partition->root, name.str(), (sourceDirectory / "inject.bin").string());
+        }
+    }, [&]()
+    {
+        open(true);
+        drive->GetFreeMemory(partition);
+        drive->GetChildFileEntries(&partition->root);
+    });
+
+    drive.reset();
+    fs::remove_all(sourceDirectory);
+}
+
+void benchFatx(BenchReport &report, const BenchOptions &options)
+{
+    if (!selected(options, "fatx"))
+        return;
+
+    // a FAT32 content partition with lots of small files in a wide tree and a deep one, and a FAT16
+    // dashboard partition with fewer larger files, both with some of their files fragmented
+    FixturePartition content = { 0x8000000, 2, SyntheticFixtures::BuildTree(3, 6, 6, 0x400, 0x10000, 4) };
+    SyntheticFixtures::AddDeepChain(content.root, 32, 0x1000);
+
+    FixturePartition dashboard = { 0x4000000, 0x20, SyntheticFixtures::BuildTree(2, 4, 4, 0x4000, 0x80000, 3) };
+
+    std::vector<BYTE> image = SyntheticFixtures::BuildFatxImage(content, dashboard);
+
+    std::unique_ptr<FatxDrive> drive;
+    std::unique_ptr<MemoryIO> io;
+    report.Run("fatx", "open", 0, 1, [&]() { drive = std::make_unique<FatxDrive>(io.release(), FatxHarddrive); },
+            [&]()
+    {
+        drive.reset();
+        io = std::make_unique<MemoryIO>(image.data(), image.size());
+    });
+    drive.reset();
+
+    benchFatxPartition(report, options, image, "fatx-fat32", FAT32, content.root);
+    benchFatxPartition(report, options, image, "fatx-fat16", FAT16, dashboard.root);
+}
+
+void benchGpd(BenchReport &report, const BenchOptions &options)
+{
+    const std::string fixture = "gpd";
+    if (!selected(options, fixture))
+        return;
+
+    const DWORD achievementCount = 4000, settingCount = 1000, imageCount = 200, imageSize = 0x1000;
+    const DWORD createCount = 256;
+    const DWORD entryCount = achievementCount + settingCount + imageCount;
+
+    std::vector<BYTE> gpd = SyntheticFixtures::BuildXdbf(achievementCount, settingCount, imageCount, imageSize,
+            createCount);
+    fs::path path = options.workDirectory / "bench.gpd";
+    writeFile(path, gpd);
+
+    std::unique_ptr<Xdbf> xdbf;
+
+    // anything that modifies the file gets a fresh copy of it
+    auto reset = [&]()
+    {
+        xdbf.reset();
+        writeFile(path, gpd);
+        xdbf = std::make_unique<Xdbf>(path.string());
+    };
+
+    report.Run(fixture, "open", gpd.size(), entryCount, [&]() { xdbf = std::make_unique<Xdbf>(path.string()); },
+            [&]() { xdbf.reset(); });
+    if (!xdbf)
+        return;
+
+    std::vector<XdbfEntry> entries = xdbf->achievements.entries;
+    entries.insert(entries.end(), xdbf->images.begin(), xdbf->images.end());
+    entries.insert(entries.end(), xdbf->settings.entries.begin(), xdbf->settings.entries.end());
+
+    UINT64 entryBytes = 0;
+    for (const XdbfEntry &entry : entries)
+        entryBytes += entry.length;
+
+    std::vector<BYTE> buffer(imageSize);
+    report.Run(fixture, "extract", entryBytes, entries.size(), [&]()
+    {
+        for (const XdbfEntry &entry : entries)
+        {
+            if (entry.length > buffer.size())
+                buffer.resize(entry.length);
+            xdbf->ExtractEntry(entry, buffer.data());
+        }
+    });
+
+    report.Run(fixture, "create", (UINT64)createCount * 0x18, createCount, [&]()
+    {
+        for (DWORD i = 0; i < createCount; i++)
+            xdbf->CreateEntry(Setting, 0x10080000 + i, 0x18);
+    }, reset);
+
+    report.Run(fixture, "clean", gpd.size(), entryCount, [&]() { xdbf->Clean(); }, reset);
+
+    xdbf.reset();
+    fs::remove(path);
+}
+
+void benchXex(BenchReport &report, const BenchOptions &options, const std::string &fixture, DWORD imageSize,
+        bool zeroCompressed)
+{
+    if (!selected(options, fixture))
+        return;
+
+    std::vector<BYTE> file = SyntheticFixtures::BuildXex(imageSize, zeroCompressed);
+    MemoryIO io(file.data(), file.size());
+
+    std::unique_ptr<Xex> xex;
+    report.Run(fixture, "open", file.size(), 1, [&]() { xex = std::make_unique<Xex>(&io); },
+            [&]() { xex.reset(); });
+    if (!xex)
+        return;
+
+    fs::path outPath = options.workDirectory / (fixture + ".bin");
+    report.Run(fixture, "extract", xex->GetImageSize(), 1, [&]() { xex->ExtractData(outPath.string()); });
+
+    xex.reset();
+    fs::remove(outPath);
+}
+
+void benchGdfx(BenchReport &report, const BenchOptions &options)
+{
+    const std::string fixture = "gdfx";
+    if (!selected(options, fixture))
+        return;
+
+    FixtureNode tree = SyntheticFixtures::BuildTree(2, 4, 8, 0x800, 0x80000);
+    SyntheticFixtures::AddDeepChain(tree, 16, 0x2000);
+
+    UINT64 fileCount = 0, directoryCount = 0, totalSize = 0;
+    SyntheticFixtures::Measure(tree, &fileCount, &directoryCount, &totalSize);
+
+    fs::path path = options.workDirectory / "bench.iso";
+    {
+        std::vector<BYTE> image = SyntheticFixtures::BuildGdfxImage(tree);
+        writeFile(path, image);
+    }
+
+    std::unique_ptr<XboxInternals::Iso::IsoImage> iso;
+    auto open = [&]()
+    {
+        iso = std::make_unique<XboxInternals::Iso::IsoImage>();
+        if (!iso->open(path.string()))
+            throw std::string("Bench: Error opening the synthetic disc image.\n");
+    };
+
+    report.Run(fixture, "open", 0, 1, open, [&]() { iso.reset(); });
+
+    // the listing is only read once per image
+    report.Run(fixture, "list", 0, fileCount + directoryCount, [&]() { iso->GetFileListing(); }, open);
+    if (!iso)
+        return;
+
+    fs::path extractDirectory;
+    report.Run(fixture, "extract", totalSize, fileCount, [&]()
+    {
+        if (!iso->extractAll(extractDirectory.string()))
+            throw std::string("Bench: Error extracting the synthetic disc image.\n");
+    }, [&]() { extractDirectory = freshDirectory(options, fixture); });
+
+    iso.reset();
+    fs::remove_all(extractDirectory);
+    fs::remove(path);
+}
+
+void printUsage()
+{
+    std::cerr << "Usage: XboxInternalsBench [--iterations N] [--filter TEXT] [--output PATH] [--work-dir PATH]\n"
+            "  --iterations N   times to run every operation, the fastest run is reported (default 3)\n"
+            "  --filter TEXT    only run fixtures whose name contains TEXT (stfs, fatx, gpd, xex, gdfx)\n"
+            "  --output PATH    write the JSON results to PATH instead of stdout\n"
+            "  --work-dir PATH  where fixtures and extracted files are written (default: a temp directory)\n";
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    BenchOptions options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--iterations" && hasValue)
+            options.iterations = (DWORD)std::strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--filter" && hasValue)
+            options.filter = argv[++i];
+        else if (arg == "--output" && hasValue)
+            options.outputPath = argv[++i];
+        else if (arg == "--work-dir" && hasValue)
+            options.workDirectory = argv[++i];
+        else
+        {
+            printUsage();
+            return (arg == "--help" || arg == "-h") ? 0 : 2;
+        }
+    }
+
+    bool ownWorkDirectory = options.workDirectory.empty();
+    if (ownWorkDirectory)
+    {
+        std::stringstream name;
+        name << "XboxInternalsBench-" << std::chrono::steady_clock::now().time_since_epoch().count();
+        options.workDirectory = fs::temp_directory_path() / name.str();
+    }
+    fs::create_directories(options.workDirectory);
+
+    BenchReport report(options.iterations);
+
+    try
+    {
+        // a level 0, level 1 and level 2 hash tree
+        benchStfs(report, options, "stfs-level0", 32, 0x3000);
+        benchStfs(report, options, "stfs-level1", 256, 0x8000);
+        benchStfs(report, options, "stfs-level2", 16, 0x800000);
+
+        benchFatx(report, options);
+        benchGpd(report, options);
+
+        benchXex(report, options, "xex-encrypted", 0x2000000, false);
+        benchXex(report, options, "xex-zero-compressed", 0x8000000, true);
+
+        benchGdfx(report, options);
+    }
+    catch (const std::string &error)
+    {
+        report.Fail("bench", "setup", error);
+    }
+    catch (const std::exception &error)
+    {
+        report.Fail("bench", "setup", error.what());
+    }
+
+    if (ownWorkDirectory)
+    {
+        std::error_code error;
+        fs::remove_all(options.workDirectory, error);
+    }
+
+    if (options.outputPath.empty())
+    {
+        report.WriteJson(std::cout);
+    }
+    else
+    {
+        std::ofstream out(options.outputPath, std::ios::trunc);
+        report.WriteJson(out);
+    }
+
+    return report.HasFailures() ? 1 : 0;
+}
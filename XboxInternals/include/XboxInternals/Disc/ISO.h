@@ -17,7 +17,8 @@ public:
     IsoImage();
     ~IsoImage();
 
-    bool open(const std::string& path);
+    // mapFile memory maps the image, which lets extraction Write straight out of the mapping
+    bool open(const std::string& path, bool mapFile = false);
     void close();
 
     const IsoInfo& info() const noexcept { return info_; }
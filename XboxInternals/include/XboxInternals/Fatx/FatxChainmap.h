@@ -0,0 +1,90 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include <XboxInternals/TypeDefinitions.h>
+#include <XboxInternals/Export.h>
+#include <XboxInternals/IO/BaseIO.h>
+
+// the chainmap is written back in pages of this size, only the pages that changed
+#define FATX_CHAINMAP_PAGE_SIZE 0x1000
+
+// the chainmap is read from the device in chunks of this size
+#define FATX_CHAINMAP_READ_SIZE 0x100000
+
+// a run of consecutive clusters
+struct FatxClusterRun
+{
+    DWORD start;
+    DWORD count;
+};
+
+// In-memory copy of a partition's chainmap (the FAT). It's read from the device the first time an entry is
+// needed, after that chains are followed without touching the device. Entries are kept in the big endian
+// layout they have on disk, so changed pages can be written back as they are.
+class XBOXINTERNALS_EXPORT FatxChainmap
+{
+public:
+    // the chainmap is size bytes at address on device, every entry is entrySize (2 or 4) bytes
+    FatxChainmap(BaseIO *device, UINT64 address, UINT64 size, BYTE entrySize);
+
+    FatxChainmap(const FatxChainmap&) = delete;
+    FatxChainmap &operator=(const FatxChainmap&) = delete;
+
+    // called with a piece of the chainmap, holding entryCount entries starting with the one for firstCluster
+    typedef std::function<void(const BYTE *entries, DWORD firstCluster, DWORD entryCount)> ChunkFunction;
+
+    // read the whole chainmap from the device if it isn't already, progress is called after every chunk
+    void Load(void(*progress)(void*, bool) = NULL, void *arg = NULL);
+
+    // hand the whole chainmap to chunkLoaded a chunk at a time, in order. If it isn't loaded yet each chunk
+    // is handed over as soon as it's been read, so it can be worked on while the next one is read.
+    void ForEachChunk(ChunkFunction chunkLoaded, void(*progress)(void*, bool) = NULL, void *arg = NULL);
+
+    // whether the chainmap has been read from the device
+    bool IsLoaded();
+
+    // get the entry for cluster, which is the next cluster in its chain or one of the markers
+    DWORD Get(DWORD cluster);
+
+    // set the entry for cluster, it's only written to the device on Flush
+    void Set(DWORD cluster, DWORD value);
+
+    // get the clusters in the chain that begins at startingCluster, in order
+    void ReadChain(DWORD startingCluster, std::vector<DWORD> &outChain);
+
+    // write every page that's been changed since the last flush back to the device
+    void Flush();
+
+    // forget what's been read, the next access reads it from the device again
+    void Invalidate();
+
+    // the amount of entries that fit in the chainmap
+    UINT64 EntryCount();
+
+    BYTE EntrySize();
+
+    // the raw big endian entries, loads the chainmap if needed
+    const BYTE *Data();
+
+    // append the runs of available entries among the entryCount entrySize byte entries to outRuns in order,
+    // entries holds the entries starting with the one for firstCluster. Whole blocks of entries are
+    // compared at once with SSE2, or AVX2 when the cpu has it.
+    static void FindFreeRuns(const BYTE *entries, BYTE entrySize, DWORD firstCluster, DWORD entryCount,
+            std::vector<FatxClusterRun> &outRuns);
+
+private:
+    // get the offset of cluster's entry, making sure it's within the chainmap
+    UINT64 entryOffset(DWORD cluster);
+
+    BaseIO *device;
+    UINT64 address;
+    UINT64 size;
+    BYTE entrySize;
+
+    bool loaded;
+    std::vector<BYTE> entries;
+    std::vector<bool> dirtyPages;
+    bool dirty;
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <XboxInternals/TypeDefinitions.h>
+#include <XboxInternals/Export.h>
+
+// Keeps track of a partition's free clusters. A bit per cluster says whether it's free, and the free
+// clusters are also indexed as runs both by where they start and by how long they are, so the longest
+// run is always at hand and a freed run joins up with its neighbours in O(log n).
+class XBOXINTERNALS_EXPORT FatxClusterAllocator
+{
+public:
+    FatxClusterAllocator();
+
+    // start over with clusters 1 to clusterCount, none of them free
+    void Reset(DWORD clusterCount);
+
+    // whether Reset has been called, the free clusters need to be found before anything can be allocated
+    bool IsBuilt();
+
+    // mark count clusters from start as free
+    void Free(DWORD start, DWORD count);
+
+    // mark the clusters as free, they can be in any order
+    void Free(std::vector<DWORD> clusters);
+
+    // take count free clusters, from the longest runs first so files end up in as few pieces as possible,
+    // the clusters are returned in the order they should be chained in
+    std::vector<DWORD> Allocate(DWORD count);
+
+    // whether cluster is free
+    bool IsFree(DWORD cluster);
+
+    // the amount of free clusters
+    UINT64 FreeCount();
+
+    // the amount of runs the free clusters are split into
+    size_t RunCount();
+
+    // the runs the free clusters are split into, start -> length in order of where they start
+    const std::map<DWORD, DWORD> &Runs();
+
+    // one bit per cluster, bit n of word n / 64 is set when cluster n is free
+    const std::vector<UINT64> &Bitmap();
+
+private:
+    void setBits(DWORD start, DWORD count, bool free);
+
+    void addRun(DWORD start, DWORD length);
+    void removeRun(std::map<DWORD, DWORD>::iterator run);
+
+    bool built;
+    DWORD clusterCount;
+    UINT64 freeCount;
+    std::vector<UINT64> bitmap;
+
+    // start -> length, and (length, start) so the last one is the longest run
+    std::map<DWORD, DWORD> runsByStart;
+    std::set<std::pair<DWORD, DWORD>> runsByLength;
+};
@@ -8,9 +8,13 @@
 
 #include <XboxInternals/Stfs/StfsDefinitions.h>
 #include <XboxInternals/Stfs/XContentHeader.h>
+#include <XboxInternals/Fatx/FatxChainmap.h>
+#include <XboxInternals/Fatx/FatxClusterAllocator.h>
 
 #include <vector>
 #include <iostream>
+#include <map>
+#include <memory>
 
 #define FAT32 4
 #define FAT16 2
@@ -95,6 +99,20 @@ struct FatxFileEntry
     std::vector<FatxFileEntry> cachedFiles;
     std::vector<DWORD> clusterChain;
     std::string path;
+
+    // changed by FatxIO::ChainChanged every time clusterChain is, so whatever was worked out from the chain
+    // can tell when it's out of date
+    UINT64 chainGeneration = 0;
+};
+
+// the header of an xcontent package on a partition, along with what its entry looked like when the header was
+// read so a package that's since been replaced isn't mistaken for it
+struct FatxCachedHeader
+{
+    DWORD startingCluster;
+    DWORD fileSize;
+    DWORD lastWriteDate;
+    std::vector<BYTE> data;
 };
 
 struct Partition
@@ -120,8 +138,15 @@ struct Partition
     DWORD clusterSize;
     UINT64 clusterStartingAddress;
     UINT64 chainmapSize;
+    std::unique_ptr<FatxChainmap> chainmap;
     UINT64 freeMemory;
-    std::vector<DWORD> freeClusters;
+    FatxClusterAllocator freeClusters;
+
+    // whether every directory has been read and the entries are in the drive's path index
+    bool indexed;
+
+    // entry address -> the header of the package in it, saved in snapshots
+    std::map<INT64, FatxCachedHeader> cachedHeaders;
 };
 
 enum FatxDirentAttributes
@@ -22,6 +22,9 @@
 #include <iterator>
 #include <cmath>
 #include <memory>
+#include <unordered_map>
+
+class BigFileIO;
 
 class XBOXINTERNALSSHARED_EXPORT FatxDrive
 {
@@ -47,6 +50,11 @@ public:
     // populate entry's cachedFiles vector (only if it's a directory)
     void GetChildFileEntries(FatxFileEntry *entry, void(*progress)(void*, bool) = NULL, void *arg = NULL);
 
+    // read every directory on the partition and index all of its entries by path, after that GetFileEntry
+    // and FileExists don't have to walk the directories. The directories on each level of the tree are
+    // read in large batches that the device can work on all at once, progress is called after every level.
+    void IndexPartition(Partition *part, void(*progress)(void*, bool) = NULL, void *arg = NULL);
+
     // populate entry's clusterChain with its cluster chain
     void ReadClusterChain(FatxFileEntry *entry);
 
@@ -69,6 +77,13 @@ public:
     // both SVOD and STFS packages have the same magic so this is necessary
     void GetFileEntryMagic(FatxFileEntry *entry);
 
+    // keep the header of the xcontent package in entry, it's saved in snapshots so the package doesn't have to be
+    // opened to list it the next time the drive is connected. It's dropped when the file is written to or removed.
+    void CacheContentHeader(FatxFileEntry *entry, std::vector<BYTE> header);
+
+    // get the header kept for the package in entry, nullptr if there isn't one or the entry has changed since
+    const std::vector<BYTE>* GetCachedContentHeader(FatxFileEntry *entry);
+
     // deletes the entry and all of it's children
     void RemoveFile(FatxFileEntry *entry, void(*progress)(void*) = NULL, void *arg = NULL);
 
@@ -93,7 +108,12 @@ public:
     // Write the entire contents of the drive to the local disk
     void CreateBackup(std::string outPath, void(*progress)(void*, DWORD, DWORD) = NULL, void *arg = NULL);
 
-    // re-Write the entire contents of the drive using a backup from the local disk
+    // Write only the parts of the drive that are in use to the local disk: everything outside of the
+    // partitions' data areas and every cluster that isn't free. The backup scales with the used space.
+    void CreateSparseBackup(std::string outPath, void(*progress)(void*, DWORD, DWORD) = NULL, void *arg = NULL);
+
+    // re-Write the contents of the drive using a backup from the local disk, either the whole drive or, for a
+    // sparse backup, just the parts of the drive it holds
     void RestoreFromBackup(std::string backupPath, void(*progress)(void*, DWORD, DWORD) = NULL, void *arg = NULL);
 
     // get the amount of free bytes on the device
@@ -108,6 +128,22 @@ public:
     // reload the entire drive, called after restoring
     void ReloadDrive();
 
+    // a name that stays the same every time the drive is connected, the serial number on hard drives and the
+    // device id on flash drives
+    std::string GetDriveIdentity();
+
+    // save the directories that have been read, the free clusters and the cached package headers of every
+    // partition to path, so the next time the drive is connected they don't have to be read from it again
+    void SaveSnapshot(std::string path);
+
+    // load a snapshot saved by SaveSnapshot, this has to be done before anything is read from the partitions.
+    // It's only used when it's for this drive, the partitions are laid out the same and each partition's
+    // chainmap and root directory are unchanged on the drive, otherwise false is returned and everything is
+    // read from the drive like usual. That only reads the root's clusters, so it's cheap, but a change that
+    // stays within the clusters a folder below the root already has (like a file being renamed, or rewritten
+    // in place by a console) isn't noticed.
+    bool LoadSnapshot(std::string path);
+
     // convert a cluster to an offset
     static INT64 ClusterToOffset(Partition *part, DWORD cluster);
 
@@ -142,8 +178,20 @@ private:
     // load all the profiles on the device
     void loadProfiles();
 
-    // inject a range of clustes into the chain
-    void injectRange(vector<DWORD> &clusters, Range &range);
+    // get the parts of the drive that aren't free clusters, in order
+    std::vector<Extent> usedExtents();
+
+    // Write the ranges held in a sparse backup back to the drive
+    void restoreSparseBackup(BigFileIO &backup, void(*progress)(void*, DWORD, DWORD), void *arg);
+
+    // read all of the directories that haven't been read yet, in batches
+    void readDirectoryBatch(const std::vector<FatxFileEntry*> &directories);
+
+    // add entry and everything under it to the path index
+    void indexEntries(FatxFileEntry *entry);
+
+    // add the entries in the directory to the path index
+    void indexChildren(FatxFileEntry *directory);
 
     // counts the largest amount of consecutive unset bits
     static BYTE cntlzw(DWORD x);
@@ -154,6 +202,9 @@ private:
     std::unique_ptr<BaseIO> io;
     std::vector<std::unique_ptr<Partition>> partitions;
     std::vector<FatxFileEntry*> profiles;
+
+    // full path -> entry, for the partitions that have been indexed
+    std::unordered_map<std::string, FatxFileEntry*> pathIndex;
     FatxDriveType type;
     bool onlyVerify;
 };
@@ -4,8 +4,8 @@
 #ifndef FATXHELPERS_H
 #define FATXHELPERS_H
 
-#define DOWN_TO_NEAREST_SECTOR(x) (0xFFFFFFFFFFFFFE00 & x)
-#define UP_TO_NEAREST_SECTOR(x) ((x + 0x1FF) & 0xFFFFFFFFFFFFFE00)
+#define DOWN_TO_NEAREST_SECTOR(x) (0xFFFFFFFFFFFFFE00 & (x))
+#define UP_TO_NEAREST_SECTOR(x) (((x) + 0x1FF) & 0xFFFFFFFFFFFFFE00)
 
 #include <XboxInternals/TypeDefinitions.h>
 #include <XboxInternals/Export.h>
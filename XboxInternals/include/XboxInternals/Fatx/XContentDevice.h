@@ -40,6 +40,8 @@ public:
     std::unique_ptr<std::vector<XContentDeviceSharedItem>> updates;
     std::unique_ptr<std::vector<XContentDeviceSharedItem>> systemItems;
 
+    // packages whose headers the drive has cached, like after loading a snapshot, aren't opened: their content
+    // only has the metadata and isn't an StfsPackage or SVOD
     bool LoadDevice(void(*progress)(void*, bool) = NULL, void *arg = NULL);
     FatxDriveType GetDeviceType();
     UINT64 GetFreeMemory(void(*progress)(void*, bool) = NULL, void *arg = NULL, bool finish = true);
@@ -61,6 +63,12 @@ private:
     bool ValidTitleID(std::string id);
     void GetAllContentItems(FatxFileEntry &titleFolder, vector<XContentDeviceItem> &itemsFound, void(*progress)(void*, bool) = NULL, void *arg = NULL);
     void CleanupSharedFiles(std::vector<XContentDeviceSharedItem> *category);
+
+    // get the metadata of the package in entry from the header the drive cached for it, nullptr if it hasn't
+    std::shared_ptr<IXContentHeader> CachedContent(FatxFileEntry *entry);
+
+    // have the drive keep the header of the package in entry, so it's saved in the drive's snapshot
+    void CacheContentHeader(FatxFileEntry *entry, IXContentHeader *content);
     std::string ToUpper(std::string str);
 };
 
@@ -55,7 +55,7 @@ public:
     SettingEntry GetSetting(UINT64 id);
 
 protected:
-    shared_ptr<FileIO> io;
+    shared_ptr<BaseIO> io;
 
 private:
     // Description: read the string entry passed in
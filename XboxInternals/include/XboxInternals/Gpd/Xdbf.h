@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <memory>
 #include <XboxInternals/IO/FileIO.h>
+#include <XboxInternals/IO/MappedFileIO.h>
 #include <XboxInternals/Gpd/XdbfDefinitions.h>
 #include <XboxInternals/Gpd/XdbfHelpers.h>
 
@@ -17,7 +18,8 @@ using std::shared_ptr;
 class XBOXINTERNALS_EXPORT Xdbf
 {
 public:
-    explicit Xdbf(const string &gpdPath);
+    // mapFile memory maps the gpd instead of opening it with a FileIO
+    explicit Xdbf(const string &gpdPath, bool mapFile = false);
     explicit Xdbf(shared_ptr<FileIO> io);
     explicit Xdbf(FileIO *io) : Xdbf(shared_ptr<FileIO>(io)) {}
     ~Xdbf() = default;
@@ -58,9 +60,17 @@ public:
 
     // Description: re-Write an entry
     void ReWriteEntry(XdbfEntry entry, BYTE *entryBuffer);
-    shared_ptr<FileIO> io;
+    shared_ptr<BaseIO> io;
 
 private:
+    Xdbf(shared_ptr<BaseIO> io, const string &filePath, bool mapFile);
+
+    // Description: open the file at the path with the kind of io this was created with
+    shared_ptr<BaseIO> openFile(const string &path);
+
+    string filePath;
+    bool mapFile;
+
     XdbfHeader header;
     vector<XdbfFreeMemEntry> freeMemory;
 
@@ -95,10 +105,10 @@ private:
     void WriteSyncData(SyncData *data);
 
     // Description: read an entry group from the table that has syncs
-    void readEntryGroup(XdbfEntryGroup *group, EntryType type);
+    void readEntryGroup(XdbfEntryGroup *group, EntryType type, BaseIO *table);
 
     // Description: read an entry group from the table that doesn't have syncs
-    void readEntryGroup(vector<XdbfEntry> *group, EntryType type);
+    void readEntryGroup(vector<XdbfEntry> *group, EntryType type, BaseIO *table);
 
     // Description: Write an entry group to the table that has syncs
     void WriteEntryGroup(XdbfEntryGroup *group);
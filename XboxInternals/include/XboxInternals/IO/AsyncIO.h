@@ -0,0 +1,82 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <XboxInternals/TypeDefinitions.h>
+#include <XboxInternals/Export.h>
+
+// the size reads get split into when submitting a large transfer, so several can be in flight at once
+#define ASYNC_READ_PIECE_SIZE 0x20000
+
+// the most reads that are kept in flight for one batch
+#define ASYNC_MAX_READS_IN_FLIGHT 32
+
+struct ReadRequest
+{
+    UINT64 offset;
+    BYTE *buffer;
+    DWORD length;
+};
+
+// a run of bytes somewhere in an io, a list of them describes data scattered across the io
+struct Extent
+{
+    UINT64 offset;
+    DWORD length;
+};
+
+// Handle to a batch of submitted reads. The buffers in the batch must stay alive until Wait() returns,
+// dropping the last copy of a handle without waiting blocks until the reads in flight have landed.
+class XBOXINTERNALS_EXPORT ReadCompletion
+{
+public:
+    class State;
+
+    // a completion for a batch that has already finished
+    ReadCompletion();
+    explicit ReadCompletion(std::shared_ptr<State> state);
+
+    // block until all the reads in the batch are done, throws the first error any of them hit
+    void Wait();
+
+    // check if all the reads in the batch are done without blocking
+    bool IsComplete();
+
+private:
+    std::shared_ptr<State> state;
+};
+
+// Submission backends for batches of positional reads.
+class XBOXINTERNALS_EXPORT AsyncIO
+{
+public:
+    // submit reads against a native file descriptor, through io_uring when the kernel supports it,
+    // otherwise each request is handed to readFunction on the worker pool
+    static ReadCompletion SubmitToDescriptor(int fd, std::vector<ReadRequest> requests,
+            std::function<void(const ReadRequest&)> readFunction);
+
+    // run each request through readFunction on the worker pool
+    static ReadCompletion SubmitToPool(std::vector<ReadRequest> requests,
+            std::function<void(const ReadRequest&)> readFunction);
+
+    // append requests for len bytes at offset, split into pieces of at most pieceSize bytes
+    static void AppendReadRequests(std::vector<ReadRequest> &requests, UINT64 offset, BYTE *buffer,
+            DWORD len, DWORD pieceSize = ASYNC_READ_PIECE_SIZE);
+
+    // append requests that read the extents back to back into buffer, adjacent extents are merged
+    // first so each contiguous run becomes as few reads as possible
+    static void AppendExtentRequests(std::vector<ReadRequest> &requests, const std::vector<Extent> &extents,
+            BYTE *buffer, DWORD pieceSize = ASYNC_READ_PIECE_SIZE);
+
+    // merge extents that directly follow each other into one
+    static std::vector<Extent> MergeExtents(const std::vector<Extent> &extents);
+
+    // split an extent list into consecutive batches of at most maxLength bytes each
+    static std::vector<std::vector<Extent>> SplitExtents(const std::vector<Extent> &extents,
+            DWORD maxLength);
+
+    // whether io_uring can be used on this system
+    static bool UringAvailable();
+};
@@ -2,7 +2,12 @@
 #define BASEIO_H
 
 #include <iostream>
+#include <span>
+#include <type_traits>
+#include <vector>
 #include <XboxInternals/TypeDefinitions.h>
+#include <XboxInternals/IO/AsyncIO.h>
+#include <XboxInternals/IO/ByteSwap.h>
 
 #include <XboxInternals/Export.h>
 
@@ -46,6 +51,64 @@ public:
     // Write len bytes from the current file at the current position into buffer
     virtual void WriteBytes(BYTE *buffer, DWORD len) = 0;
 
+    // read len bytes at offset into buffer without using or moving the current position,
+    // the default implementation seeks, reads, and then restores the position
+    virtual void ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len);
+
+    // Write len bytes from buffer at offset without using or moving the current position
+    virtual void WriteAt(UINT64 offset, BYTE *buffer, DWORD len);
+
+    // start a batch of positional reads and return a handle to wait on, the default implementation
+    // does the reads before returning, ios that can read concurrently keep several in flight
+    virtual ReadCompletion SubmitReads(std::vector<ReadRequest> requests);
+
+    // read each extent in order into dest back to back, extents that directly follow each other are
+    // read as one run and the runs are submitted as a single batch
+    virtual void ReadV(const std::vector<Extent> &extents, BYTE *dest);
+
+    // Write src back to back across the extents in order, adjacent extents are written as one run
+    virtual void WriteV(const std::vector<Extent> &extents, BYTE *src);
+
+    // positional read functions, decoded with the io's byte order
+    WORD ReadWordAt(UINT64 offset);
+    DWORD ReadDwordAt(UINT64 offset);
+
+    // read a whole array of 2, 4 or 8 byte values at once and decode them with the io's byte order
+    template <typename T>
+    void ReadArray(std::span<T> values)
+    {
+        ReadBytes(reinterpret_cast<BYTE*>(values.data()), (DWORD)values.size_bytes());
+        if (byteOrder == BigEndian)
+            swapArray(values.data(), values.size());
+    }
+
+    template <typename T>
+    void ReadArrayAt(UINT64 offset, std::span<T> values)
+    {
+        ReadAt(offset, reinterpret_cast<BYTE*>(values.data()), (DWORD)values.size_bytes());
+        if (byteOrder == BigEndian)
+            swapArray(values.data(), values.size());
+    }
+
+    // encode a whole array of 2, 4 or 8 byte values with the io's byte order and Write it at once
+    template <typename T>
+    void WriteArray(std::span<const T> values)
+    {
+        std::vector<T> encoded(values.begin(), values.end());
+        if (byteOrder == BigEndian)
+            swapArray(encoded.data(), encoded.size());
+        WriteBytes(reinterpret_cast<BYTE*>(encoded.data()), (DWORD)values.size_bytes());
+    }
+
+    template <typename T>
+    void WriteArrayAt(UINT64 offset, std::span<const T> values)
+    {
+        std::vector<T> encoded(values.begin(), values.end());
+        if (byteOrder == BigEndian)
+            swapArray(encoded.data(), encoded.size());
+        WriteAt(offset, reinterpret_cast<BYTE*>(encoded.data()), (DWORD)values.size_bytes());
+    }
+
     // all the read functions
     BYTE ReadByte();
     INT16 ReadInt16();
@@ -82,7 +145,19 @@ protected:
     EndianType byteOrder;
 
 private:
-    void reverseByteArray(BYTE *array, DWORD len);
+    template <typename T>
+    static void swapArray(T *values, size_t count)
+    {
+        static_assert(std::is_integral_v<T> && (sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8),
+                "BaseIO: arrays can only hold 2, 4 or 8 byte integers");
+
+        if constexpr (sizeof(T) == 2)
+            ByteSwap::SwapArray(reinterpret_cast<WORD*>(values), count);
+        else if constexpr (sizeof(T) == 4)
+            ByteSwap::SwapArray(reinterpret_cast<DWORD*>(values), count);
+        else
+            ByteSwap::SwapArray(reinterpret_cast<UINT64*>(values), count);
+    }
 };
 
 #endif //BASEIO_H
@@ -4,6 +4,7 @@
 #include <string>
 
 #include <XboxInternals/IO/BaseIO.h>
+#include <XboxInternals/Export.h>
 
 #ifdef _WIN32
     #ifndef WIN32_LEAN_AND_MEAN
@@ -13,33 +14,50 @@
         #define NOMINMAX
     #endif
     #include <windows.h>
-#else
-    #include <fstream>
 #endif
 
 // Cross-platform large file I/O
-// Uses native Windows API on Windows, falls back to fstream on other platforms
-class BigFileIO : public BaseIO
+// Uses the native Windows API on Windows and a plain descriptor with pread/pwrite everywhere else. Every
+// read and write is positional, the position is kept here, so ReadAt and WriteAt can be called from many threads.
+class XBOXINTERNALS_EXPORT BigFileIO : public BaseIO
 {
 public:
-    BigFileIO(std::string filePath, bool create = false);
+    // a file opened read only can't be written, but it can be opened while something else has it open for writing
+    BigFileIO(std::string filePath, bool create = false, bool readOnly = false);
     ~BigFileIO();
 
     void ReadBytes(BYTE *outBuffer, DWORD len) override;
     void WriteBytes(BYTE *buffer, DWORD len) override;
+    void ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len) override;
+    void WriteAt(UINT64 offset, BYTE *buffer, DWORD len) override;
     UINT64 Length() override;
     UINT64 GetPosition() override;
     void SetPosition(UINT64 position, std::ios_base::seekdir dir = std::ios_base::beg) override;
     void Close() override;
     void Flush() override;
 
+    // reads are kept in flight with io_uring or the worker pool where positional io is available
+    ReadCompletion SubmitReads(std::vector<ReadRequest> requests) override;
+
+    // hint that the file is going to be read or written front to back
+    void AdviseSequential();
+
+    // reserve space for a file that's going to grow to length bytes, without changing its length
+    void Preallocate(UINT64 reservedLength);
+
+    // write back the range and drop it from the os cache, so streaming through a huge file doesn't
+    // push everything else out of memory
+    void DropCache(UINT64 offset, UINT64 len);
+
 private:
     std::string filePath;
 
+    UINT64 pos;
+
 #ifdef _WIN32
     HANDLE hFile;
 #else
-    std::unique_ptr<std::fstream> fstr;
+    int fd;
     UINT64 length;
 #endif
 };
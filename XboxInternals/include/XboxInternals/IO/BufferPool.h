@@ -0,0 +1,93 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include <XboxInternals/TypeDefinitions.h>
+#include <XboxInternals/Export.h>
+
+// every buffer is aligned to this, which is enough for transfers that bypass the os cache
+#define BUFFERPOOL_ALIGNMENT 0x1000
+
+// buffers come in power of two size classes from the smallest to the largest size, anything bigger
+// is allocated exactly and freed as soon as it's returned
+#define BUFFERPOOL_MIN_CLASS_SIZE 0x10000
+#define BUFFERPOOL_MAX_CLASS_SIZE 0x800000
+#define BUFFERPOOL_CLASS_COUNT 8
+
+// the most memory the free buffers of a pool can hold on to
+#define BUFFERPOOL_DEFAULT_MAX_CACHED_BYTES 0x4000000
+
+class BufferPool;
+
+// A buffer borrowed from a pool, it goes back to the pool when the lease is destroyed. The contents of a
+// new lease are whatever the last user left in it.
+class XBOXINTERNALS_EXPORT BufferLease
+{
+public:
+    BufferLease();
+    ~BufferLease();
+
+    BufferLease(BufferLease &&other) noexcept;
+    BufferLease &operator=(BufferLease &&other) noexcept;
+
+    BufferLease(const BufferLease&) = delete;
+    BufferLease &operator=(const BufferLease&) = delete;
+
+    BYTE *Data() const;
+
+    // the size that was asked for, the buffer behind it may be bigger
+    DWORD Size() const;
+
+    // give the buffer back early
+    void Release();
+
+private:
+    friend class BufferPool;
+    BufferLease(BufferPool *pool, BYTE *data, DWORD size, DWORD capacity);
+
+    BufferPool *pool;
+    BYTE *data;
+    DWORD size;
+    DWORD capacity;
+};
+
+// Thread safe pool of page aligned buffers, so bulk transfers don't allocate and fault in a fresh
+// buffer on every call.
+class XBOXINTERNALS_EXPORT BufferPool
+{
+public:
+    explicit BufferPool(UINT64 maxCachedBytes = BUFFERPOOL_DEFAULT_MAX_CACHED_BYTES);
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool &operator=(const BufferPool&) = delete;
+
+    // the pool the library uses, it lives until the process exits
+    static BufferPool &Shared();
+
+    // borrow a buffer of at least size bytes
+    BufferLease Acquire(DWORD size);
+
+    // free all the buffers that aren't leased out
+    void Trim();
+
+    // the amount of memory held by buffers that aren't leased out
+    UINT64 CachedBytes();
+
+private:
+    friend class BufferLease;
+
+    void release(BYTE *data, DWORD capacity);
+
+    // get the index of the smallest class that fits size, or -1 if it's bigger than all of them
+    static int sizeClass(DWORD size);
+
+    static BYTE *allocate(DWORD size);
+    static void free(BYTE *data);
+
+    std::mutex mutex;
+    std::vector<BYTE*> freeBuffers[BUFFERPOOL_CLASS_COUNT];
+    UINT64 cachedBytes;
+    UINT64 maxCachedBytes;
+};
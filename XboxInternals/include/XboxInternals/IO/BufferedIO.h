@@ -0,0 +1,65 @@
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include <XboxInternals/IO/BaseIO.h>
+#include <XboxInternals/Export.h>
+
+// size of the pages writes are gathered into
+#define BUFFEREDIO_PAGE_SIZE 0x1000
+
+// once this many pages are dirty they're all written back
+#define BUFFEREDIO_MAX_DIRTY_PAGES 0x400
+
+// writes at least this big skip the pages and go straight to the io
+#define BUFFEREDIO_WRITE_THROUGH_SIZE 0x10000
+
+// Gathers small writes to another io into dirty pages and writes them back sorted by offset, so runs
+// of field sized writes become a few large ones. Reads are served from the dirty pages where they
+// overlap. The io isn't owned, but it's closed along with this one.
+class XBOXINTERNALS_EXPORT BufferedIO : public BaseIO
+{
+public:
+    BufferedIO(BaseIO *io);
+    ~BufferedIO() override;
+
+    void SetPosition(UINT64 position, std::ios_base::seekdir dir = std::ios_base::beg) override;
+    UINT64 GetPosition() override;
+
+    // the length including anything written past the end that hasn't been written back yet
+    UINT64 Length() override;
+
+    void ReadBytes(BYTE *outBuffer, DWORD len) override;
+    void WriteBytes(BYTE *buffer, DWORD len) override;
+
+    void ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len) override;
+    void WriteAt(UINT64 offset, BYTE *buffer, DWORD len) override;
+
+    // the dirty pages are written back first so the io can read everything on its own
+    ReadCompletion SubmitReads(std::vector<ReadRequest> requests) override;
+
+    // Write the dirty pages back to the io without flushing it
+    void WriteBack();
+
+    // Write the dirty pages back and flush the io
+    void Flush() override;
+
+    void Close() override;
+
+    // get the amount of pages waiting to be written back
+    size_t GetDirtyPageCount();
+
+private:
+    // get the dirty page starting at pageOffset, a page that isn't dirty yet is loaded from the io
+    // unless the caller is about to overwrite all of it
+    std::vector<BYTE> &getPage(UINT64 pageOffset, bool overwritingPage);
+
+    BaseIO *io;
+    std::map<UINT64, std::vector<BYTE>> pages;
+    UINT64 pos;
+
+    // the length with everything written so far, and the length of what the io actually holds
+    UINT64 length;
+    UINT64 ioLength;
+};
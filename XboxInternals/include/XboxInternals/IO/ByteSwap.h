@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <XboxInternals/TypeDefinitions.h>
+#include <XboxInternals/Export.h>
+
+// Byte order reversal for single values and whole arrays. The array versions use SSSE3 or AVX2
+// shuffles when the cpu has them.
+class XBOXINTERNALS_EXPORT ByteSwap
+{
+public:
+    static WORD Swap(WORD value);
+    static DWORD Swap(DWORD value);
+    static UINT64 Swap(UINT64 value);
+
+    // reverse the bytes of each of the count values in place
+    static void SwapArray(WORD *values, size_t count);
+    static void SwapArray(DWORD *values, size_t count);
+    static void SwapArray(UINT64 *values, size_t count);
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+
+#include <XboxInternals/TypeDefinitions.h>
+#include <XboxInternals/Export.h>
+
+class OperationContext;
+
+// size of each buffer passed between the stages, and how many of them are in use at once
+#define COPYPIPELINE_DEFAULT_BUFFER_SIZE 0x100000
+#define COPYPIPELINE_DEFAULT_BUFFER_COUNT 4
+
+// Copies data in chunks through three stages: a reader thread fills buffers, the calling thread runs
+// the optional transform on each one, and a writer thread writes them out. The stages hand buffers to
+// each other through queues, and a written buffer is recycled for the reader, so at most the buffer
+// count worth of data is ever in memory. Chunks go through every stage in order. The buffers are
+// borrowed from the shared BufferPool for each run.
+class XBOXINTERNALS_EXPORT CopyPipeline
+{
+public:
+    // fill buffer with chunk number index and return its length, returning 0 ends the copy
+    typedef std::function<DWORD(UINT64 index, BYTE *buffer)> ReadFunction;
+
+    // work on the chunk in place before it's written, e.g. decrypting it
+    typedef std::function<void(UINT64 index, BYTE *buffer, DWORD len)> TransformFunction;
+
+    // write the chunk wherever it goes
+    typedef std::function<void(UINT64 index, const BYTE *buffer, DWORD len)> WriteFunction;
+
+    // called with the amount of bytes written so far
+    typedef std::function<void(UINT64 bytesWritten)> ProgressFunction;
+
+    explicit CopyPipeline(DWORD bufferSize = COPYPIPELINE_DEFAULT_BUFFER_SIZE,
+            DWORD bufferCount = COPYPIPELINE_DEFAULT_BUFFER_COUNT);
+
+    CopyPipeline(const CopyPipeline&) = delete;
+    CopyPipeline &operator=(const CopyPipeline&) = delete;
+
+    // the size of the buffers the reader is handed
+    DWORD BufferSize();
+
+    void SetTransform(TransformFunction transform);
+
+    // the progress function is always called on the thread that called Run, it's safe to update a ui from it
+    void SetProgress(ProgressFunction progress);
+
+    // count the bytes written towards context, and cancel the copy once it's cancelled
+    void SetContext(OperationContext *context);
+
+    // run the copy until the reader runs out of chunks, returns false if it was cancelled. The first error
+    // any of the stages throws stops the copy and is thrown from here.
+    bool Run(ReadFunction reader, WriteFunction writer);
+
+    // stop the copy as soon as the chunks being worked on are done, can be called from any thread
+    void Cancel();
+    bool IsCancelled();
+
+    // running totals, can be polled from any thread while the copy runs
+    UINT64 BytesRead();
+    UINT64 BytesWritten();
+
+private:
+    struct Chunk
+    {
+        UINT64 index;
+        BYTE *buffer;
+
+        // a chunk with a length of 0 marks the end of the copy
+        DWORD length;
+    };
+
+    // wait for a chunk, returns false if the copy stopped first
+    bool pop(std::deque<Chunk> &queue, Chunk &chunk);
+    void push(std::deque<Chunk> &queue, const Chunk &chunk);
+
+    // stop the copy because of the exception being handled
+    void fail();
+
+    void readerLoop(ReadFunction &reader);
+    void writerLoop(WriteFunction &writer);
+
+    DWORD bufferSize;
+    DWORD bufferCount;
+
+    TransformFunction transform;
+    ProgressFunction progress;
+    OperationContext *context;
+
+    // the queues between the stages, all guarded by the mutex
+    std::deque<Chunk> freeChunks;
+    std::deque<Chunk> readChunks;
+    std::deque<Chunk> transformedChunks;
+    bool stopped;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable changed;
+
+    std::atomic<bool> cancelled;
+    std::atomic<UINT64> bytesRead;
+    std::atomic<UINT64> bytesWritten;
+};
@@ -6,6 +6,18 @@
 
 #define FAT_SECTOR_SIZE 0x200
 
+// default page cache geometry, 64 pages of 64KB
+#define DEVICEIO_DEFAULT_CACHE_PAGE_SIZE 0x10000
+#define DEVICEIO_DEFAULT_CACHE_PAGE_COUNT 64
+
+// bulk transfers stream through this many aligned buffers of this size
+#define DEVICEIO_BULK_BUFFER_SIZE 0x800000
+#define DEVICEIO_BULK_BUFFER_COUNT 3
+
+// bulk transfers have to start on this boundary, and their buffers are aligned to it
+#define DEVICEIO_BULK_ALIGNMENT 0x1000
+
+#include <functional>
 #include <memory>
 
 #include <XboxInternals/IO/BaseIO.h>
@@ -24,6 +36,36 @@ public:
 
     void WriteBytes(BYTE *buffer, DWORD len);
 
+    // positional io, doesn't touch the current position
+    void ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len);
+
+    void WriteAt(UINT64 offset, BYTE *buffer, DWORD len);
+
+    // keeps the reads in flight with io_uring where available, or on the worker pool
+    ReadCompletion SubmitReads(std::vector<ReadRequest> requests);
+
+    // resize the page cache, reads smaller than a page are served from it, a page count of 0 disables it
+    void SetCacheSize(DWORD pageSize, DWORD pageCount);
+
+    // drop everything in the page cache
+    void ClearCache();
+
+    // Stream len bytes starting at offset past the os cache (O_DIRECT on linux, F_NOCACHE on macOS), handing
+    // each buffer to consumer in order while the next ones are being read. offset must be page aligned.
+    void BulkRead(UINT64 offset, UINT64 len, std::function<void(const BYTE*, DWORD)> consumer);
+
+    // Stream len bytes to offset past the os cache, producer fills each buffer in order while the ones
+    // before it are being written. offset must be page aligned.
+    void BulkWrite(UINT64 offset, UINT64 len, std::function<void(BYTE*, DWORD)> producer);
+
+    // prefetch ahead of sequential ReadBytes calls into a ring of segments, a segment count of 0 turns it off
+    // again. It's off by default, it only pays off for callers that stream through a lot of data.
+    void SetReadahead(DWORD segmentSize, DWORD segmentCount);
+
+    // page cache statistics
+    UINT64 GetCacheHits();
+    UINT64 GetCacheMisses();
+
     void SetPosition(UINT64 address, std::ios_base::seekdir dir = std::ios_base::beg);
 
     UINT64 GetPosition();
@@ -45,8 +87,6 @@ private:
     std::string yolo;
 
     UINT64 pos;
-    BYTE lastReadData[FAT_SECTOR_SIZE];
-    UINT64 lastReadOffset;
 };
 
 #endif // DEVICEIO_H
@@ -4,6 +4,7 @@
 #include <XboxInternals/IO/DeviceIO.h>
 #include <XboxInternals/IO/FileIO.h>
 #include <XboxInternals/IO/MemoryIO.h>
+#include <XboxInternals/IO/OperationContext.h>
 #include "../Fatx/FatxConstants.h"
 #include "../Cryptography/XeCrypt.h"
 
@@ -22,7 +23,7 @@ class XBOXINTERNALS_EXPORT FatxIO : public BaseIO
 public:
     FatxFileEntry *entry;
 
-    FatxIO(DeviceIO *device, FatxFileEntry *entry);
+    FatxIO(BaseIO *device, FatxFileEntry *entry);
     virtual ~FatxIO();
 
     // get the current file entry
@@ -37,17 +38,24 @@ public:
     // returns the length
     UINT64 Length();
 
-    // get the drive's current position
+    // get where the current position is on the drive
     UINT64 GetDrivePosition();
 
-    // read bytes at the current position
+    // read bytes at the current position, one device read per run of consecutive clusters
     void ReadBytes(BYTE *outBuffer, DWORD len);
 
-    // Write bytes at the current position
+    // Write bytes at the current position, one device write per run of consecutive clusters
     void WriteBytes(BYTE *buffer, DWORD len);
 
-    // save the file to disk
-    void SaveFile(std::string savePath, void(*progress)(void*, DWORD, DWORD) = NULL, void *arg = NULL);
+    // read bytes at an offset in the file, one device read per run of consecutive clusters
+    void ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len);
+
+    // Write bytes at an offset in the file, writes that grow the file go through WriteBytes
+    void WriteAt(UINT64 offset, BYTE *buffer, DWORD len);
+
+    // save the file to disk, if context gets cancelled the copy stops and nothing is left at savePath
+    void SaveFile(std::string savePath, void(*progress)(void*, DWORD, DWORD) = NULL, void *arg = NULL,
+            OperationContext *context = NULL);
 
     // does nothing, required implementation
     void Flush();
@@ -63,13 +71,16 @@ public:
 
     // replace the file with one from a local disk
     void ReplaceFile(std::string sourcePath, void(*progress)(void*, DWORD, DWORD) = NULL,
-            void *arg = NULL);
+            void *arg = NULL, OperationContext *context = NULL);
 
     // convert a cluster to an offset
     static UINT64 ClusterToOffset(Partition *part, DWORD cluster);
 
+    // give entry a new chain generation, this has to be called after every change to its cluster chain
+    static void ChainChanged(FatxFileEntry *entry);
+
     // sets all the clusters equal to value
-    static void SetAllClusters(DeviceIO *device, Partition *part, std::vector<DWORD> &clusters,
+    static void SetAllClusters(BaseIO *device, Partition *part, std::vector<DWORD> &clusters,
             DWORD value);
 
     // get the ranges of consecutive numbers in list where it's sorted
@@ -83,12 +94,28 @@ private:
     // Writes the cluster chain (and links them correctly) starting from startingCluster
     void WriteClusterChain(Partition *part, DWORD startingCluster, std::vector<DWORD> clusterChain);
 
-    DeviceIO *device;
+    // get where the file's data lives on the drive, one extent per run of consecutive clusters
+    std::vector<Extent> fileExtents();
+
+    // get the drive offset of a file offset, and how many of len bytes after it are consecutive on the drive
+    DWORD getConsecutiveRun(UINT64 offset, DWORD len, UINT64 *driveOffset);
+
+    // read or Write len bytes at offset in the file, one device call per run of consecutive clusters
+    void transferRuns(UINT64 offset, BYTE *buffer, DWORD len, bool write);
+
+    // work out the runs of consecutive clusters in the chain again if it's changed
+    void updateChainExtents();
+
+    BaseIO *device;
     UINT64 pos;
-    DWORD maxReadConsecutive;
-};
 
-bool compareRanges(Range a, Range b);
+    // the runs of consecutive clusters in the whole chain, and the file offset each one starts at
+    std::vector<Extent> chainExtents;
+    std::vector<UINT64> chainExtentStarts;
+
+    // the chain generation the runs were worked out for
+    UINT64 extentsGeneration;
+};
 
 #endif // FATXIO_H
 
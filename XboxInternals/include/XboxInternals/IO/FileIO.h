@@ -7,6 +7,7 @@
 #include <string.h>
 #include <XboxInternals/TypeDefinitions.h>
 #include <XboxInternals/IO/BaseIO.h>
+#include <XboxInternals/IO/Readahead.h>
 
 using std::string;
 using std::wstring;
@@ -25,6 +26,35 @@ public:
     void ReadBytes(BYTE *outBuffer, DWORD len);
     void WriteBytes(BYTE *buffer, DWORD len);
 
+    // positional io, backed by pread/pwrite where available
+    void ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len);
+    void WriteAt(UINT64 offset, BYTE *buffer, DWORD len);
+
+    // reads are kept in flight with io_uring or the worker pool where positional io is available
+    ReadCompletion SubmitReads(std::vector<ReadRequest> requests);
+
+    // prefetch ahead of sequential ReadBytes calls into a ring of segments, a segment count of 0 turns it off
+    // again. It's off by default, it only pays off for callers that stream through a lot of data.
+    void SetReadahead(DWORD segmentSize, DWORD segmentCount);
+
+    // turns readahead on for as long as it's alive and then puts back whatever was set before, so a throw
+    // part way through a stream can't leave it on. A null file is ignored.
+    class XBOXINTERNALS_EXPORT ReadaheadScope
+    {
+    public:
+        explicit ReadaheadScope(FileIO *file, DWORD segmentSize = READAHEAD_DEFAULT_SEGMENT_SIZE,
+                DWORD segmentCount = READAHEAD_DEFAULT_SEGMENT_COUNT);
+        ~ReadaheadScope();
+
+        ReadaheadScope(const ReadaheadScope&) = delete;
+        ReadaheadScope &operator=(const ReadaheadScope&) = delete;
+
+    private:
+        FileIO *file;
+        DWORD previousSegmentSize;
+        DWORD previousSegmentCount;
+    };
+
     void Close();
     void Flush();
 
@@ -36,8 +66,25 @@ private:
     EndianType endian;
     UINT64 length;
     void ReadBytesWithChecks(void *buffer, INT32 size);
+
+    // read up to len bytes through the descriptor, stopping short at the end of the file
+    DWORD readUpTo(UINT64 offset, BYTE *outBuffer, DWORD len);
+
     std::unique_ptr<fstream> fstr;
     const string filePath;
+
+    // native descriptor used for positional io, -1 when it's not available
+    int fd;
+
+    // set when the stream may be holding writes that the descriptor can't see yet
+    bool streamDirty;
+
+    // prefetches long sequential runs of reads, only available with a descriptor
+    std::unique_ptr<Readahead> readahead;
+
+    // what readahead was last set to, even when there was no descriptor to prefetch with
+    DWORD readaheadSegmentSize;
+    DWORD readaheadSegmentCount;
 };
 
 
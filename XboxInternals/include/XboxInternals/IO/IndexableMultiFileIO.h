@@ -1,14 +1,19 @@
 #pragma once
 
 #include <ios>
+#include <list>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <XboxInternals/Export.h>
 #include <XboxInternals/TypeDefinitions.h>
 #include <XboxInternals/IO/BaseIO.h>
 
+// the most parts kept open at once by default
+#define INDEXABLEMULTIFILEIO_DEFAULT_MAX_OPEN_FILES 64
+
 // Treats a directory of files as a single seekable data source with index support.
 class XBOXINTERNALS_EXPORT IndexableMultiFileIO : public BaseIO {
 public:
@@ -24,6 +29,12 @@ public:
     void ReadBytes(BYTE *outBuffer, DWORD len) override;
     void WriteBytes(BYTE *buffer, DWORD len) override;
 
+    // Read or write within a single file, the file is switched to (and the position moved into it) if it isn't the current one.
+    using BaseIO::ReadAt;
+    using BaseIO::WriteAt;
+    void ReadAt(DWORD addressInFile, DWORD fileIndex, BYTE *outBuffer, DWORD len);
+    void WriteAt(DWORD addressInFile, DWORD fileIndex, BYTE *buffer, DWORD len);
+
     void Close() override;
     void Flush() override;
 
@@ -32,6 +43,28 @@ public:
     DWORD FileCount();
     DWORD CurrentFileLength();
 
+    // set how many parts are kept open, the least recently used ones are closed to make room
+    void SetMaxOpenFiles(DWORD count);
+
+    // prefetch ahead of sequential reads in every part, for callers that stream through all of them
+    void SetReadahead(bool enabled);
+
+    // turns readahead on for as long as it's alive and then puts back whatever was set before, so a throw
+    // part way through can't leave it on
+    class XBOXINTERNALS_EXPORT ReadaheadScope
+    {
+    public:
+        explicit ReadaheadScope(IndexableMultiFileIO *io);
+        ~ReadaheadScope();
+
+        ReadaheadScope(const ReadaheadScope&) = delete;
+        ReadaheadScope &operator=(const ReadaheadScope&) = delete;
+
+    private:
+        IndexableMultiFileIO *io;
+        bool previous;
+    };
+
     // Unused BaseIO overrides required by the interface.
     void SetPosition(UINT64 position, std::ios_base::seekdir dir = std::ios_base::beg) override;
     UINT64 GetPosition() override;
@@ -40,9 +73,30 @@ protected:
     DWORD addressInFile;
     DWORD fileIndex;
 
-    std::unique_ptr<BaseIO> currentIO;
+    // the open part at fileIndex, owned by the pool
+    BaseIO *currentIO;
     std::vector<std::string> files;
 
     virtual void loadDirectories(std::string path) = 0;
     virtual std::unique_ptr<BaseIO> openFile(std::string path) = 0;
+
+    // turn readahead on or off for an open part, parts that can't prefetch ignore it
+    virtual void setReadahead(BaseIO *file, bool enabled);
+
+    // get the part at the index out of the pool, opening it if it isn't already
+    BaseIO *acquireFile(DWORD index);
+
+private:
+    struct OpenFile
+    {
+        std::unique_ptr<BaseIO> io;
+        DWORD length;
+        std::list<DWORD>::iterator lruPosition;
+    };
+
+    // open parts keyed by their index, most recently used at the front of lru
+    std::unordered_map<DWORD, OpenFile> openFiles;
+    std::list<DWORD> lru;
+    DWORD maxOpenFiles;
+    bool readahead;
 };
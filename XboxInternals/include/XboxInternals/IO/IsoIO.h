@@ -19,6 +19,9 @@ public:
     void ReadBytes(BYTE *outBuffer, DWORD len) override;
     void WriteBytes(BYTE *buffer, DWORD len) override;
 
+    void ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len) override;
+    void WriteAt(UINT64 offset, BYTE *buffer, DWORD len) override;
+
     UINT64 GetPosition() override;
     void SetPosition(UINT64 position, std::ios_base::seekdir dir = std::ios_base::beg) override;
 
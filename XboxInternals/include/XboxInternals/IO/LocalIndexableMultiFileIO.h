@@ -14,4 +14,5 @@ public:
 protected:
     void loadDirectories(std::string path) override;
     std::unique_ptr<BaseIO> openFile(std::string path) override;
+    void setReadahead(BaseIO *file, bool enabled) override;
 };
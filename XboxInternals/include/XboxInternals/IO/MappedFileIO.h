@@ -0,0 +1,63 @@
+#pragma once
+
+#include <memory>
+#include <span>
+#include <string>
+
+#include <XboxInternals/IO/BaseIO.h>
+#include <XboxInternals/Export.h>
+
+// the least a file is grown by when a write runs past the end of the mapping
+#define MAPPEDFILEIO_MIN_GROWTH 0x100000
+
+// Memory mapped local file. Reads and writes are copies in and out of the mapping, and View() hands
+// out the mapped bytes directly so parsers can walk headers and hash tables without copying them.
+class XBOXINTERNALS_EXPORT MappedFileIO : public BaseIO
+{
+public:
+    MappedFileIO(std::string path, bool readOnly = false);
+    ~MappedFileIO() override;
+
+    // get len bytes at offset straight out of the mapping, the view is only valid until the file grows or is closed
+    std::span<const BYTE> View(UINT64 offset, UINT64 len);
+
+    void SetPosition(UINT64 position, std::ios_base::seekdir dir = std::ios_base::beg) override;
+    UINT64 GetPosition() override;
+    UINT64 Length() override;
+
+    void ReadBytes(BYTE *outBuffer, DWORD len) override;
+    void WriteBytes(BYTE *buffer, DWORD len) override;
+
+    void ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len) override;
+    void WriteAt(UINT64 offset, BYTE *buffer, DWORD len) override;
+
+    // write the dirty pages back to the file
+    void Flush() override;
+    void Close() override;
+
+    std::string GetFilePath();
+
+private:
+    // map the first newMappedLength bytes of the file, a zero length file isn't mapped at all
+    void map(UINT64 newMappedLength);
+    void unmap();
+
+    // make the file at least newLength bytes long. The file on disk and the mapping are grown by at least half
+    // again, so a file written front to back is only remapped a handful of times, and the extra space is cut off
+    // when the file is closed.
+    void grow(UINT64 newLength);
+
+    // set the size of the file on disk
+    void resize(UINT64 newLength);
+
+    class Impl;
+    std::unique_ptr<Impl> impl;
+
+    std::string filePath;
+    bool readOnly;
+
+    BYTE *data;
+    UINT64 length;
+    UINT64 mappedLength;
+    UINT64 pos;
+};
@@ -3,12 +3,22 @@
 
 #include <XboxInternals/TypeDefinitions.h>
 #include <string.h>
+#include <string>
+#include <vector>
 #include <XboxInternals/IO/BaseIO.h>
 
 class XBOXINTERNALS_EXPORT MemoryIO : public BaseIO
 {
 public:
+    // wrap a fixed size buffer owned by the caller
     MemoryIO(BYTE *data, size_t length);
+
+    // own a buffer that grows whenever something is written past the end, starting out with data
+    explicit MemoryIO(std::vector<BYTE> data = std::vector<BYTE>());
+
+    // own a growable copy of everything in source
+    explicit MemoryIO(BaseIO *source);
+
     virtual ~MemoryIO();
 
     void SetPosition(UINT64 pos, std::ios_base::seekdir dir = std::ios_base::beg);
@@ -18,16 +28,35 @@ public:
     void ReadBytes(BYTE *outBuffer, DWORD len);
     void WriteBytes(BYTE *buffer, DWORD len);
 
+    void ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len);
+    void WriteAt(UINT64 offset, BYTE *buffer, DWORD len);
+
     void Close();
     void Flush();
 
+    // whether writes past the end grow the buffer
+    bool IsGrowable();
+
+    // get the contents, only valid until the next Write that grows the buffer
+    BYTE *GetBuffer();
+
+    // write the whole contents to the start of io
+    void SaveToIO(BaseIO *io);
+
+    // write the whole contents to a file on the local disk, replacing it if it exists
+    void SaveToFile(std::string path);
+
 private:
+    // make room for the range, growing the buffer if it's allowed to
+    void reserveRange(UINT64 offset, DWORD len);
+
+    std::vector<BYTE> ownedMemory;
+    bool growable;
+
     BYTE *memory;
-    size_t length;
+    UINT64 length;
 
-    DWORD pos;
+    UINT64 pos;
 };
 
 #endif // MEMORYSTREAM_H
-
-
@@ -35,7 +35,11 @@ public:
     // Write len bytes from the current file at the current position into buffer
     void WriteBytes(BYTE *buffer, DWORD len);
 
-    // flushes the stream
+    // positional io, a request crossing from one file into the next is split between them
+    void ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len);
+    void WriteAt(UINT64 offset, BYTE *buffer, DWORD len);
+
+    // flushes all the files
     void Flush();
 
     // closes all the files
@@ -44,10 +48,19 @@ public:
 private:
     UINT64 pos, lengthOfFiles;
     bool isClosed;
-    DWORD currentIOIndex;
     std::vector<std::unique_ptr<BaseIO>> files;
 
+    // where each file starts in the joined address space, with the total length at the end
+    std::vector<UINT64> fileOffsets;
+
     void calculateLengthOfAllFiles();
+
+    // get the index of the file holding the offset, which must be before the end
+    size_t fileIndexAt(UINT64 offset);
+
+    // split the range into the pieces that fall in each file and hand each one to ioFunction
+    template <typename Function>
+    void forEachPiece(UINT64 offset, BYTE *buffer, DWORD len, Function ioFunction);
 };
 
 #endif // MULTIFILEIO_H
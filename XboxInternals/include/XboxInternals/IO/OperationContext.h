@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+
+#include <XboxInternals/TypeDefinitions.h>
+#include <XboxInternals/Export.h>
+
+// Shared between a long running operation and whoever started it. The operation bumps the counters as it
+// goes and checks whether it's been cancelled, the caller polls them from any thread, like from a ui timer.
+// Nothing is called back, so reporting costs a few atomic adds no matter how often it happens.
+class XBOXINTERNALS_EXPORT OperationContext
+{
+public:
+    OperationContext();
+
+    OperationContext(const OperationContext&) = delete;
+    OperationContext &operator=(const OperationContext&) = delete;
+
+    // set what the whole operation adds up to, when the caller knows it up front
+    void SetTotals(UINT64 bytes, UINT64 items);
+
+    // start on the next item, like a file, itemBytes is its size
+    void BeginItem(UINT64 itemBytes);
+
+    // count another item as done
+    void EndItem();
+
+    // count bytes towards the current item and the whole operation
+    void AddBytes(UINT64 bytes);
+
+    UINT64 BytesDone();
+    UINT64 BytesTotal();
+    UINT64 ItemsDone();
+    UINT64 ItemsTotal();
+    UINT64 ItemBytesDone();
+    UINT64 ItemBytesTotal();
+
+    // ask the operation to stop, can be called from any thread
+    void Cancel();
+    bool IsCancelled();
+
+    // throw if the operation has been cancelled, for operations to call at a point where stopping is safe
+    void ThrowIfCancelled();
+
+    // zero the counters and clear the cancellation, so the context can be used again
+    void Reset();
+
+private:
+    std::atomic<UINT64> bytesDone;
+    std::atomic<UINT64> bytesTotal;
+    std::atomic<UINT64> itemsDone;
+    std::atomic<UINT64> itemsTotal;
+    std::atomic<UINT64> itemBytesDone;
+    std::atomic<UINT64> itemBytesTotal;
+    std::atomic<bool> cancelled;
+};
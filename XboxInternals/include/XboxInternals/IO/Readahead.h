@@ -0,0 +1,98 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <XboxInternals/TypeDefinitions.h>
+#include <XboxInternals/Export.h>
+
+// size of each segment of the readahead ring, and how many of them are kept ahead of the reader
+#define READAHEAD_DEFAULT_SEGMENT_SIZE 0x100000
+#define READAHEAD_DEFAULT_SEGMENT_COUNT 4
+
+// reads smaller than this are left to the io, they don't count towards spotting a stream
+#define READAHEAD_MIN_READ_SIZE 0x1000
+
+// amount of back to back reads it takes before prefetching starts
+#define READAHEAD_TRIGGER_COUNT 3
+
+// Watches the reads made on an io and once they run sequentially, prefetches the data after them into a
+// ring of segments on a helper thread, so the next read is ready while the caller works on the last one.
+class XBOXINTERNALS_EXPORT Readahead
+{
+public:
+    // readFunction reads up to len bytes at offset and returns how many it got, it should stop short at the
+    // end of the data rather than throw. Prefetching starts on a multiple of alignment.
+    Readahead(std::function<DWORD(UINT64, BYTE*, DWORD)> readFunction,
+            DWORD segmentSize = READAHEAD_DEFAULT_SEGMENT_SIZE,
+            DWORD segmentCount = READAHEAD_DEFAULT_SEGMENT_COUNT, DWORD alignment = 1);
+    ~Readahead();
+
+    Readahead(const Readahead&) = delete;
+    Readahead &operator=(const Readahead&) = delete;
+
+    // copy the read out of the prefetched data, returns false when the caller has to read it itself,
+    // either way the read is used to spot a stream
+    bool Read(UINT64 offset, BYTE *outBuffer, DWORD len);
+
+    // drop the prefetched data if the range overlaps it, must be called after writing to the io
+    void Invalidate(UINT64 offset, UINT64 len);
+
+    // stop prefetching and forget about the current stream
+    void Reset();
+
+    // whether a stream is being prefetched right now
+    bool IsStreaming();
+
+private:
+    enum SegmentState
+    {
+        SegmentEmpty,
+        SegmentFilling,
+        SegmentReady,
+        SegmentFailed
+    };
+
+    struct Segment
+    {
+        std::vector<BYTE> data;
+        SegmentState state = SegmentEmpty;
+
+        // the amount of bytes actually read, short at the end of the data
+        DWORD validLength = 0;
+    };
+
+    // these must all be called with the mutex held
+    void startStream(UINT64 offset);
+    void stopStream(std::unique_lock<std::mutex> &lock);
+    bool copyFromWindow(UINT64 offset, BYTE *outBuffer, DWORD len, std::unique_lock<std::mutex> &lock);
+    void waitForFill(Segment &segment, std::unique_lock<std::mutex> &lock);
+
+    void helperLoop();
+
+    std::function<DWORD(UINT64, BYTE*, DWORD)> readFunction;
+    DWORD segmentSize;
+    DWORD segmentCount;
+    DWORD alignment;
+
+    // the ring, segments[head] holds the data at windowStart and each one after it the next segmentSize bytes
+    std::vector<Segment> segments;
+    size_t head;
+    UINT64 windowStart;
+    bool streaming;
+
+    // set once a segment comes up short or fails, nothing past it is prefetched
+    bool exhausted;
+
+    // where the last read ended, and how many reads in a row started there
+    UINT64 lastEnd;
+    DWORD sequentialReads;
+
+    bool quit;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::thread helper;
+};
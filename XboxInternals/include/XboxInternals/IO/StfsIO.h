@@ -18,12 +18,18 @@ public:
     void ReadBytes(BYTE *outBuffer, DWORD len) override;
     void WriteBytes(BYTE *buffer, DWORD len) override;
 
+    void ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len) override;
+    void WriteAt(UINT64 offset, BYTE *buffer, DWORD len) override;
+
     void Flush() override;
     void Close() override;
 
     void Resize(UINT64 size);
 
 private:
+    // get the package address of a file offset, and how many of len bytes after it are contiguous in the package
+    DWORD getContiguousRun(UINT64 offset, DWORD len, UINT64 *packageAddress);
+
     BaseIO *io;
     StfsPackage *package;
     StfsFileEntry entry;
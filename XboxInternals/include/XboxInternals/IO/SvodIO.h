@@ -4,6 +4,7 @@
 #include "../Disc/Gdfx.h"
 #include <XboxInternals/IO/BaseIO.h>
 #include <XboxInternals/IO/IndexableMultiFileIO.h>
+#include <XboxInternals/IO/OperationContext.h>
 #include "../Stfs/XContentHeader.h"
 #include <XboxInternals/Export.h>
 
@@ -18,7 +19,12 @@ public:
 
     void WriteBytes(BYTE *buffer, DWORD len) override;
 
-    void SaveFile(string savePath, void(*progress)(void*, DWORD, DWORD) = nullptr, void *arg = nullptr);
+    void ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len) override;
+
+    void WriteAt(UINT64 offset, BYTE *buffer, DWORD len) override;
+
+    void SaveFile(string savePath, void(*progress)(void*, DWORD, DWORD) = nullptr, void *arg = nullptr,
+            OperationContext *context = nullptr);
 
     void OverWriteFile(string inPath, void (*progress)(void*, DWORD, DWORD) = nullptr, void *arg = nullptr);
 
@@ -35,6 +41,12 @@ public:
 private:
     void SectorToAddress(DWORD sector, DWORD *addressInDataFile, DWORD *dataFileIndex);
 
+    // convert an offset in the file to an address in one of the data files
+    void FileOffsetToAddress(UINT64 offset, DWORD *addressInDataFile, DWORD *dataFileIndex);
+
+    // get the amount of bytes that can be read from the data file at address before hitting a hash table
+    DWORD BytesUntilHashTable(DWORD addressInDataFile, DWORD len);
+
     IndexableMultiFileIO *io;
     XContentHeader *metadata;
     GdfxFileEntry fileEntry;
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include <XboxInternals/IO/BaseIO.h>
+#include <XboxInternals/Export.h>
+
+// environment variable that turns tracing on, set it to a directory to get a JSON file per traced io,
+// or to "stderr" to have them printed
+#define TRACINGIO_ENVIRONMENT_VARIABLE "XBOXINTERNALS_IO_TRACE"
+
+// amount of power of two latency buckets, the last one holds everything slower
+#define TRACINGIO_LATENCY_BUCKETS 24
+
+// Passes everything through to another io while counting seeks, reads, writes, bytes, and how long each
+// call took. The counts are kept per operation, named by whichever TracingIO::Operation is active on the
+// calling thread, and dumped as JSON when the io is closed.
+class XBOXINTERNALS_EXPORT TracingIO : public BaseIO
+{
+public:
+    // name identifies the io in the dump, like a file path
+    TracingIO(BaseIO *io, std::string name);
+    TracingIO(std::unique_ptr<BaseIO> io, std::string name);
+    ~TracingIO() override;
+
+    // whether tracing was turned on with the environment variable
+    static bool Enabled();
+
+    // get the io that's being traced, for callers that need to know what kind of io it is
+    BaseIO *Inner();
+
+    // Labels the io calls made on this thread while it's alive, nested operations take over until they end
+    class XBOXINTERNALS_EXPORT Operation
+    {
+    public:
+        explicit Operation(const char *label);
+        ~Operation();
+
+        Operation(const Operation&) = delete;
+        Operation &operator=(const Operation&) = delete;
+
+        // the label active on this thread, for handing on to threads that do part of the work
+        static const char *Current();
+
+    private:
+        const char *previousLabel;
+    };
+
+    void SetPosition(UINT64 position, std::ios_base::seekdir dir = std::ios_base::beg) override;
+    UINT64 GetPosition() override;
+    UINT64 Length() override;
+
+    void ReadBytes(BYTE *outBuffer, DWORD len) override;
+    void WriteBytes(BYTE *buffer, DWORD len) override;
+
+    void ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len) override;
+    void WriteAt(UINT64 offset, BYTE *buffer, DWORD len) override;
+
+    ReadCompletion SubmitReads(std::vector<ReadRequest> requests) override;
+
+    void Flush() override;
+
+    // dump the statistics and close the io
+    void Close() override;
+
+    // get the statistics gathered so far as JSON
+    std::string ToJson();
+
+private:
+    struct Histogram
+    {
+        UINT64 buckets[TRACINGIO_LATENCY_BUCKETS] = {};
+
+        void Add(UINT64 microseconds);
+    };
+
+    struct OperationStats
+    {
+        UINT64 seeks = 0;
+        UINT64 reads = 0;
+        UINT64 writes = 0;
+        UINT64 flushes = 0;
+        UINT64 bytesRead = 0;
+        UINT64 bytesWritten = 0;
+        Histogram readLatency;
+        Histogram writeLatency;
+    };
+
+    // get the statistics for the operation active on this thread, statsMutex has to be held
+    OperationStats &currentStats();
+
+    // Write the JSON to wherever the environment variable points, only the first call does anything
+    void dump();
+
+    std::unique_ptr<BaseIO> ownedIO;
+    BaseIO *io;
+    std::string name;
+    std::map<std::string, OperationStats> stats;
+
+    // the io can be used from several threads at once, like the stages of a CopyPipeline
+    std::mutex statsMutex;
+    bool dumped;
+};
@@ -9,7 +9,8 @@ enum StfsPackageFlags
     StfsPackageCreate = 2,
     StfsPackageFemale = 4,    // only used when creating a packge
     StfsPackageDeleteIO = 8,
-    StfsPackageDontReadFileListing = 16
+    StfsPackageDontReadFileListing = 16,
+    StfsPackageMapFile = 32   // memory map the package, only used when opening an existing one by path
 };
 
 enum Sex
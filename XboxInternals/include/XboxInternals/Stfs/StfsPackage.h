@@ -8,7 +8,11 @@
 #include <stdlib.h>
 #include <time.h>
 #include <vector>
+#include <XboxInternals/IO/BufferedIO.h>
 #include <XboxInternals/IO/FileIO.h>
+#include <XboxInternals/IO/MappedFileIO.h>
+#include <XboxInternals/IO/OperationContext.h>
+#include <XboxInternals/IO/TracingIO.h>
 #include <XboxInternals/Stfs/IXContentHeader.h>
 
 #include <botan_all.h>
@@ -79,11 +83,12 @@ public:
 
     // Description: extract a file to designated file path
     void ExtractFile(string pathInPackage, string outPath, void(*extractProgress)(void*, DWORD,
-            DWORD) = NULL, void *arg = NULL);
+            DWORD) = NULL, void *arg = NULL, OperationContext *context = NULL);
 
-    // Description: extract a file (by FileEntry) to a designated file path
+    // Description: extract a file (by FileEntry) to a designated file path, if context gets cancelled
+    // the extraction stops and nothing is left at outPath
     void ExtractFile(StfsFileEntry *entry, string outPath, void(*extractProgress)(void*, DWORD,
-            DWORD) = NULL, void *arg = NULL);
+            DWORD) = NULL, void *arg = NULL, OperationContext *context = NULL);
 
     // Description: get the file entry of a file's path, sets nameLen to '0' if not found
     StfsFileEntry GetFileEntry(string pathInPackage, bool checkFolders = false,
@@ -122,9 +127,9 @@ public:
     // Description: remove a file entry from the file listing
     void RemoveFile(string pathInPackage);
 
-    // Description: inject a file into the package
+    // Description: inject a file into the package, context can only cancel it before it starts
     StfsFileEntry InjectFile(string path, string pathInPackage, void(*injectProgress)(void*, DWORD,
-            DWORD) = NULL, void *arg = NULL);
+            DWORD) = NULL, void *arg = NULL, OperationContext *context = NULL);
 
     // Description: inject raw data into the package
     StfsFileEntry InjectData(BYTE *data, DWORD length, string pathInPackage,
@@ -169,7 +174,12 @@ private:
 
         BaseIO *io;
         std::unique_ptr<BaseIO> ownedIO;
+        std::unique_ptr<TracingIO> tracingIO;
+        std::unique_ptr<BufferedIO> bufferedIO;
         std::unique_ptr<XContentHeader> metaDataOwner;
+
+        // the package's file when it's memory mapped, the hash tables and file listing are read straight out of it
+        MappedFileIO *mappedIO;
     stringstream except;
 
     Sex packageSex;
@@ -187,7 +197,7 @@ private:
     void ReadFileListing();
 
     // Description: set the out buffer to the sha1 of the block
-    void HashBlock(BYTE *block, BYTE *outBuffer);
+    void HashBlock(const BYTE *block, BYTE *outBuffer);
 
     // Description: swap the table used so there is a backup of the data modified
     void SwapTable(DWORD index, Level lvl);
@@ -201,6 +211,12 @@ private:
     // Description: get a block's hash entry
     HashEntry GetBlockHashEntry(DWORD blockNum);
 
+    // Description: read count hash entries from the io's current position
+    void ReadHashEntries(HashEntry *entries, DWORD count);
+
+    // Description: get len bytes at address, out of the mapping when the package is mapped or read into copy otherwise
+    const BYTE *ViewBytes(UINT64 address, DWORD len, BYTE *copy);
+
     // Description: get the true block number for the hash table that hashes the block at the level passed in
     DWORD ComputeLevelNBackingHashBlockNumber(DWORD blockNum, Level level);
 
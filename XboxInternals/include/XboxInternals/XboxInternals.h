@@ -46,13 +46,22 @@
 
 // I/O abstraction module
 #include <XboxInternals/IO/BaseIO.h>
+#include <XboxInternals/IO/BigFileIO.h>
+#include <XboxInternals/IO/BufferPool.h>
+#include <XboxInternals/IO/BufferedIO.h>
+#include <XboxInternals/IO/ByteSwap.h>
+#include <XboxInternals/IO/CopyPipeline.h>
 #include <XboxInternals/IO/DeviceIO.h>
 #include <XboxInternals/IO/FatxIO.h>
 #include <XboxInternals/IO/FileIO.h>
+#include <XboxInternals/IO/MappedFileIO.h>
 #include <XboxInternals/IO/MemoryIO.h>
 #include <XboxInternals/IO/MultiFileIO.h>
+#include <XboxInternals/IO/OperationContext.h>
+#include <XboxInternals/IO/Readahead.h>
 #include <XboxInternals/IO/SvodIO.h>
 #include <XboxInternals/IO/SvodMultiFileIO.h>
+#include <XboxInternals/IO/TracingIO.h>
 
 // STFS (Secure Transacted File System) module
 #include <XboxInternals/Stfs/StfsConstants.h>
@@ -24,7 +24,8 @@ class XBOXINTERNALS_EXPORT Xex
 {
 public:
     Xex(BaseIO *io);
-    Xex(std::string fileName);
+    // mapFile memory maps the executable instead of opening it with a FileIO
+    Xex(std::string fileName, bool mapFile = false);
     ~Xex();
 
     std::vector<std::string> GetSystemImportLibraries() const;
@@ -161,23 +162,24 @@ private:
 
     void Parse();
 
-    void ParseOptionalHeaderEntry(XexOptionalHeaderEntry *entry, int index);
+    // the Parse functions below read from headerIO, which holds everything in front of the data
+    void ParseOptionalHeaderEntry(BaseIO *headerIO, XexOptionalHeaderEntry *entry, int index);
 
-    void ParseSystemImportLibraryTable(DWORD address);
+    void ParseSystemImportLibraryTable(BaseIO *headerIO, DWORD address);
 
-    void ParseRatingInformation(DWORD address);
+    void ParseRatingInformation(BaseIO *headerIO, DWORD address);
 
-    void ParseStaticLibraryTable(DWORD address);
+    void ParseStaticLibraryTable(BaseIO *headerIO, DWORD address);
 
-    void ParseOriginalPEImageName(DWORD address);
+    void ParseOriginalPEImageName(BaseIO *headerIO, DWORD address);
 
-    void ParseResourceFileTable(DWORD address);
+    void ParseResourceFileTable(BaseIO *headerIO, DWORD address);
 
-    void ParseBaseFileDescriptor(DWORD address);
+    void ParseBaseFileDescriptor(BaseIO *headerIO, DWORD address);
 
-    void ParseLANKey(DWORD address);
+    void ParseLANKey(BaseIO *headerIO, DWORD address);
 
-    void ParseExecutionInfo(DWORD address);
+    void ParseExecutionInfo(BaseIO *headerIO, DWORD address);
 
     void ExtractFromRawData(std::string outPath, DWORD address, DWORD size);
 
@@ -1,6 +1,10 @@
 #include "XboxInternals/Disc/ISO.h"
+#include "XboxInternals/IO/BufferPool.h"
+#include "XboxInternals/IO/CopyPipeline.h"
 #include "XboxInternals/IO/FileIO.h"
 #include "XboxInternals/IO/IsoIO.h"
+#include "XboxInternals/IO/MappedFileIO.h"
+#include "XboxInternals/IO/MemoryIO.h"
 #include <fstream>
 #include <vector>
 #include <system_error>
@@ -23,6 +27,9 @@ namespace XboxInternals::Iso {
 struct IsoImage::Impl {
     std::string path;
     std::unique_ptr<BaseIO> io;
+
+    // set when io is a mapping, for zero copy access
+    MappedFileIO *mappedIO = nullptr;
 };
 
 IsoImage::IsoImage() : impl_(new Impl()), didReadFileListing(false), gdfxHeaderAddress(0), 
@@ -73,31 +80,43 @@ void IsoImage::ParseISO() {
 }
 
 void IsoImage::ReadFileListing(std::vector<GdfxFileEntry> *entryList, DWORD sector, int size, std::string path) {
-    // Seek to the start of the directory listing
-    UINT64 entryAddress = SectorToAddress(sector);
-    impl_->io->SetPosition(entryAddress);
+    // Parse the whole directory listing from memory, straight out of the mapping when the image is mapped
+    UINT64 tableAddress = SectorToAddress(sector);
+    UINT64 tableEnd = std::min<UINT64>(tableAddress + (((UINT64)(DWORD)size + ISO_SECTOR_SIZE - 1) &
+            ~(UINT64)(ISO_SECTOR_SIZE - 1)), impl_->io->Length());
+    DWORD tableLength = (tableEnd > tableAddress) ? (DWORD)(tableEnd - tableAddress) : 0;
+    
+    std::vector<BYTE> tableCopy;
+    BYTE *tableData;
+    if (impl_->mappedIO) {
+        tableData = const_cast<BYTE*>(impl_->mappedIO->View(tableAddress, tableLength).data());
+    }
+    else {
+        tableCopy.resize(tableLength);
+        impl_->io->ReadAt(tableAddress, tableCopy.data(), tableLength);
+        tableData = tableCopy.data();
+    }
+    MemoryIO table(tableData, tableLength);
+    
+    // Offset of the current entry in the listing
+    UINT64 entryAddress = 0;
+    DWORD tableSector = 0;
     
     GdfxFileEntry current;
     DWORD bytesLeft = size;
     
     while (bytesLeft != 0) {
         // Save position before reading
-        UINT64 currentAddress = impl_->io->GetPosition();
+        UINT64 currentAddress = entryAddress;
         
         // Use unified GDFX reading function
-        if (!GdfxReadFileEntry(impl_->io.get(), &current))
+        if (!GdfxReadFileEntry(&table, &current))
             break;
         
         // If it's a non-empty directory, recursively read its contents
         if (current.attributes & GdfxDirectory && current.size != 0) {
-            // Preserve the current position
-            UINT64 seekAddr = impl_->io->GetPosition();
-            
             ReadFileListing(&current.files, current.sector, current.size, 
                            path + current.name + "/");
-            
-            // Reset position to current listing
-            impl_->io->SetPosition(seekAddr);
         }
         
         current.filePath = path;
@@ -113,10 +132,10 @@ void IsoImage::ReadFileListing(std::vector<GdfxFileEntry> *entryList, DWORD sect
         
         // Seek to the next entry (aligned to 4-byte boundary)
         entryAddress += (current.nameLen + 0x11) & 0xFFFFFFFC;
-        impl_->io->SetPosition(entryAddress);
+        table.SetPosition(entryAddress);
         
-        // Check for end marker
-        DWORD nextBytes = impl_->io->ReadDword();
+        // Check for end marker, the listing running out counts as none since there are no bytes left then
+        DWORD nextBytes = (entryAddress + 4 <= tableLength) ? table.ReadDword() : 0;
         if (nextBytes == 0xFFFFFFFF) {
             if ((size - ISO_SECTOR_SIZE) <= 0) {
                 // Sort the file entries so that directories are first
@@ -125,8 +144,7 @@ void IsoImage::ReadFileListing(std::vector<GdfxFileEntry> *entryList, DWORD sect
             }
             else {
                 size -= ISO_SECTOR_SIZE;
-                entryAddress = SectorToAddress(++sector);
-                impl_->io->SetPosition(entryAddress);
+                entryAddress = (UINT64)(++tableSector) * ISO_SECTOR_SIZE;
             }
         }
         
@@ -134,7 +152,7 @@ void IsoImage::ReadFileListing(std::vector<GdfxFileEntry> *entryList, DWORD sect
         bytesLeft -= entryAddress - currentAddress;
         
         // Back up to the entry
-        impl_->io->SetPosition(entryAddress);
+        table.SetPosition(entryAddress);
         
         // Reset the directory
         current.files.clear();
@@ -274,12 +292,19 @@ DWORD IsoImage::GetTotalCopyIterations(const std::vector<GdfxFileEntry> *entryLi
     return totalCopyIterations;
 }
 
-bool IsoImage::open(const std::string& path) {
+bool IsoImage::open(const std::string& path, bool mapFile) {
     close();
     impl_->path = path;
     
     try {
-        impl_->io = std::make_unique<FileIO>(path, false);
+        if (mapFile) {
+            auto mappedIO = std::make_unique<MappedFileIO>(path, true);
+            impl_->mappedIO = mappedIO.get();
+            impl_->io = std::move(mappedIO);
+        }
+        else {
+            impl_->io = std::make_unique<FileIO>(path, false);
+        }
         
         info_.imageSize = impl_->io->Length();
         info_.sectorSize = ISO_SECTOR_SIZE;
@@ -303,6 +328,7 @@ bool IsoImage::open(const std::string& path) {
 }
 
 void IsoImage::close() {
+    impl_->mappedIO = nullptr;
     impl_->io.reset();
     impl_->path.clear();
     root.clear();
@@ -377,14 +403,14 @@ bool IsoImage::extractFile(const GdfxFileEntry& entry, const std::string& output
     uint64_t remaining = entry.size;
     uint64_t totalRead = 0;
     constexpr size_t bufferSize = 65536;
-    std::vector<BYTE> buffer(bufferSize);
+    BufferLease buffer = BufferPool::Shared().Acquire(bufferSize);
 
     try {
         while (remaining > 0) {
             size_t toRead = static_cast<size_t>(std::min<uint64_t>(remaining, bufferSize));
-            io->ReadBytes(buffer.data(), toRead);
+            io->ReadBytes(buffer.Data(), toRead);
             
-            of.write(reinterpret_cast<char*>(buffer.data()), toRead);
+            of.write(reinterpret_cast<char*>(buffer.Data()), toRead);
             remaining -= toRead;
             totalRead += toRead;
             
@@ -489,7 +515,6 @@ void IsoImage::ExtractFileHelper(std::string outDirectory, const GdfxFileEntry *
                                  void(*progress)(void*, uint32_t, uint32_t), void *arg,
                                  DWORD *curProgress, DWORD totalProgress) {
     constexpr DWORD ISO_COPY_BUFFER_SIZE = ISO_SECTOR_SIZE * 1000;
-    std::vector<BYTE> copyBuffer(ISO_COPY_BUFFER_SIZE);
     
     fs::create_directories(outDirectory);
     
@@ -501,21 +526,53 @@ void IsoImage::ExtractFileHelper(std::string outDirectory, const GdfxFileEntry *
         totalReads++;
     
     UINT64 readAddress = SectorToAddress(toExtract->sector);
-    impl_->io->SetPosition(readAddress);
     
-    for (DWORD x = 0; x < totalReads; x++) {
-        DWORD numBytesToCopy = ISO_COPY_BUFFER_SIZE;
-        if (x == totalReads - 1 && toExtract->size % ISO_COPY_BUFFER_SIZE != 0)
-            numBytesToCopy = toExtract->size % ISO_COPY_BUFFER_SIZE;
-        
-        impl_->io->ReadBytes(copyBuffer.data(), numBytesToCopy);
-        extractedFile.WriteBytes(copyBuffer.data(), numBytesToCopy);
+    // Every buffer's worth of the file counts once towards the progress
+    DWORD readsReported = 0;
+    auto reportProgress = [&](DWORD readsDone) {
+        for (; readsReported < readsDone; readsReported++) {
+            if (curProgress)
+                (*curProgress)++;
+            
+            if (progress)
+                progress(arg, curProgress ? *curProgress : 0, totalProgress);
+        }
+    };
+    
+    if (impl_->mappedIO) {
+        for (DWORD x = 0; x < totalReads; x++) {
+            DWORD numBytesToCopy = ISO_COPY_BUFFER_SIZE;
+            if (x == totalReads - 1 && toExtract->size % ISO_COPY_BUFFER_SIZE != 0)
+                numBytesToCopy = toExtract->size % ISO_COPY_BUFFER_SIZE;
+            
+            // Write straight out of the mapping, no need to copy into the buffer first
+            auto view = impl_->mappedIO->View(readAddress + (UINT64)x * ISO_COPY_BUFFER_SIZE, numBytesToCopy);
+            extractedFile.WriteBytes(const_cast<BYTE*>(view.data()), numBytesToCopy);
+            
+            reportProgress(x + 1);
+        }
+    }
+    else {
+        // The image is read and the file is written on their own threads so the two overlap
+        CopyPipeline pipeline(ISO_COPY_BUFFER_SIZE);
+        pipeline.SetProgress([&](UINT64 bytesWritten) {
+            reportProgress((DWORD)(bytesWritten / ISO_COPY_BUFFER_SIZE));
+        });
         
-        if (curProgress)
-            (*curProgress)++;
+        pipeline.Run([&](UINT64 x, BYTE *buffer) {
+            UINT64 offset = x * ISO_COPY_BUFFER_SIZE;
+            if (offset >= toExtract->size)
+                return (DWORD)0;
+            
+            DWORD numBytesToCopy = (DWORD)std::min<UINT64>(toExtract->size - offset, ISO_COPY_BUFFER_SIZE);
+            impl_->io->ReadAt(readAddress + offset, buffer, numBytesToCopy);
+            return numBytesToCopy;
+        },
+        [&](UINT64, const BYTE *buffer, DWORD len) {
+            extractedFile.WriteBytes(const_cast<BYTE*>(buffer), len);
+        });
         
-        if (progress)
-            progress(arg, curProgress ? *curProgress : 0, totalProgress);
+        reportProgress(totalReads);
     }
     
     extractedFile.Close();
@@ -208,6 +208,9 @@ void SVOD::Rehash(void (*progress)(DWORD, DWORD, void*), void *arg)
     BYTE currentBlock[0x1000];
     BYTE prevHash[0x14] = {0};
 
+    // every block of every part is read front to back
+    IndexableMultiFileIO::ReadaheadScope readahead(io.get());
+
     for (DWORD i = fileCount; i--;)
     {
         io->SetPosition(static_cast<DWORD>(0x2000), static_cast<int>(i));
@@ -0,0 +1,330 @@
+#include <XboxInternals/Fatx/FatxChainmap.h>
+#include <XboxInternals/Fatx/FatxConstants.h>
+#include <XboxInternals/IO/ByteSwap.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CHAINMAP_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CHAINMAP_TARGET(isa)
+#else
+#define CHAINMAP_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+namespace
+{
+
+// add count free clusters from cluster to the runs, joining them onto the last run if they follow it
+void addFreeClusters(std::vector<FatxClusterRun> &runs, DWORD cluster, DWORD count)
+{
+    if (!runs.empty() && runs.back().start + runs.back().count == cluster)
+        runs.back().count += count;
+    else
+        runs.push_back({ cluster, count });
+}
+
+template <typename T>
+void findFreeScalar(const BYTE *entries, DWORD firstCluster, DWORD begin, DWORD end,
+        std::vector<FatxClusterRun> &runs)
+{
+    for (DWORD i = begin; i < end; i++)
+    {
+        T value;
+        memcpy(&value, entries + i * sizeof(T), sizeof(T));
+
+        // available is zero, so there's no need to byte swap
+        if (value == 0)
+            addFreeClusters(runs, firstCluster + i, 1);
+    }
+}
+
+#ifdef CHAINMAP_X86
+
+// most blocks are either all used or all free, only the ones that are mixed are looked at an entry at a time,
+// returns how many of the entries were handled
+template <typename T>
+CHAINMAP_TARGET("sse2") DWORD findFreeSse2(const BYTE *entries, DWORD firstCluster, DWORD entryCount,
+        std::vector<FatxClusterRun> &runs)
+{
+    const DWORD entriesPerBlock = 16 / sizeof(T);
+    const __m128i zero = _mm_setzero_si128();
+
+    DWORD i = 0;
+    for (; i + entriesPerBlock <= entryCount; i += entriesPerBlock)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)(entries + i * sizeof(T)));
+        __m128i available;
+        if constexpr (sizeof(T) == 2)
+            available = _mm_cmpeq_epi16(block, zero);
+        else
+            available = _mm_cmpeq_epi32(block, zero);
+
+        int mask = _mm_movemask_epi8(available);
+        if (mask == 0)
+            continue;
+        else if (mask == 0xFFFF)
+            addFreeClusters(runs, firstCluster + i, entriesPerBlock);
+        else
+            findFreeScalar<T>(entries, firstCluster, i, i + entriesPerBlock, runs);
+    }
+
+    return i;
+}
+
+template <typename T>
+CHAINMAP_TARGET("avx2") DWORD findFreeAvx2(const BYTE *entries, DWORD firstCluster, DWORD entryCount,
+        std::vector<FatxClusterRun> &runs)
+{
+    const DWORD entriesPerBlock = 32 / sizeof(T);
+    const __m256i zero = _mm256_setzero_si256();
+
+    DWORD i = 0;
+    for (; i + entriesPerBlock <= entryCount; i += entriesPerBlock)
+    {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(entries + i * sizeof(T)));
+        __m256i available;
+        if constexpr (sizeof(T) == 2)
+            available = _mm256_cmpeq_epi16(block, zero);
+        else
+            available = _mm256_cmpeq_epi32(block, zero);
+
+        unsigned int mask = (unsigned int)_mm256_movemask_epi8(available);
+        if (mask == 0)
+            continue;
+        else if (mask == 0xFFFFFFFF)
+            addFreeClusters(runs, firstCluster + i, entriesPerBlock);
+        else
+            findFreeScalar<T>(entries, firstCluster, i, i + entriesPerBlock, runs);
+    }
+
+    return i;
+}
+
+bool detectAvx2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+
+    // AVX2 also needs the os to save the ymm registers
+    __cpuid(info, 1);
+    bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+    if (maxLeaf < 7 || !osSavesYmm)
+        return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+bool hasAvx2()
+{
+    static const bool avx2 = detectAvx2();
+    return avx2;
+}
+
+#endif
+
+template <typename T>
+void findFreeRuns(const BYTE *entries, DWORD firstCluster, DWORD entryCount, std::vector<FatxClusterRun> &runs)
+{
+    DWORD handled = 0;
+
+#ifdef CHAINMAP_X86
+    // SSE2 is always there on x64
+    if (hasAvx2())
+        handled = findFreeAvx2<T>(entries, firstCluster, entryCount, runs);
+    else
+        handled = findFreeSse2<T>(entries, firstCluster, entryCount, runs);
+#endif
+
+    findFreeScalar<T>(entries, firstCluster, handled, entryCount, runs);
+}
+
+}
+
+FatxChainmap::FatxChainmap(BaseIO *device, UINT64 address, UINT64 size, BYTE entrySize) :
+    device(device), address(address), size(size), entrySize(entrySize), loaded(false), dirty(false)
+{
+    if (entrySize != FAT16 && entrySize != FAT32)
+        throw std::string("FATX: Invalid chainmap entry size.\n");
+}
+
+void FatxChainmap::Load(void(*progress)(void*, bool), void *arg)
+{
+    if (loaded)
+        return;
+
+    ForEachChunk(nullptr, progress, arg);
+}
+
+void FatxChainmap::ForEachChunk(ChunkFunction chunkLoaded, void(*progress)(void*, bool), void *arg)
+{
+    bool reading = !loaded;
+    if (reading)
+        entries.resize(size);
+
+    for (UINT64 offset = 0; offset < size; offset += FATX_CHAINMAP_READ_SIZE)
+    {
+        DWORD chunkSize = (DWORD)std::min<UINT64>(size - offset, FATX_CHAINMAP_READ_SIZE);
+
+        if (reading)
+        {
+            device->ReadAt(address + offset, entries.data() + offset, chunkSize);
+
+            if (progress)
+                progress(arg, false);
+        }
+
+        if (chunkLoaded)
+            chunkLoaded(entries.data() + offset, (DWORD)(offset / entrySize), chunkSize / entrySize);
+    }
+
+    if (reading)
+    {
+        dirtyPages.assign((size + FATX_CHAINMAP_PAGE_SIZE - 1) / FATX_CHAINMAP_PAGE_SIZE, false);
+        dirty = false;
+        loaded = true;
+    }
+}
+
+bool FatxChainmap::IsLoaded()
+{
+    return loaded;
+}
+
+DWORD FatxChainmap::Get(DWORD cluster)
+{
+    UINT64 offset = entryOffset(cluster);
+
+    if (entrySize == FAT16)
+    {
+        WORD value;
+        memcpy(&value, entries.data() + offset, sizeof(WORD));
+        return ByteSwap::Swap(value);
+    }
+
+    DWORD value;
+    memcpy(&value, entries.data() + offset, sizeof(DWORD));
+    return ByteSwap::Swap(value);
+}
+
+void FatxChainmap::Set(DWORD cluster, DWORD value)
+{
+    UINT64 offset = entryOffset(cluster);
+
+    if (entrySize == FAT16)
+    {
+        WORD swapped = ByteSwap::Swap((WORD)value);
+        memcpy(entries.data() + offset, &swapped, sizeof(WORD));
+    }
+    else
+    {
+        DWORD swapped = ByteSwap::Swap(value);
+        memcpy(entries.data() + offset, &swapped, sizeof(DWORD));
+    }
+
+    dirtyPages[offset / FATX_CHAINMAP_PAGE_SIZE] = true;
+    dirty = true;
+}
+
+void FatxChainmap::ReadChain(DWORD startingCluster, std::vector<DWORD> &outChain)
+{
+    DWORD lastCluster = (entrySize == FAT16) ? FAT_CLUSTER16_LAST : FAT_CLUSTER_LAST;
+    UINT64 entryCount = EntryCount();
+
+    outChain.clear();
+
+    DWORD cluster = startingCluster;
+    while (cluster != lastCluster && cluster != FAT_CLUSTER_AVAILABLE)
+    {
+        // a chain can't be longer than the amount of clusters, unless it loops back on itself
+        if (outChain.size() >= entryCount)
+            throw std::string("FATX: FAT has circular link.\n");
+
+        outChain.push_back(cluster);
+        cluster = Get(cluster);
+    }
+}
+
+void FatxChainmap::Flush()
+{
+    if (!dirty)
+        return;
+
+    // runs of changed pages go out in a single write
+    size_t page = 0;
+    while (page < dirtyPages.size())
+    {
+        if (!dirtyPages[page])
+        {
+            page++;
+            continue;
+        }
+
+        size_t firstPage = page;
+        while (page < dirtyPages.size() && dirtyPages[page])
+            dirtyPages[page++] = false;
+
+        UINT64 offset = (UINT64)firstPage * FATX_CHAINMAP_PAGE_SIZE;
+        UINT64 len = std::min<UINT64>((UINT64)(page - firstPage) * FATX_CHAINMAP_PAGE_SIZE, size - offset);
+        device->WriteAt(address + offset, entries.data() + offset, (DWORD)len);
+    }
+
+    dirty = false;
+}
+
+void FatxChainmap::Invalidate()
+{
+    entries.clear();
+    entries.shrink_to_fit();
+    dirtyPages.clear();
+    dirty = false;
+    loaded = false;
+}
+
+UINT64 FatxChainmap::EntryCount()
+{
+    return size / entrySize;
+}
+
+BYTE FatxChainmap::EntrySize()
+{
+    return entrySize;
+}
+
+const BYTE *FatxChainmap::Data()
+{
+    Load();
+    return entries.data();
+}
+
+void FatxChainmap::FindFreeRuns(const BYTE *entries, BYTE entrySize, DWORD firstCluster, DWORD entryCount,
+        std::vector<FatxClusterRun> &outRuns)
+{
+    if (entrySize == FAT16)
+        findFreeRuns<WORD>(entries, firstCluster, entryCount, outRuns);
+    else
+        findFreeRuns<DWORD>(entries, firstCluster, entryCount, outRuns);
+}
+
+UINT64 FatxChainmap::entryOffset(DWORD cluster)
+{
+    Load();
+
+    UINT64 offset = (UINT64)cluster * entrySize;
+    if (offset + entrySize > size)
+        throw std::string("FATX: Cluster is greater than cluster count.\n");
+
+    return offset;
+}
@@ -0,0 +1,169 @@
+#include <XboxInternals/Fatx/FatxClusterAllocator.h>
+
+#include <algorithm>
+#include <iterator>
+#include <string>
+
+FatxClusterAllocator::FatxClusterAllocator() :
+    built(false), clusterCount(0), freeCount(0)
+{
+}
+
+void FatxClusterAllocator::Reset(DWORD clusterCount)
+{
+    this->clusterCount = clusterCount;
+    freeCount = 0;
+    bitmap.assign(((UINT64)clusterCount + 1 + 63) / 64, 0);
+    runsByStart.clear();
+    runsByLength.clear();
+    built = true;
+}
+
+bool FatxClusterAllocator::IsBuilt()
+{
+    return built;
+}
+
+void FatxClusterAllocator::Free(DWORD start, DWORD count)
+{
+    if (count == 0)
+        return;
+    if (start == 0 || (UINT64)start + count - 1 > clusterCount)
+        throw std::string("FATX: Cluster is greater than cluster count.\n");
+
+    for (DWORD i = 0; i < count; i++)
+    {
+        if (IsFree(start + i))
+            throw std::string("FATX: Error freeing cluster, cluster already free.\n");
+    }
+
+    setBits(start, count, true);
+    freeCount += count;
+
+    // join up with the run that ends right before this one and the one that starts right after it
+    auto next = runsByStart.lower_bound(start);
+    if (next != runsByStart.begin())
+    {
+        auto previous = std::prev(next);
+        if ((UINT64)previous->first + previous->second == start)
+        {
+            start = previous->first;
+            count += previous->second;
+            removeRun(previous);
+        }
+    }
+    if (next != runsByStart.end() && (UINT64)start + count == next->first)
+    {
+        count += next->second;
+        removeRun(next);
+    }
+
+    addRun(start, count);
+}
+
+void FatxClusterAllocator::Free(std::vector<DWORD> clusters)
+{
+    std::sort(clusters.begin(), clusters.end());
+
+    // free them a run of consecutive clusters at a time
+    size_t i = 0;
+    while (i < clusters.size())
+    {
+        size_t runEnd = i + 1;
+        while (runEnd < clusters.size() && clusters.at(runEnd) == clusters.at(runEnd - 1) + 1)
+            runEnd++;
+
+        Free(clusters.at(i), (DWORD)(runEnd - i));
+        i = runEnd;
+    }
+}
+
+std::vector<DWORD> FatxClusterAllocator::Allocate(DWORD count)
+{
+    if (count > freeCount)
+        throw std::string("FATX: Cannot find requested amount of free clusters.\n");
+
+    std::vector<DWORD> clusters;
+    clusters.reserve(count);
+
+    while (count > 0)
+    {
+        // of the longest runs, use the one closest to the start of the partition
+        DWORD longest = std::prev(runsByLength.end())->first;
+        DWORD start = runsByLength.lower_bound({ longest, 0 })->second;
+
+        DWORD take = std::min(count, longest);
+        removeRun(runsByStart.find(start));
+        if (take < longest)
+            addRun(start + take, longest - take);
+
+        setBits(start, take, false);
+        for (DWORD i = 0; i < take; i++)
+            clusters.push_back(start + i);
+
+        freeCount -= take;
+        count -= take;
+    }
+
+    return clusters;
+}
+
+bool FatxClusterAllocator::IsFree(DWORD cluster)
+{
+    if (cluster > clusterCount)
+        return false;
+    return (bitmap[cluster / 64] >> (cluster % 64)) & 1;
+}
+
+UINT64 FatxClusterAllocator::FreeCount()
+{
+    return freeCount;
+}
+
+size_t FatxClusterAllocator::RunCount()
+{
+    return runsByStart.size();
+}
+
+const std::map<DWORD, DWORD> &FatxClusterAllocator::Runs()
+{
+    return runsByStart;
+}
+
+const std::vector<UINT64> &FatxClusterAllocator::Bitmap()
+{
+    return bitmap;
+}
+
+void FatxClusterAllocator::setBits(DWORD start, DWORD count, bool free)
+{
+    UINT64 bit = start;
+    UINT64 end = (UINT64)start + count;
+
+    while (bit < end)
+    {
+        // set as much of the current word as is in the range at once
+        DWORD shift = bit % 64;
+        UINT64 bitsInWord = std::min<UINT64>(64 - shift, end - bit);
+        UINT64 mask = ((bitsInWord == 64) ? ~0ULL : ((1ULL << bitsInWord) - 1)) << shift;
+
+        if (free)
+            bitmap[bit / 64] |= mask;
+        else
+            bitmap[bit / 64] &= ~mask;
+
+        bit += bitsInWord;
+    }
+}
+
+void FatxClusterAllocator::addRun(DWORD start, DWORD length)
+{
+    runsByStart[start] = length;
+    runsByLength.insert({ length, start });
+}
+
+void FatxClusterAllocator::removeRun(std::map<DWORD, DWORD>::iterator run)
+{
+    runsByLength.erase({ run->second, run->first });
+    runsByStart.erase(run);
+}
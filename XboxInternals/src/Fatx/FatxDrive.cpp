@@ -2,7 +2,15 @@
    Much of his code is used throughout this class or very slightly modified */
 
 #include <XboxInternals/Fatx/FatxDrive.h>
-
+#include <XboxInternals/IO/BigFileIO.h>
+#include <XboxInternals/IO/CopyPipeline.h>
+#include <XboxInternals/IO/TracingIO.h>
+
+#include <algorithm>
+#include <deque>
+#include <future>
+#include <thread>
+#include <unordered_set>
 #include <vector>
 
 #ifdef _WIN32
@@ -23,6 +31,309 @@
     #include <unistd.h>
 #endif
 
+// the most chainmap chunks that are scanned for free clusters at once
+#define FATX_FREE_SCAN_MAX_THREADS 8
+
+// when indexing a partition, the most directory data that's read at once and the most threads that parse it
+#define FATX_INDEX_BATCH_SIZE 0x2000000
+#define FATX_INDEX_MAX_THREADS 8
+
+// snapshots start with "XFSS" and the version of their layout
+#define FATX_SNAPSHOT_MAGIC 0x58465353
+#define FATX_SNAPSHOT_VERSION 3
+
+// sparse backups start with "XSBK", the version of their layout, the length of the drive and the ranges of the
+// drive they hold, the data of the ranges follows back to back from the next alignment boundary
+#define FATX_SPARSE_BACKUP_MAGIC 0x5853424B
+#define FATX_SPARSE_BACKUP_VERSION 1
+#define FATX_SPARSE_BACKUP_ALIGNMENT 0x1000
+
+// the longest range in a sparse backup, the length of an extent has to fit in a DWORD
+#define FATX_SPARSE_BACKUP_MAX_EXTENT 0x80000000
+
+// the fewest bytes an entry and a package header take up in a snapshot, so a count that can't be right is caught
+// before it's used
+#define FATX_SNAPSHOT_MIN_ENTRY_SIZE 0x1F
+#define FATX_SNAPSHOT_MIN_HEADER_SIZE 0x18
+
+// amount of bytes of a backup between dropping them from the os cache
+#define FATX_BACKUP_CACHE_DROP_INTERVAL 0x4000000
+
+namespace
+{
+
+// get the physical drive behind io, if it's one, looking through the tracing wrapper
+DeviceIO *physicalDevice(BaseIO *io)
+{
+    if (TracingIO *traced = dynamic_cast<TracingIO*>(io))
+        io = traced->Inner();
+    return dynamic_cast<DeviceIO*>(io);
+}
+
+// called after each chunk of a backup moved the end of the transfer from previousEnd to end, every so
+// often the data before the last interval is dropped from the os cache, the os has usually written it back by then
+void dropBackupCache(BigFileIO &backup, UINT64 previousEnd, UINT64 end)
+{
+    if (end / FATX_BACKUP_CACHE_DROP_INTERVAL == previousEnd / FATX_BACKUP_CACHE_DROP_INTERVAL)
+        return;
+
+    UINT64 boundary = end - (end % FATX_BACKUP_CACHE_DROP_INTERVAL);
+    if (boundary < 2 * FATX_BACKUP_CACHE_DROP_INTERVAL)
+        return;
+
+    backup.DropCache(boundary - 2 * FATX_BACKUP_CACHE_DROP_INTERVAL, FATX_BACKUP_CACHE_DROP_INTERVAL);
+}
+
+// get where a directory's clusters are on the drive, clusters that follow each other are one extent
+std::vector<Extent> clusterExtents(FatxFileEntry *directory)
+{
+    std::vector<Extent> extents;
+    for (DWORD cluster : directory->clusterChain)
+        extents.push_back({ FatxIO::ClusterToOffset(directory->partition, cluster), directory->partition->clusterSize });
+
+    return AsyncIO::MergeExtents(extents);
+}
+
+// populate the directory's cachedFiles from its clusters, which have been read into data back to back
+void readDirectoryEntries(FatxFileEntry *entry, BYTE *data, void(*progress)(void*, bool), void *arg)
+{
+    MemoryIO clusters(data, (size_t)entry->clusterChain.size() * entry->partition->clusterSize);
+
+    // find out how many entries are in a single cluster
+    DWORD entriesInCluster = entry->partition->clusterSize / FATX_ENTRY_SIZE;
+
+    bool doneForGood = false;
+
+    // read all entries
+    for (size_t i = 0; i < entry->clusterChain.size(); i++)
+    {
+        UINT64 posCur = FatxIO::ClusterToOffset(entry->partition, entry->clusterChain.at(i));
+
+        // go to the cluster
+        clusters.SetPosition(i * entry->partition->clusterSize);
+
+        for (DWORD x = 0; x < entriesInCluster; x++)
+        {
+            // read the name length
+            FatxFileEntry newEntry;
+            newEntry.nameLen = clusters.ReadByte();
+
+            // check if there are no more entries
+            if (newEntry.nameLen == 0xFF || newEntry.nameLen == 0)
+            {
+                doneForGood = true;
+                break;
+            }
+
+            // calcualte the address
+            newEntry.address = posCur + (x * 0x40);
+
+            // read the attributes
+            newEntry.fileAttributes = clusters.ReadByte();
+
+            // read the name (0xFF is the null terminator)
+            bool subtract = true;
+            if (newEntry.nameLen == FATX_ENTRY_DELETED)
+                newEntry.name = clusters.ReadString(-1, 0xFF, true, FATX_ENTRY_MAX_NAME_LENGTH);
+            else
+            {
+                newEntry.name = clusters.ReadString(newEntry.nameLen);
+                subtract = false;
+            }
+
+            // if the name is invalid, then the entry must be corrupt so we'll skip to the next entry
+            if (!FatxDrive::ValidFileName(newEntry.name))
+            {
+                clusters.SetPosition((clusters.GetPosition() + 0x3F) & 0xFFFFFFFFFFFFFFC0);
+                continue;
+            }
+
+            // seek past the name
+            clusters.SetPosition(clusters.GetPosition() + (FATX_ENTRY_MAX_NAME_LENGTH - newEntry.name.length()) - subtract);
+
+            // read the rest of the entry information
+            newEntry.startingCluster = clusters.ReadDword();
+            if (newEntry.startingCluster == entry->startingCluster)
+                throw std::string("FATX: FAT has circular link.\n");
+
+            newEntry.fileSize = clusters.ReadDword();
+            newEntry.creationDate = clusters.ReadDword();
+            newEntry.lastWriteDate = clusters.ReadDword();
+            newEntry.lastAccessDate = clusters.ReadDword();
+            newEntry.partition = entry->partition;
+            newEntry.readDirectories = false;
+            newEntry.path = entry->path + entry->name + "\\";
+            newEntry.magic = 0;
+
+            // add it to the file cache
+            entry->cachedFiles.push_back(newEntry);
+
+            // update progress if needed
+            if (progress)
+                progress(arg, false);
+        }
+
+        if (doneForGood)
+            break;
+    }
+
+    // update progress if needed
+    if (progress)
+        progress(arg, true);
+
+    entry->fileSize = (entry->cachedFiles.size() * FATX_ENTRY_SIZE);
+    entry->readDirectories = true;
+}
+
+// a digest of the partition's chainmap and root directory, one of them changes whenever clusters are allocated
+// or freed, or anything is added to or removed from the root. The chainmap is already in memory and the root is
+// a cluster or two, so checking a snapshot costs next to nothing.
+void partitionDigest(BaseIO *io, Partition *part, BYTE *outDigest)
+{
+    FatxFileEntry root;
+    root.partition = part;
+    part->chainmap->ReadChain(part->rootDirectoryCluster, root.clusterChain);
+
+    std::vector<BYTE> rootClusters((size_t)root.clusterChain.size() * part->clusterSize);
+    if (!rootClusters.empty())
+        io->ReadV(clusterExtents(&root), rootClusters.data());
+
+    const auto sha1 = Botan::HashFunction::create_or_throw("SHA-1");
+    sha1->update(part->chainmap->Data(), part->chainmapSize);
+    sha1->update(rootClusters.data(), rootClusters.size());
+    sha1->final(outDigest);
+}
+
+// write every directory under root that's been read, a directory at a time with its folders after it in order
+void writeSnapshotTree(BaseIO &snapshot, FatxFileEntry *root)
+{
+    std::vector<FatxFileEntry*> directories = { root };
+    while (!directories.empty())
+    {
+        FatxFileEntry *directory = directories.back();
+        directories.pop_back();
+
+        snapshot.Write((BYTE)directory->readDirectories);
+        if (!directory->readDirectories)
+            continue;
+
+        snapshot.Write((DWORD)directory->cachedFiles.size());
+        for (FatxFileEntry &child : directory->cachedFiles)
+        {
+            snapshot.Write(child.nameLen);
+            snapshot.Write(child.fileAttributes);
+            snapshot.Write((BYTE)child.name.size());
+            snapshot.Write((BYTE*)child.name.data(), (DWORD)child.name.size());
+            snapshot.Write(child.startingCluster);
+            snapshot.Write(child.fileSize);
+            snapshot.Write(child.creationDate);
+            snapshot.Write(child.lastWriteDate);
+            snapshot.Write(child.lastAccessDate);
+            snapshot.Write((UINT64)child.address);
+        }
+
+        // pushed backwards so the first folder is written next
+        for (auto child = directory->cachedFiles.rbegin(); child != directory->cachedFiles.rend(); ++child)
+        {
+            if (child->fileAttributes & FatxDirectory)
+                directories.push_back(&*child);
+        }
+    }
+}
+
+// read the directories written by writeSnapshotTree back into root
+void readSnapshotTree(BaseIO &snapshot, FatxFileEntry *root)
+{
+    std::vector<FatxFileEntry*> directories = { root };
+    while (!directories.empty())
+    {
+        FatxFileEntry *directory = directories.back();
+        directories.pop_back();
+
+        directory->readDirectories = snapshot.ReadByte() != 0;
+        if (!directory->readDirectories)
+            continue;
+
+        DWORD count = snapshot.ReadDword();
+        if ((UINT64)count * FATX_SNAPSHOT_MIN_ENTRY_SIZE > snapshot.Length() - snapshot.GetPosition())
+            throw std::string("FATX: Snapshot is corrupt.\n");
+
+        directory->cachedFiles.resize(count);
+        for (FatxFileEntry &child : directory->cachedFiles)
+        {
+            child.partition = directory->partition;
+            child.nameLen = snapshot.ReadByte();
+            child.fileAttributes = snapshot.ReadByte();
+
+            BYTE nameLength = snapshot.ReadByte();
+            if (nameLength > FATX_ENTRY_MAX_NAME_LENGTH)
+                throw std::string("FATX: Snapshot is corrupt.\n");
+            child.name.resize(nameLength);
+            snapshot.ReadBytes((BYTE*)child.name.data(), nameLength);
+
+            child.startingCluster = snapshot.ReadDword();
+            child.fileSize = snapshot.ReadDword();
+            child.creationDate = snapshot.ReadDword();
+            child.lastWriteDate = snapshot.ReadDword();
+            child.lastAccessDate = snapshot.ReadDword();
+            child.address = (INT64)snapshot.ReadUInt64();
+            child.readDirectories = false;
+            child.path = directory->path + directory->name + "\\";
+            child.magic = 0;
+        }
+        directory->fileSize = count * FATX_ENTRY_SIZE;
+
+        for (auto child = directory->cachedFiles.rbegin(); child != directory->cachedFiles.rend(); ++child)
+        {
+            if (child->fileAttributes & FatxDirectory)
+                directories.push_back(&*child);
+        }
+    }
+}
+
+// write the package headers cached on the partition
+void writeSnapshotHeaders(BaseIO &snapshot, Partition *part)
+{
+    snapshot.Write((DWORD)part->cachedHeaders.size());
+    for (const auto &cached : part->cachedHeaders)
+    {
+        snapshot.Write((UINT64)cached.first);
+        snapshot.Write(cached.second.startingCluster);
+        snapshot.Write(cached.second.fileSize);
+        snapshot.Write(cached.second.lastWriteDate);
+        snapshot.Write((DWORD)cached.second.data.size());
+        snapshot.Write(const_cast<BYTE*>(cached.second.data.data()), (DWORD)cached.second.data.size());
+    }
+}
+
+// read the package headers written by writeSnapshotHeaders
+void readSnapshotHeaders(BaseIO &snapshot, std::map<INT64, FatxCachedHeader> &headers)
+{
+    DWORD count = snapshot.ReadDword();
+    if ((UINT64)count * FATX_SNAPSHOT_MIN_HEADER_SIZE > snapshot.Length() - snapshot.GetPosition())
+        throw std::string("FATX: Snapshot is corrupt.\n");
+
+    for (DWORD i = 0; i < count; i++)
+    {
+        INT64 address = (INT64)snapshot.ReadUInt64();
+
+        FatxCachedHeader cached;
+        cached.startingCluster = snapshot.ReadDword();
+        cached.fileSize = snapshot.ReadDword();
+        cached.lastWriteDate = snapshot.ReadDword();
+
+        DWORD length = snapshot.ReadDword();
+        if (length > snapshot.Length() - snapshot.GetPosition())
+            throw std::string("FATX: Snapshot is corrupt.\n");
+        cached.data.resize(length);
+        snapshot.ReadBytes(cached.data.data(), length);
+
+        headers[address] = std::move(cached);
+    }
+}
+
+}
+
 FatxDrive::FatxDrive(std::string drivePath, FatxDriveType type)  : type(type)
 {
     // convert it to a wstring
@@ -67,7 +378,7 @@ FatxIO FatxDrive::GetFatxIO(FatxFileEntry *entry)
     if (entry->clusterChain.size() == 0)
         ReadClusterChain(entry);
 
-    return FatxIO(static_cast<DeviceIO*>(io.get()), entry);
+    return FatxIO(io.get(), entry);
 }
 
 void FatxDrive::processBootSector(Partition *part)
@@ -120,6 +431,7 @@ void FatxDrive::processBootSector(Partition *part)
     part->clusterStartingAddress = part->address + FATX_HEADER_SIZE + chainmapSize;
     part->lastFreeClusterFound = 1;
     part->freeMemory = 0;
+    part->indexed = false;
 
     // setup the root
     part->root.startingCluster = part->rootDirectoryCluster;
@@ -255,11 +567,22 @@ FatxFileEntry* FatxDrive::createFileEntry(FatxFileEntry *parent, FatxFileEntry *
     DWORD fileSize = newEntry->fileSize;
     newEntry->fileSize = 0;
 
-    FatxIO childIO(static_cast<DeviceIO*>(io.get()), newEntry);
+    FatxIO childIO(io.get(), newEntry);
     childIO.AllocateMemory(fileSize);
     childIO.WriteEntryToDisk();
 
+    FatxFileEntry *previousFiles = parent->cachedFiles.data();
     parent->cachedFiles.push_back(*newEntry);
+
+    // when the cache grows the entries in it move, so the index needs to point at their new homes
+    if (parent->partition->indexed)
+    {
+        if (parent->cachedFiles.data() != previousFiles)
+            indexChildren(parent);
+        else
+            pathIndex[newEntry->path + newEntry->name] = &parent->cachedFiles.back();
+    }
+
     return &parent->cachedFiles.at(parent->cachedFiles.size() - 1);
 }
 
@@ -305,6 +628,8 @@ FatxFileEntry* FatxDrive::CreatePath(std::string folderPath)
 
 void FatxDrive::RemoveFile(FatxFileEntry *entry, void(*progress)(void*), void *arg)
 {
+    TracingIO::Operation trace("FatxDrive::RemoveFile");
+
     // check if the file is already deleted
     if (entry->nameLen == FATX_ENTRY_DELETED)
         return;
@@ -317,24 +642,22 @@ void FatxDrive::RemoveFile(FatxFileEntry *entry, void(*progress)(void*), void *a
         RemoveFile(&entry->cachedFiles.at(i), progress, arg);
 
     // set all the clusters to available
-    entry->clusterChain.push_back(entry->startingCluster);
-    FatxIO::SetAllClusters(static_cast<DeviceIO*>(io.get()), entry->partition, entry->clusterChain, FAT_CLUSTER_AVAILABLE);
+    FatxIO::SetAllClusters(io.get(), entry->partition, entry->clusterChain, FAT_CLUSTER_AVAILABLE);
 
-    // generate cluster ranges for fast insertion into the cluster chain
-    std::vector<Range> clusterRanges;
-    FatxIO::GetConsecutive(entry->clusterChain, clusterRanges, true);
-
-    // inject all of the ranges back into the cluster chain
-    for (DWORD i = 1; i < clusterRanges.size(); i++)
-    {
-        clusterRanges.at(i).start = entry->clusterChain.at(clusterRanges.at(i).start);
-        injectRange(entry->partition->freeClusters, clusterRanges.at(i));
-    }
+    // give them back to the allocator, if the free clusters haven't been found yet they'll be found then
+    if (entry->partition->freeClusters.IsBuilt())
+        entry->partition->freeClusters.Free(entry->clusterChain);
 
     // update the entry
     entry->clusterChain.clear();
+    FatxIO::ChainChanged(entry);
     entry->nameLen = FATX_ENTRY_DELETED;
 
+    auto indexed = pathIndex.find(entry->path + entry->name);
+    if (indexed != pathIndex.end() && indexed->second == entry)
+        pathIndex.erase(indexed);
+    entry->partition->cachedHeaders.erase(entry->address);
+
     // update the entry file name lenght to deleted
     io->SetPosition(entry->address);
     io->Write((BYTE)FATX_ENTRY_DELETED);
@@ -346,6 +669,8 @@ void FatxDrive::RemoveFile(FatxFileEntry *entry, void(*progress)(void*), void *a
 
 void FatxDrive::InjectFile(FatxFileEntry *parent, std::string name, std::string filePath, void (*progress)(void *, DWORD, DWORD), void *arg)
 {
+    TracingIO::Operation trace("FatxDrive::InjectFile");
+
     UINT64 fileLength = 0;
 
 #ifdef _WIN32
@@ -392,6 +717,19 @@ void FatxDrive::GetFileEntryMagic(FatxFileEntry *entry)
     if (entry->fileSize < 4 || entry->magic != 0)
         return;
 
+    // a cached header starts the same way as the file does
+    if (const std::vector<BYTE> *header = GetCachedContentHeader(entry))
+    {
+        MemoryIO headerIO(const_cast<BYTE*>(header->data()), header->size());
+        entry->magic = headerIO.ReadDword();
+        if (header->size() >= 0x3AD)
+        {
+            headerIO.SetPosition(0x3AC);
+            entry->fileSystem = (FileSystem)headerIO.ReadByte();
+        }
+        return;
+    }
+
     io->SetPosition(FatxIO::ClusterToOffset(entry->partition, entry->startingCluster));
     entry->magic = io->ReadDword();
 
@@ -403,8 +741,36 @@ void FatxDrive::GetFileEntryMagic(FatxFileEntry *entry)
     }
 }
 
+void FatxDrive::CacheContentHeader(FatxFileEntry *entry, std::vector<BYTE> header)
+{
+    FatxCachedHeader &cached = entry->partition->cachedHeaders[entry->address];
+    cached.startingCluster = entry->startingCluster;
+    cached.fileSize = entry->fileSize;
+    cached.lastWriteDate = entry->lastWriteDate;
+    cached.data = std::move(header);
+}
+
+const std::vector<BYTE>* FatxDrive::GetCachedContentHeader(FatxFileEntry *entry)
+{
+    auto cached = entry->partition->cachedHeaders.find(entry->address);
+    if (cached == entry->partition->cachedHeaders.end())
+        return nullptr;
+
+    // the entry's been reused for another file, or the file's been rewritten outside of a FatxIO
+    if (cached->second.startingCluster != entry->startingCluster || cached->second.fileSize != entry->fileSize ||
+            cached->second.lastWriteDate != entry->lastWriteDate)
+    {
+        entry->partition->cachedHeaders.erase(cached);
+        return nullptr;
+    }
+
+    return &cached->second.data;
+}
+
 void FatxDrive::GetChildFileEntries(FatxFileEntry *entry, void(*progress)(void*, bool), void *arg)
 {
+    TracingIO::Operation trace("FatxDrive::GetChildFileEntries");
+
     // if all entries have been read, skip this
     if (entry->readDirectories || !(entry->fileAttributes & FatxDirectory))
         return;
@@ -413,122 +779,158 @@ void FatxDrive::GetChildFileEntries(FatxFileEntry *entry, void(*progress)(void*,
     if (entry->clusterChain.size() == 0)
         ReadClusterChain(entry);
 
-    // find out how many entries are in a single cluster
-    DWORD entriesInCluster = entry->partition->clusterSize / FATX_ENTRY_SIZE;
+    // the whole directory is read at once, then picked apart in memory
+    std::vector<BYTE> clusters((size_t)entry->clusterChain.size() * entry->partition->clusterSize);
+    if (!clusters.empty())
+        io->ReadV(clusterExtents(entry), clusters.data());
 
-    bool doneForGood = false;
+    readDirectoryEntries(entry, clusters.data(), progress, arg);
 
-    // read all entries
-    for (size_t i = 0; i < entry->clusterChain.size(); i++)
-    {
-        UINT64 posCur = FatxIO::ClusterToOffset(entry->partition, entry->clusterChain.at(i));
-
-        // go to the cluster offset
-        io->SetPosition(posCur);
+    // new folders can get read after their partition has been indexed
+    if (entry->partition->indexed)
+        indexChildren(entry);
+}
 
-        for (DWORD x = 0; x < entriesInCluster; x++)
-        {
-            // read the name length
-            FatxFileEntry newEntry;
-            newEntry.nameLen = io->ReadByte();
+void FatxDrive::IndexPartition(Partition *part, void(*progress)(void*, bool), void *arg)
+{
+    TracingIO::Operation trace("FatxDrive::IndexPartition");
 
-            // check if there are no more entries
-            if (newEntry.nameLen == 0xFF || newEntry.nameLen == 0)
-            {
-                doneForGood = true;
-                break;
-            }
+    if (part->indexed)
+        return;
 
-            // calcualte the address
-            newEntry.address = posCur + (x * 0x40);
+    // every directory's chain comes from the chainmap, so get it in memory once up front
+    part->chainmap->Load();
 
-            // read the attributes
-            newEntry.fileAttributes = io->ReadByte();
+    // go down the tree a level at a time, all the directories on a level can be read at once
+    std::unordered_set<DWORD> visitedClusters = { part->root.startingCluster };
+    std::vector<FatxFileEntry*> level = { &part->root };
+    while (!level.empty())
+    {
+        readDirectoryBatch(level);
 
-            // read the name (0xFF is the null terminator)
-            bool subtract = true;
-            if (newEntry.nameLen == FATX_ENTRY_DELETED)
-                newEntry.name = io->ReadString(-1, 0xFF, true, FATX_ENTRY_MAX_NAME_LENGTH);
-            else
-            {
-                newEntry.name = io->ReadString(newEntry.nameLen);
-                subtract = false;
-            }
+        if (progress)
+            progress(arg, false);
 
-            // if the name is invalid, then the entry must be corrupt so we'll skip to the next entry
-            if (!ValidFileName(newEntry.name))
+        std::vector<FatxFileEntry*> nextLevel;
+        for (FatxFileEntry *directory : level)
+        {
+            for (FatxFileEntry &child : directory->cachedFiles)
             {
-                io->SetPosition((io->GetPosition() + 0x3F) & 0xFFFFFFFFFFFFFFC0);
-                continue;
+                // the clusters of a deleted folder could belong to anything by now, and a folder that's already
+                // been visited means the directories link back on themselves
+                if (!(child.fileAttributes & FatxDirectory) || child.nameLen == FATX_ENTRY_DELETED)
+                    continue;
+                if (!visitedClusters.insert(child.startingCluster).second)
+                    continue;
+
+                nextLevel.push_back(&child);
             }
+        }
+        level = std::move(nextLevel);
+    }
 
-            // seek past the name
-            io->SetPosition(io->GetPosition() + (FATX_ENTRY_MAX_NAME_LENGTH - newEntry.name.length()) - subtract);
+    part->indexed = true;
+    indexEntries(&part->root);
+}
 
-            // read the rest of the entry information
-            newEntry.startingCluster = io->ReadDword();
-            if (newEntry.startingCluster == entry->startingCluster)
-                throw std::string("FATX: FAT has circular link.\n");
+void FatxDrive::readDirectoryBatch(const std::vector<FatxFileEntry*> &directories)
+{
+    std::vector<FatxFileEntry*> unread;
+    for (FatxFileEntry *directory : directories)
+    {
+        if (directory->readDirectories)
+            continue;
 
-            newEntry.fileSize = io->ReadDword();
-            newEntry.creationDate = io->ReadDword();
-            newEntry.lastWriteDate = io->ReadDword();
-            newEntry.lastAccessDate = io->ReadDword();
-            newEntry.partition = entry->partition;
-            newEntry.readDirectories = false;
-            newEntry.path = entry->path + entry->name + "\\";
-            newEntry.magic = 0;
+        if (directory->clusterChain.size() == 0)
+            ReadClusterChain(directory);
+        unread.push_back(directory);
+    }
 
-            // add it to the file cache
-            entry->cachedFiles.push_back(newEntry);
+    size_t batchStart = 0;
+    while (batchStart < unread.size())
+    {
+        // take directories until their clusters fill up a batch
+        std::vector<Extent> extents;
+        std::vector<size_t> offsets;
+        size_t batchEnd = batchStart;
+        UINT64 batchSize = 0;
+        while (batchEnd < unread.size() && (batchEnd == batchStart || batchSize < FATX_INDEX_BATCH_SIZE))
+        {
+            FatxFileEntry *directory = unread.at(batchEnd++);
+            offsets.push_back(batchSize);
 
-            // update progress if needed
-            if (progress)
-                progress(arg, false);
+            std::vector<Extent> directoryExtents = clusterExtents(directory);
+            extents.insert(extents.end(), directoryExtents.begin(), directoryExtents.end());
+            batchSize += (UINT64)directory->clusterChain.size() * directory->partition->clusterSize;
         }
 
-        if (doneForGood)
-            break;
-    }
+        // the whole batch is handed to the device at once, so it can have the reads in flight together
+        std::vector<BYTE> clusters(batchSize);
+        if (!extents.empty())
+            io->ReadV(extents, clusters.data());
 
-    // update progress if needed
-    if (progress)
-        progress(arg, true);
+        // then the directories are picked apart on worker threads, they don't share anything
+        DWORD threadCount = std::clamp<DWORD>(std::thread::hardware_concurrency(), 1, FATX_INDEX_MAX_THREADS);
+        size_t batchCount = batchEnd - batchStart;
+        size_t perThread = (batchCount + threadCount - 1) / threadCount;
 
-    entry->fileSize = (entry->cachedFiles.size() * FATX_ENTRY_SIZE);
-    entry->readDirectories = true;
-}
+        std::vector<std::future<void>> parsers;
+        for (size_t first = 0; first < batchCount; first += perThread)
+        {
+            size_t last = std::min(first + perThread, batchCount);
+            parsers.push_back(std::async(std::launch::async, [&, first, last]()
+            {
+                for (size_t i = first; i < last; i++)
+                    readDirectoryEntries(unread.at(batchStart + i), clusters.data() + offsets.at(i), NULL, NULL);
+            }));
+        }
 
-void FatxDrive::ReadClusterChain(FatxFileEntry *entry)
-{
-    // clear the current chain
-    entry->clusterChain.clear();
+        // wait for all of them before an error gets out, they're using the buffer
+        for (std::future<void> &parser : parsers)
+            parser.wait();
+        for (std::future<void> &parser : parsers)
+            parser.get();
 
-    // calculate values
-    bool clusterSizeIs2 = (entry->partition->clusterEntrySize == FAT16);
-    DWORD lastCluster =  (clusterSizeIs2) ? FAT_CLUSTER16_LAST : FAT_CLUSTER_LAST;
-    DWORD availableCluster = (clusterSizeIs2) ? FAT_CLUSTER16_AVAILABLE : FAT_CLUSTER_AVAILABLE;
-    INT64 clusterMapAddress = entry->partition->address + 0x1000;
+        batchStart = batchEnd;
+    }
+}
 
-    // start with the starting cluster
-    DWORD previousCluster = entry->startingCluster;
+void FatxDrive::indexEntries(FatxFileEntry *entry)
+{
+    pathIndex[entry->path + entry->name] = entry;
 
-    while (previousCluster != lastCluster && previousCluster != availableCluster)
+    std::vector<FatxFileEntry*> directories = { entry };
+    while (!directories.empty())
     {
-        // add it to the cluster chain
-        entry->clusterChain.push_back(previousCluster);
+        FatxFileEntry *directory = directories.back();
+        directories.pop_back();
 
-        // seek to the next cluster
-        io->SetPosition(clusterMapAddress + (previousCluster * entry->partition->clusterEntrySize));
+        indexChildren(directory);
+        for (FatxFileEntry &child : directory->cachedFiles)
+        {
+            if ((child.fileAttributes & FatxDirectory) && child.nameLen != FATX_ENTRY_DELETED &&
+                    child.readDirectories)
+                directories.push_back(&child);
+        }
+    }
+}
 
-        // read the cluster
-        if (clusterSizeIs2)
-            previousCluster = io->ReadWord();
-        else
-            previousCluster = io->ReadDword();
+void FatxDrive::indexChildren(FatxFileEntry *directory)
+{
+    for (FatxFileEntry &child : directory->cachedFiles)
+    {
+        if (child.nameLen != FATX_ENTRY_DELETED)
+            pathIndex[child.path + child.name] = &child;
     }
 }
 
+void FatxDrive::ReadClusterChain(FatxFileEntry *entry)
+{
+    // the whole chainmap is read in once, after that following a chain doesn't touch the device
+    entry->partition->chainmap->ReadChain(entry->startingCluster, entry->clusterChain);
+    FatxIO::ChainChanged(entry);
+}
+
 void FatxDrive::Close()
 {
     if (io)
@@ -537,137 +939,325 @@ void FatxDrive::Close()
 
 void FatxDrive::CreateBackup(std::string outPath, void (*progress)(void *, DWORD, DWORD), void *arg)
 {
+    TracingIO::Operation trace("FatxDrive::CreateBackup");
+
     // create a file on the local disk to store the backup
-    FileIO outBackup(outPath, true);
+    BigFileIO outBackup(outPath, true);
 
     UINT64 driveLen = io->Length();
-    io->SetPosition(0);
-
-    std::vector<BYTE> buffer(0x100000);
+    outBackup.Preallocate(driveLen);
+    outBackup.AdviseSequential();
 
-    // start writing the drive contents to the local disk
-    DWORD i = 0;
     UINT64 totalProgress = driveLen / 0x100000;
-    while (driveLen >= 0x100000)
+    auto reportProgress = [&](UINT64 bytesWritten)
     {
-        io->ReadBytes(buffer.data(), 0x100000);
-        outBackup.WriteBytes(buffer.data(), 0x100000);
+        if (progress && bytesWritten / 0x100000 < totalProgress)
+            progress(arg, (DWORD)(bytesWritten / 0x100000), totalProgress);
+    };
 
-        if (progress)
-            progress(arg, i, totalProgress);
+    auto writeChunk = [&](UINT64 offset, const BYTE *buffer, DWORD len)
+    {
+        outBackup.WriteAt(offset, const_cast<BYTE*>(buffer), len);
+        dropBackupCache(outBackup, offset, offset + len);
+    };
 
-        driveLen -= 0x100000;
-        i++;
+    // a physical drive is streamed past the os cache, there's no point in caching a whole drive
+    if (DeviceIO *device = physicalDevice(io.get()))
+    {
+        UINT64 bytesWritten = 0;
+        device->BulkRead(0, driveLen, [&](const BYTE *buffer, DWORD len)
+        {
+            writeChunk(bytesWritten, buffer, len);
+            bytesWritten += len;
+            reportProgress(bytesWritten);
+        });
     }
-
-    if (driveLen > 0)
+    else
     {
-        // Read remaining data
-        const DWORD tailSize = static_cast<DWORD>(driveLen);
-        io->ReadBytes(buffer.data(), tailSize);
-        outBackup.WriteBytes(buffer.data(), tailSize);
+        // the drive is read and the backup is written on their own threads, so the two overlap
+        CopyPipeline pipeline;
+        pipeline.SetProgress(reportProgress);
+        pipeline.Run([&](UINT64 chunk, BYTE *buffer)
+        {
+            UINT64 offset = chunk * COPYPIPELINE_DEFAULT_BUFFER_SIZE;
+            if (offset >= driveLen)
+                return (DWORD)0;
+
+            DWORD len = (DWORD)std::min<UINT64>(driveLen - offset, COPYPIPELINE_DEFAULT_BUFFER_SIZE);
+            io->ReadV({ { offset, len } }, buffer);
+            return len;
+        },
+        [&](UINT64 chunk, const BYTE *buffer, DWORD len)
+        {
+            writeChunk(chunk * COPYPIPELINE_DEFAULT_BUFFER_SIZE, buffer, len);
+        });
     }
 
     if (progress)
         progress(arg, totalProgress, totalProgress);
 
     outBackup.Close();
-
 }
 
-void FatxDrive::RestoreFromBackup(std::string backupPath, void (*progress)(void *, DWORD, DWORD), void *arg)
+void FatxDrive::CreateSparseBackup(std::string outPath, void (*progress)(void *, DWORD, DWORD), void *arg)
 {
-    /* Here's the thing... fstream is trash. It will only handle files up to 2GB or 4GB,
-       at least on my windows 7 machine. That's a huge problem because drive backups will
-       most likely be a lot larger than that. SOOOOOO it looks like I'll have to use OS
-       specific functions in order to get this to work properly. It makes more sense
-       to just make the FileIO class use the OS specific functions to begin with, but
-       the ReadFile/WriteFile functions are slower than fstream functions, probably because
-       they don't cache a bunch of stuff.
-    */
-
-    std::vector<BYTE> buffer(0x100000);
-    UINT64 bytesLeft;
+    TracingIO::Operation trace("FatxDrive::CreateSparseBackup");
 
-#ifdef _WIN32
-    std::wstring wBackupPath;
-    wBackupPath.assign(backupPath.begin(), backupPath.end());
-    HANDLE hFile = CreateFileW(wBackupPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    std::vector<Extent> extents = usedExtents();
 
-    if (hFile == INVALID_HANDLE_VALUE)
-        throw std::string("FATX: Could not open drive backup.");
+    MemoryIO header;
+    header.Write((DWORD)FATX_SPARSE_BACKUP_MAGIC);
+    header.Write((DWORD)FATX_SPARSE_BACKUP_VERSION);
+    header.Write(io->Length());
+    header.Write((DWORD)extents.size());
 
-    DWORD high;
-    DWORD low = GetFileSize(hFile, &high);
-    bytesLeft = ((UINT64)high << 32) | low;
+    UINT64 dataLen = 0;
+    for (const Extent &extent : extents)
+    {
+        header.Write(extent.offset);
+        header.Write(extent.length);
+        dataLen += extent.length;
+    }
 
-    SetFilePointer(hFile, 0, 0, FILE_BEGIN);
-#else
-    struct stat sb;
-    stat(backupPath.c_str(), &sb);
-    bytesLeft = sb.st_size;
+    UINT64 dataStart = (header.Length() + FATX_SPARSE_BACKUP_ALIGNMENT - 1) & ~(UINT64)(FATX_SPARSE_BACKUP_ALIGNMENT - 1);
 
-    int backupFile = open(backupPath.c_str(), O_RDWR);
-    if (backupFile == -1)
-        throw std::string("FATX: Could not open drive backup.");
+    // create a file on the local disk to store the backup
+    BigFileIO outBackup(outPath, true);
+    outBackup.Preallocate(dataStart + dataLen);
+    outBackup.AdviseSequential();
+    outBackup.WriteAt(0, header.GetBuffer(), (DWORD)header.Length());
 
-    lseek(backupFile, 0, SEEK_SET);
-#endif // _WIN32
+    UINT64 totalProgress = dataLen / 0x100000;
+    auto reportProgress = [&](UINT64 bytesWritten)
+    {
+        if (progress && bytesWritten / 0x100000 < totalProgress)
+            progress(arg, (DWORD)(bytesWritten / 0x100000), totalProgress);
+    };
 
-    io->SetPosition(0);
+    // every batch but the last fills a whole buffer, so they're back to back in the backup
+    std::vector<std::vector<Extent>> batches = AsyncIO::SplitExtents(extents, COPYPIPELINE_DEFAULT_BUFFER_SIZE);
 
-    UINT64 totalProgress = bytesLeft / 0x100000;
-    DWORD i = 0;
-    while (bytesLeft >= 0x100000)
+    // the ranges in a buffer are read from the drive at once while the buffers before it are written out
+    CopyPipeline pipeline;
+    pipeline.SetProgress(reportProgress);
+    pipeline.Run([&](UINT64 chunk, BYTE *buffer)
     {
-#ifdef _WIN32
-        high = (i * (UINT64)0x100000) >> 32;
-        SetFilePointer(hFile, static_cast<LONG>((i * static_cast<UINT64>(0x100000)) & 0xFFFFFFFF), reinterpret_cast<PLONG>(&high), FILE_BEGIN);
+        if (chunk >= batches.size())
+            return (DWORD)0;
 
-        DWORD bytesRead = 0;
-        ReadFile(hFile, buffer.data(), 0x100000, &bytesRead, NULL);
-#else
-        lseek(backupFile, (UINT64)i * (UINT64)0x100000, SEEK_SET);
-        ssize_t bytesRead = read(backupFile, buffer.data(), 0x100000);
-        if (bytesRead < 0)
-            throw std::string("FatxDrive: Error reading from backup file.\n");
-#endif
-        io->WriteBytes(buffer.data(), 0x100000);
-        bytesLeft -= 0x100000;
+        DWORD len = 0;
+        for (const Extent &extent : batches.at(chunk))
+            len += extent.length;
 
-        if (progress)
-            progress(arg, i, totalProgress);
-        i++;
+        io->ReadV(batches.at(chunk), buffer);
+        return len;
+    },
+    [&](UINT64 chunk, const BYTE *buffer, DWORD len)
+    {
+        UINT64 offset = dataStart + chunk * COPYPIPELINE_DEFAULT_BUFFER_SIZE;
+        outBackup.WriteAt(offset, const_cast<BYTE*>(buffer), len);
+        dropBackupCache(outBackup, offset, offset + len);
+    });
+
+    if (progress)
+        progress(arg, totalProgress, totalProgress);
+
+    outBackup.Close();
+}
+
+std::vector<Extent> FatxDrive::usedExtents()
+{
+    UINT64 driveLen = io->Length();
+
+    // the free clusters of every partition are what's left out
+    std::vector<std::pair<UINT64, UINT64>> freeRanges;
+    for (std::unique_ptr<Partition> &part : partitions)
+    {
+        GetFreeMemory(part.get());
+        for (const auto &run : part->freeClusters.Runs())
+            freeRanges.push_back({ FatxIO::ClusterToOffset(part.get(), run.first), (UINT64)run.second * part->clusterSize });
     }
+    std::sort(freeRanges.begin(), freeRanges.end());
 
-    if (bytesLeft > 0)
+    std::vector<Extent> extents;
+    auto addRange = [&](UINT64 offset, UINT64 len)
     {
-#ifdef _WIN32
-        SetFilePointer(hFile, (i * (UINT64)0x100000) & 0xFFFFFFFF, (PLONG)&high, FILE_BEGIN);
-        DWORD bytesRead = 0;
-        ReadFile(hFile, buffer.data(), static_cast<DWORD>(bytesLeft), &bytesRead, NULL);
-#else
-        lseek(backupFile, (UINT64)i * (UINT64)0x100000, SEEK_SET);
-        ssize_t bytesRead = read(backupFile, buffer.data(), static_cast<size_t>(bytesLeft));
-        if (bytesRead < 0)
-            throw std::string("FatxDrive: Error reading from backup file.\n");
-#endif
-        io->WriteBytes(buffer.data(), static_cast<DWORD>(bytesLeft));
+        while (len > 0)
+        {
+            DWORD extentLen = (DWORD)std::min<UINT64>(len, FATX_SPARSE_BACKUP_MAX_EXTENT);
+            extents.push_back({ offset, extentLen });
+            offset += extentLen;
+            len -= extentLen;
+        }
+    };
+
+    // everything between the free ranges is used
+    UINT64 position = 0;
+    for (const auto &range : freeRanges)
+    {
+        UINT64 start = std::min(range.first, driveLen);
+        if (start > position)
+            addRange(position, start - position);
+        position = std::max(position, std::min(range.first + range.second, driveLen));
+    }
+    addRange(position, driveLen - position);
+
+    return extents;
+}
+
+void FatxDrive::RestoreFromBackup(std::string backupPath, void (*progress)(void *, DWORD, DWORD), void *arg)
+{
+    TracingIO::Operation trace("FatxDrive::RestoreFromBackup");
+
+    // backups are as big as the drive, so they're read straight through a descriptor rather than fstream
+    BigFileIO backup(backupPath, false, true);
+    backup.AdviseSequential();
+
+    UINT64 backupLen = backup.Length();
+
+    // the start of a drive is zeros, a format version or a certificate, so it won't look like a sparse backup
+    if (backupLen >= sizeof(DWORD) && backup.ReadDwordAt(0) == FATX_SPARSE_BACKUP_MAGIC)
+    {
+        restoreSparseBackup(backup, progress, arg);
+        backup.Close();
+
+        ReloadDrive();
+        return;
+    }
+    UINT64 totalProgress = backupLen / 0x100000;
+    auto reportProgress = [&](UINT64 bytesDone)
+    {
+        if (progress && bytesDone / 0x100000 < totalProgress)
+            progress(arg, (DWORD)(bytesDone / 0x100000), totalProgress);
+    };
+
+    // the pieces of a chunk are all read at once
+    auto readChunk = [&](UINT64 offset, BYTE *buffer, DWORD len)
+    {
+        backup.ReadV({ { offset, len } }, buffer);
+        dropBackupCache(backup, offset, offset + len);
+    };
+
+    // a physical drive is written past the os cache, the backup is read into each buffer as it comes up
+    if (DeviceIO *device = physicalDevice(io.get()))
+    {
+        UINT64 bytesRead = 0;
+        device->BulkWrite(0, backupLen, [&](BYTE *buffer, DWORD len)
+        {
+            readChunk(bytesRead, buffer, len);
+            bytesRead += len;
+            reportProgress(bytesRead);
+        });
+    }
+    else
+    {
+        // the backup is read and the drive is written on their own threads, so the two overlap
+        CopyPipeline pipeline;
+        pipeline.SetProgress(reportProgress);
+        pipeline.Run([&](UINT64 chunk, BYTE *buffer)
+        {
+            UINT64 offset = chunk * COPYPIPELINE_DEFAULT_BUFFER_SIZE;
+            if (offset >= backupLen)
+                return (DWORD)0;
+
+            DWORD len = (DWORD)std::min<UINT64>(backupLen - offset, COPYPIPELINE_DEFAULT_BUFFER_SIZE);
+            readChunk(offset, buffer, len);
+            return len;
+        },
+        [&](UINT64 chunk, const BYTE *buffer, DWORD len)
+        {
+            io->WriteAt(chunk * COPYPIPELINE_DEFAULT_BUFFER_SIZE, const_cast<BYTE*>(buffer), len);
+        });
     }
 
     if (progress)
         progress(arg, totalProgress, totalProgress);
 
-#ifdef _WIN32
-    CloseHandle(hFile);
-#else
-    close(backupFile);
-#endif
+    backup.Close();
 
     // reload the entire drive
     ReloadDrive();
 }
 
+void FatxDrive::restoreSparseBackup(BigFileIO &backup, void (*progress)(void *, DWORD, DWORD), void *arg)
+{
+    UINT64 backupLen = backup.Length();
+
+    BYTE fixedHeader[0x14];
+    if (backupLen < sizeof(fixedHeader))
+        throw std::string("FATX: Sparse backup is corrupt.\n");
+    backup.ReadAt(0, fixedHeader, sizeof(fixedHeader));
+
+    MemoryIO header(fixedHeader, sizeof(fixedHeader));
+    header.SetPosition(4);
+    if (header.ReadDword() != FATX_SPARSE_BACKUP_VERSION)
+        throw std::string("FATX: Sparse backup was made by a newer version.\n");
+    if (header.ReadUInt64() != io->Length())
+        throw std::string("FATX: Sparse backup is of a drive with a different size.\n");
+
+    DWORD extentCount = header.ReadDword();
+    UINT64 tableLen = (UINT64)extentCount * (sizeof(UINT64) + sizeof(DWORD));
+    if (tableLen > backupLen - sizeof(fixedHeader))
+        throw std::string("FATX: Sparse backup is corrupt.\n");
+
+    // the whole range table is read at once
+    std::vector<BYTE> table((size_t)tableLen);
+    if (!table.empty())
+        backup.ReadAt(sizeof(fixedHeader), table.data(), (DWORD)tableLen);
+
+    MemoryIO tableIO(table.data(), table.size());
+    std::vector<Extent> extents(extentCount);
+    UINT64 dataLen = 0;
+    for (Extent &extent : extents)
+    {
+        extent.offset = tableIO.ReadUInt64();
+        extent.length = tableIO.ReadDword();
+        if (extent.offset > io->Length() || extent.length > io->Length() - extent.offset)
+            throw std::string("FATX: Sparse backup is corrupt.\n");
+
+        dataLen += extent.length;
+    }
+
+    UINT64 dataStart = (sizeof(fixedHeader) + tableLen + FATX_SPARSE_BACKUP_ALIGNMENT - 1) &
+            ~(UINT64)(FATX_SPARSE_BACKUP_ALIGNMENT - 1);
+    if (dataStart > backupLen || dataLen > backupLen - dataStart)
+        throw std::string("FATX: Sparse backup is corrupt.\n");
+
+    UINT64 totalProgress = dataLen / 0x100000;
+    auto reportProgress = [&](UINT64 bytesDone)
+    {
+        if (progress && bytesDone / 0x100000 < totalProgress)
+            progress(arg, (DWORD)(bytesDone / 0x100000), totalProgress);
+    };
+
+    std::vector<std::vector<Extent>> batches = AsyncIO::SplitExtents(extents, COPYPIPELINE_DEFAULT_BUFFER_SIZE);
+
+    // the backup is read a buffer at a time, and each buffer is scattered across the ranges it covers
+    CopyPipeline pipeline;
+    pipeline.SetProgress(reportProgress);
+    pipeline.Run([&](UINT64 chunk, BYTE *buffer)
+    {
+        if (chunk >= batches.size())
+            return (DWORD)0;
+
+        DWORD len = 0;
+        for (const Extent &extent : batches.at(chunk))
+            len += extent.length;
+
+        UINT64 offset = dataStart + chunk * COPYPIPELINE_DEFAULT_BUFFER_SIZE;
+        backup.ReadV({ { offset, len } }, buffer);
+        dropBackupCache(backup, offset, offset + len);
+        return len;
+    },
+    [&](UINT64 chunk, const BYTE *buffer, DWORD)
+    {
+        io->WriteV(batches.at(chunk), const_cast<BYTE*>(buffer));
+    });
+
+    if (progress)
+        progress(arg, totalProgress, totalProgress);
+}
+
 BYTE FatxDrive::cntlzw(DWORD x)
 {
     if (x == 0)
@@ -770,30 +1360,6 @@ void FatxDrive::loadProfiles()
     GetChildFileEntries(contentRoot);
 }
 
-void FatxDrive::injectRange(vector<DWORD> &clusters, Range &range)
-{
-    // do a binary search to find the position to inject the clusters
-    int start = 0, end = clusters.size() - 1, pos = 0;
-    while (start < end)
-    {
-        pos = (start + end) / 2;
-        if (clusters.at(pos) < range.start)
-            start = pos + 1;
-        else if (clusters.at(pos) > range.start)
-            end = pos - 1;
-        else if (clusters.at(pos) == range.start)
-            throw std::string("FATX: Error freeing cluster, cluster already free.\n");
-    }
-
-    // generate the range of clusters to inject
-    vector<DWORD> sillyRange;
-    for (DWORD i = 0; i < range.len; i++)
-        sillyRange.push_back(range.start + i);
-
-    // insert that range, yo
-    clusters.insert(clusters.begin() + start, sillyRange.begin(), sillyRange.end());
-}
-
 void FatxDrive::loadFatxDrive(std::wstring drivePath)
 {
     if (type == FatxHarddrive)
@@ -820,6 +1386,11 @@ void FatxDrive::loadFatxDrive(std::wstring drivePath)
 
 void FatxDrive::loadFatxDrive()
 {
+    // see what the drive is being asked for when tracing is turned on
+    if (TracingIO::Enabled() && dynamic_cast<TracingIO*>(io.get()) == nullptr)
+        io = std::make_unique<TracingIO>(std::move(io), "FatxDrive");
+    TracingIO::Operation trace("FatxDrive::LoadDevice");
+
     // parse the security blob
     if (type == FatxHarddrive)
     {
@@ -938,74 +1509,81 @@ void FatxDrive::loadFatxDrive()
     // process all bootsectors
     for (size_t i = 0; i < this->partitions.size(); )
     {
-        processBootSector(this->partitions.at(i).get());
+        Partition *part = this->partitions.at(i).get();
+        processBootSector(part);
 
         // if there's invalid magic
-        if (this->partitions.at(i)->address == 0)
+        if (part->address == 0)
         {
             partitions.erase(partitions.begin() + i);
+            continue;
         }
-        else
-            i++;
+
+        // io has been wrapped for tracing by now, so the chainmap's reads and writes are traced too
+        part->chainmap = std::make_unique<FatxChainmap>(io.get(), part->address + FATX_HEADER_SIZE,
+                part->chainmapSize, part->clusterEntrySize);
+        i++;
     }
 }
 
 UINT64 FatxDrive::GetFreeMemory(Partition *part, void(*progress)(void*, bool), void *arg, bool finish)
 {
-    if (part->freeMemory != 0)
-        return (UINT64)part->freeClusters.size() * (UINT64)part->clusterSize;
+    TracingIO::Operation trace("FatxDrive::GetFreeMemory");
 
-    // allocate memory for a buffer to minimize the amount of reads
-    std::vector<BYTE> buffer(0x50000);
+    if (part->freeClusters.IsBuilt())
+        return part->freeClusters.FreeCount() * (UINT64)part->clusterSize;
 
-    // seek to the chainmap
-    io->SetPosition(part->address + 0x1000);
+    part->freeClusters.Reset(part->clusterCount);
 
-    // check if it's FAT16
-    bool clusterSizeIs2 = (part->clusterEntrySize == FAT16);
+    DWORD threadCount = std::clamp<DWORD>(std::thread::hardware_concurrency(), 1, FATX_FREE_SCAN_MAX_THREADS);
+    BYTE entrySize = part->clusterEntrySize;
+    DWORD clusterCount = part->clusterCount;
+    std::deque<std::future<std::vector<FatxClusterRun>>> scans;
 
-    UINT64 bytesLeft = (UINT64)part->clusterCount * (UINT64)part->clusterEntrySize;
-    DWORD readSize;
-    DWORD x = 0;
-    while (bytesLeft > 0)
+    // the runs go to the allocator in order, one that was split between two chunks joins back up there
+    auto finishOldestScan = [&]()
     {
-        // calculate the read size
-        readSize = (bytesLeft > 0x50000) ? 0x50000 : bytesLeft;
-        bytesLeft -= readSize;
+        for (const FatxClusterRun &run : scans.front().get())
+            part->freeClusters.Free(run.start, run.count);
+        scans.pop_front();
+    };
 
-        // read in the segment
-        io->ReadBytes(buffer.data(), readSize);
-        MemoryIO memory(buffer.data(), 0x50000);
-        memory.SetPosition(0);
+    try
+    {
+        // each chunk of the chainmap is scanned on a worker thread while the next one is read
+        part->chainmap->ForEachChunk([&](const BYTE *entries, DWORD firstCluster, DWORD entryCount)
+        {
+            // cluster 0 isn't a data cluster, and there's room in the chainmap for more entries than clusters
+            DWORD begin = std::max<DWORD>(firstCluster, 1);
+            DWORD end = (DWORD)std::min<UINT64>((UINT64)firstCluster + entryCount, (UINT64)clusterCount + 1);
+            if (begin >= end)
+                return;
 
-        // update progress if needed
-        if (progress)
-            progress(arg, false);
+            if (scans.size() >= threadCount)
+                finishOldestScan();
 
-        // iterate through all of the clusters
-        if (clusterSizeIs2)
-        {
-            for (DWORD i = 0; i < (readSize / 2); i++)
+            const BYTE *scanStart = entries + (UINT64)(begin - firstCluster) * entrySize;
+            scans.push_back(std::async(std::launch::async, [=]()
             {
-                if (memory.ReadWord() == FAT_CLUSTER16_AVAILABLE)
-                    part->freeClusters.push_back(x + i);
-            }
-            x += 0x28000;
-        }
-        else
-        {
-            for (DWORD i = 0; i < (readSize / 4); i++)
-            {
-                DWORD test = memory.ReadDword();
-                if (test == FAT_CLUSTER_AVAILABLE)
-                    part->freeClusters.push_back(x + i);
-            }
-            x += 0x14000;
-        }
+                std::vector<FatxClusterRun> runs;
+                FatxChainmap::FindFreeRuns(scanStart, entrySize, begin, end - begin, runs);
+                return runs;
+            }));
+        }, progress, arg);
+
+        while (!scans.empty())
+            finishOldestScan();
+    }
+    catch (...)
+    {
+        // don't leave half the free clusters behind, the next call scans again
+        scans.clear();
+        part->freeClusters = FatxClusterAllocator();
+        throw;
     }
 
     // calculate the amount of free memory
-    part->freeMemory = (UINT64)part->freeClusters.size() * (UINT64)part->clusterSize;
+    part->freeMemory = part->freeClusters.FreeCount() * (UINT64)part->clusterSize;
 
     if (progress)
         progress(arg, finish);
@@ -1029,10 +1607,191 @@ UINT64 FatxDrive::GetDeviceSize()
 
 void FatxDrive::ReloadDrive()
 {
+    pathIndex.clear();
     partitions.clear();
     loadFatxDrive();
 }
 
+std::string FatxDrive::GetDriveIdentity()
+{
+    if (type == FatxHarddrive)
+        return securityBlob.serialNumber;
+    return Utils::ConvertToHexString(configurationData.deviceID, 0x14);
+}
+
+void FatxDrive::SaveSnapshot(std::string path)
+{
+    TracingIO::Operation trace("FatxDrive::SaveSnapshot");
+
+    MemoryIO snapshot;
+    snapshot.Write((DWORD)FATX_SNAPSHOT_MAGIC);
+    snapshot.Write((DWORD)FATX_SNAPSHOT_VERSION);
+
+    std::string identity = GetDriveIdentity();
+    snapshot.Write((DWORD)identity.size());
+    snapshot.Write((BYTE*)identity.data(), (DWORD)identity.size());
+
+    snapshot.Write((DWORD)partitions.size());
+    for (std::unique_ptr<Partition> &part : partitions)
+    {
+        snapshot.Write((UINT64)part->address);
+        snapshot.Write(part->size);
+        snapshot.Write(part->clusterSize);
+        snapshot.Write(part->clusterCount);
+        snapshot.Write(part->rootDirectoryCluster);
+        snapshot.Write(part->clusterEntrySize);
+
+        BYTE digest[0x14];
+        partitionDigest(io.get(), part.get(), digest);
+        snapshot.Write(digest, 0x14);
+
+        // the free clusters are only saved if they've been found
+        snapshot.Write((BYTE)part->freeClusters.IsBuilt());
+        if (part->freeClusters.IsBuilt())
+        {
+            const std::map<DWORD, DWORD> &runs = part->freeClusters.Runs();
+            snapshot.Write((DWORD)runs.size());
+            for (const auto &run : runs)
+            {
+                snapshot.Write(run.first);
+                snapshot.Write(run.second);
+            }
+        }
+
+        snapshot.Write((BYTE)part->indexed);
+        writeSnapshotTree(snapshot, &part->root);
+        writeSnapshotHeaders(snapshot, part.get());
+    }
+
+    snapshot.SaveToFile(path);
+}
+
+bool FatxDrive::LoadSnapshot(std::string path)
+{
+    TracingIO::Operation trace("FatxDrive::LoadSnapshot");
+
+    // entries that have already been handed out can't be swapped for the ones in the snapshot
+    for (std::unique_ptr<Partition> &part : partitions)
+    {
+        if (part->root.readDirectories)
+            return false;
+    }
+
+    // nothing's changed until the whole snapshot has been read and checked
+    struct SnapshotPartition
+    {
+        FatxFileEntry root;
+        bool freeClustersBuilt;
+        std::vector<FatxClusterRun> freeRuns;
+        bool indexed;
+        std::map<INT64, FatxCachedHeader> headers;
+    };
+    std::vector<SnapshotPartition> loaded(partitions.size());
+
+    try
+    {
+        FileIO file(path);
+        MemoryIO snapshot(&file);
+        file.Close();
+
+        if (snapshot.ReadDword() != FATX_SNAPSHOT_MAGIC || snapshot.ReadDword() != FATX_SNAPSHOT_VERSION)
+            return false;
+
+        DWORD identityLength = snapshot.ReadDword();
+        if (identityLength > snapshot.Length() - snapshot.GetPosition())
+            return false;
+        std::string identity(identityLength, '\0');
+        snapshot.ReadBytes((BYTE*)identity.data(), identityLength);
+        if (identity != GetDriveIdentity() || snapshot.ReadDword() != partitions.size())
+            return false;
+
+        for (size_t i = 0; i < partitions.size(); i++)
+        {
+            Partition *part = partitions.at(i).get();
+            SnapshotPartition &snapshotPart = loaded.at(i);
+
+            if (snapshot.ReadUInt64() != (UINT64)part->address || snapshot.ReadUInt64() != part->size ||
+                    snapshot.ReadDword() != part->clusterSize || snapshot.ReadDword() != part->clusterCount ||
+                    snapshot.ReadDword() != part->rootDirectoryCluster ||
+                    snapshot.ReadByte() != part->clusterEntrySize)
+                return false;
+
+            // this is where the drive is actually checked, everything after it is taken as it is
+            BYTE savedDigest[0x14], digest[0x14];
+            snapshot.ReadBytes(savedDigest, 0x14);
+            partitionDigest(io.get(), part, digest);
+            if (memcmp(savedDigest, digest, 0x14) != 0)
+                return false;
+
+            snapshotPart.freeClustersBuilt = snapshot.ReadByte() != 0;
+            if (snapshotPart.freeClustersBuilt)
+            {
+                DWORD runCount = snapshot.ReadDword();
+                if ((UINT64)runCount * 8 > snapshot.Length() - snapshot.GetPosition())
+                    return false;
+
+                // the runs have to be in order and within the partition, so they can't fail to be freed later
+                UINT64 previousEnd = 1;
+                for (DWORD x = 0; x < runCount; x++)
+                {
+                    FatxClusterRun run;
+                    run.start = snapshot.ReadDword();
+                    run.count = snapshot.ReadDword();
+                    if (run.count == 0 || run.start < previousEnd ||
+                            (UINT64)run.start + run.count > (UINT64)part->clusterCount + 1)
+                        return false;
+
+                    previousEnd = (UINT64)run.start + run.count;
+                    snapshotPart.freeRuns.push_back(run);
+                }
+            }
+
+            snapshotPart.indexed = snapshot.ReadByte() != 0;
+
+            snapshotPart.root.partition = part;
+            snapshotPart.root.name = part->root.name;
+            snapshotPart.root.path = part->root.path;
+            snapshotPart.root.startingCluster = part->root.startingCluster;
+            snapshotPart.root.fileAttributes = part->root.fileAttributes;
+            readSnapshotTree(snapshot, &snapshotPart.root);
+            readSnapshotHeaders(snapshot, snapshotPart.headers);
+        }
+    }
+    catch (...)
+    {
+        // a snapshot that's missing or can't be read just means the drive gets read like usual
+        return false;
+    }
+
+    for (size_t i = 0; i < partitions.size(); i++)
+    {
+        Partition *part = partitions.at(i).get();
+        SnapshotPartition &snapshotPart = loaded.at(i);
+
+        part->root.cachedFiles = std::move(snapshotPart.root.cachedFiles);
+        part->root.readDirectories = snapshotPart.root.readDirectories;
+        part->root.fileSize = snapshotPart.root.fileSize;
+
+        if (snapshotPart.freeClustersBuilt)
+        {
+            part->freeClusters.Reset(part->clusterCount);
+            for (const FatxClusterRun &run : snapshotPart.freeRuns)
+                part->freeClusters.Free(run.start, run.count);
+            part->freeMemory = part->freeClusters.FreeCount() * (UINT64)part->clusterSize;
+        }
+
+        if (snapshotPart.indexed)
+        {
+            part->indexed = true;
+            indexEntries(&part->root);
+        }
+
+        part->cachedHeaders = std::move(snapshotPart.headers);
+    }
+
+    return true;
+}
+
 bool FatxDrive::FileExists(std::string filePath)
 {
     return !!GetFileEntry(filePath);
@@ -1091,6 +1850,19 @@ FatxFileEntry* FatxDrive::GetFileEntry(std::string filePath)
     if (part == NULL)
         return NULL;
 
+    // entries can be renamed without the index knowing, so only trust it when the entry still has the path
+    if (part->indexed)
+    {
+        std::string fullPath = "Drive:\\" + partitionName;
+        if (!filePath.empty())
+            fullPath += "\\" + filePath.substr(0, filePath.find_last_not_of('\\') + 1);
+
+        auto indexed = pathIndex.find(fullPath);
+        if (indexed != pathIndex.end() && indexed->second->nameLen != FATX_ENTRY_DELETED &&
+                indexed->second->path + indexed->second->name == fullPath)
+            return indexed->second;
+    }
+
     FatxFileEntry *parent = &part->root;
     while ((int)filePath.find('\\') >= 0 || filePath.size() > 0)
     {
@@ -1,8 +1,32 @@
 #include <XboxInternals/Fatx/XContentDevice.h>
 
+#include <algorithm>
 #include <filesystem>
 #include <memory>
 
+// the largest package header that's kept in drive snapshots, real ones are 0xB000 bytes at most
+#define XCONTENT_DEVICE_MAX_CACHED_HEADER 0x10000
+
+namespace
+{
+
+// the metadata of a package read from the header the drive kept for it, without opening the package
+class CachedContentHeader : public IXContentHeader
+{
+public:
+    CachedContentHeader(const std::vector<BYTE> &header) :
+        io(header), header(&io)
+    {
+        metaData = &this->header;
+    }
+
+private:
+    MemoryIO io;
+    XContentHeader header;
+};
+
+}
+
 XContentDevice::XContentDevice(FatxDrive *drive) :
     drive(drive), content(nullptr)
 {
@@ -71,6 +95,9 @@ bool XContentDevice::LoadDevice(void(*progress)(void*, bool), void *arg)
 
     GetFreeMemory(progress, arg, false);
 
+    // read every folder up front, the lookups below are then answered from the index
+    drive->IndexPartition(content, progress, arg);
+
     FatxFileEntry *fileEntry = drive->GetFileEntry("Drive:\\Content\\Content\\");
     if (fileEntry == nullptr)
     {
@@ -88,7 +115,7 @@ bool XContentDevice::LoadDevice(void(*progress)(void*, bool), void *arg)
     // check for profile folders
     for (int i = 0; i< fileEntry->cachedFiles.size(); i++)
     {
-        FatxFileEntry profileFolderEntry = fileEntry->cachedFiles.at(i);
+        FatxFileEntry &profileFolderEntry = fileEntry->cachedFiles.at(i);
 
         // all profile folders are named the profile's offline XUID
         if ((profileFolderEntry.fileAttributes & FatxDirectory) == 0 || !ValidOfflineXuid(profileFolderEntry.name) || profileFolderEntry.nameLen == 0xE5)
@@ -102,8 +129,13 @@ bool XContentDevice::LoadDevice(void(*progress)(void*, bool), void *arg)
         {
             try
             {
-                FatxIO io = drive->GetFatxIO(profileEntry);
-                profilePackage = std::make_shared<StfsPackage>(new FatxIO(io), StfsPackageDeleteIO);
+                profilePackage = CachedContent(profileEntry);
+                if (!profilePackage)
+                {
+                    FatxIO io = drive->GetFatxIO(profileEntry);
+                    profilePackage = std::make_shared<StfsPackage>(new FatxIO(io), StfsPackageDeleteIO);
+                    CacheContentHeader(profileEntry, profilePackage.get());
+                }
             }
             catch (...)
             {
@@ -122,7 +154,7 @@ bool XContentDevice::LoadDevice(void(*progress)(void*, bool), void *arg)
         for (int x = 0; x < profileFolderEntry.cachedFiles.size(); x++)
         {
             // verify that the entry is a valid title folder, should be named with title ID
-            FatxFileEntry titleFolder = profileFolderEntry.cachedFiles.at(x);
+            FatxFileEntry &titleFolder = profileFolderEntry.cachedFiles.at(x);
             if ((titleFolder.fileAttributes & FatxDirectory) == 0 || !ValidTitleID(titleFolder.name) || titleFolder.name == "FFFE07D1" || titleFolder.nameLen == 0xE5)
                 continue;
 
@@ -161,7 +193,7 @@ bool XContentDevice::LoadDevice(void(*progress)(void*, bool), void *arg)
     for (int i = 0; i < sharedItemsFolder->cachedFiles.size(); i++)
     {
         // verify that the entry is a valid title folder, should be named with title ID
-        FatxFileEntry titleFolder = sharedItemsFolder->cachedFiles.at(i);
+        FatxFileEntry &titleFolder = sharedItemsFolder->cachedFiles.at(i);
         if ((titleFolder.fileAttributes & FatxDirectory) == 0 || !ValidTitleID(titleFolder.name) || titleFolder.nameLen == 0xE5)
             continue;
 
@@ -586,7 +618,7 @@ void XContentDevice::GetAllContentItems(FatxFileEntry &titleFolder, vector<XCont
     {
         // verify that the entry is a folder and named with the content type as a string in hex,
         // so for savegames the folder would be named 00000001
-        FatxFileEntry contentTypeFolder = titleFolder.cachedFiles.at(y);
+        FatxFileEntry &contentTypeFolder = titleFolder.cachedFiles.at(y);
         if ((contentTypeFolder.fileAttributes & FatxDirectory) == 0 || !ValidTitleID(contentTypeFolder.name) || contentTypeFolder.nameLen == 0xE5)
             continue;
 
@@ -620,16 +652,22 @@ void XContentDevice::GetAllContentItems(FatxFileEntry &titleFolder, vector<XCont
             std::vector<std::string> contentFilePaths;
             try
             {
-                FatxIO io = drive->GetFatxIO(entry);
-
-                if (fileSystem == FileSystemSTFS)
+                content = CachedContent(entry);
+                if (!content && fileSystem == FileSystemSTFS)
                 {
+                    FatxIO io = drive->GetFatxIO(entry);
                     content = std::make_shared<StfsPackage>(new FatxIO(io), StfsPackageDeleteIO | StfsPackageDontReadFileListing);
+                    CacheContentHeader(entry, content.get());
+                }
+                else if (!content && fileSystem == FileSystemSVOD)
+                {
+                    content = std::make_shared<SVOD>(entry->path + entry->name, drive, false);
+                    CacheContentHeader(entry, content.get());
                 }
-                else if (fileSystem == FileSystemSVOD)
+
+                if (fileSystem == FileSystemSVOD)
                 {
                     std::string rootFilePath = entry->path + entry->name;
-                    content = std::make_shared<SVOD>(rootFilePath, drive, false);
 
                     // SVOD systems have data files where the actual content is stored; they're in a folder in the same
                     // directory as the header file with the name {HEADER_FILE_NAME}.data
@@ -638,7 +676,7 @@ void XContentDevice::GetAllContentItems(FatxFileEntry &titleFolder, vector<XCont
                     for (size_t i = 0; i < dataFileDirectory->cachedFiles.size(); i++)
                     {
                         // skip over deleted files
-                        FatxFileEntry curEntry = dataFileDirectory->cachedFiles.at(i);
+                        FatxFileEntry &curEntry = dataFileDirectory->cachedFiles.at(i);
                         if (curEntry.nameLen == FATX_ENTRY_DELETED)
                             continue;
 
@@ -662,6 +700,36 @@ void XContentDevice::GetAllContentItems(FatxFileEntry &titleFolder, vector<XCont
     }
 }
 
+std::shared_ptr<IXContentHeader> XContentDevice::CachedContent(FatxFileEntry *entry)
+{
+    const std::vector<BYTE> *header = drive->GetCachedContentHeader(entry);
+    if (header == nullptr)
+        return nullptr;
+
+    try
+    {
+        return std::make_shared<CachedContentHeader>(*header);
+    }
+    catch (...)
+    {
+        // the package gets opened instead
+        return nullptr;
+    }
+}
+
+void XContentDevice::CacheContentHeader(FatxFileEntry *entry, IXContentHeader *content)
+{
+    // the whole header, so the metadata is read from it the same way it's read from the package
+    UINT64 length = std::min<UINT64>(((UINT64)content->metaData->headerSize + 0xFFF) & ~0xFFFULL, entry->fileSize);
+    if (length > XCONTENT_DEVICE_MAX_CACHED_HEADER)
+        return;
+
+    std::vector<BYTE> header(length);
+    FatxIO io = drive->GetFatxIO(entry);
+    io.ReadAt(0, header.data(), (DWORD)length);
+    drive->CacheContentHeader(entry, std::move(header));
+}
+
 void XContentDevice::CleanupSharedFiles(std::vector<XContentDeviceSharedItem> *category)
 {
     if (category == nullptr)
@@ -2,9 +2,9 @@
 #include <utility>
 
 
-GpdBase::GpdBase(shared_ptr<FileIO> io) : io(std::move(io))
+GpdBase::GpdBase(shared_ptr<FileIO> io) : io(io)
 {
-    xdbf = std::make_unique<Xdbf>(this->io);
+    xdbf = std::make_unique<Xdbf>(std::move(io));
     init();
 }
 
@@ -1,14 +1,22 @@
 #include <XboxInternals/Gpd/Xdbf.h>
+#include <XboxInternals/IO/MemoryIO.h>
 #include <stdio.h>
 #include <filesystem>
 #include <random>
 #include <utility>
 
-Xdbf::Xdbf(const string &gpdPath) : Xdbf(std::make_shared<FileIO>(gpdPath))
+Xdbf::Xdbf(const string &gpdPath, bool mapFile) :
+    Xdbf(mapFile ? shared_ptr<BaseIO>(std::make_shared<MappedFileIO>(gpdPath)) :
+            shared_ptr<BaseIO>(std::make_shared<FileIO>(gpdPath)), gpdPath, mapFile)
 {
 }
 
-Xdbf::Xdbf(shared_ptr<FileIO> io) : io(std::move(io))
+Xdbf::Xdbf(shared_ptr<FileIO> io) : Xdbf(io, io->GetFilePath(), false)
+{
+}
+
+Xdbf::Xdbf(shared_ptr<BaseIO> io, const string &filePath, bool mapFile) :
+    io(std::move(io)), filePath(filePath), mapFile(mapFile)
 {
     init();
     readHeader();
@@ -16,6 +24,13 @@ Xdbf::Xdbf(shared_ptr<FileIO> io) : io(std::move(io))
     readFreeMemoryTable();
 }
 
+shared_ptr<BaseIO> Xdbf::openFile(const string &path)
+{
+    if (mapFile)
+        return std::make_shared<MappedFileIO>(path);
+    return std::make_shared<FileIO>(path);
+}
+
 void Xdbf::Clean()
 {
     // Create a temporary file using C++17 filesystem (cross-platform)
@@ -68,7 +83,7 @@ void Xdbf::Clean()
     tempFile.Close();
     io->Close();
 
-    const string originalPath = io->GetFilePath();
+    const string originalPath = filePath;
 
     // delete the original file
     remove(originalPath.c_str());
@@ -76,7 +91,7 @@ void Xdbf::Clean()
     // move the temp file to the old file's location
     rename(tempFileName.c_str(), originalPath.c_str());
 
-    io = std::make_shared<FileIO>(originalPath);
+    io = openFile(originalPath);
 
     // Write the updated entry table
     WriteEntryListing();
@@ -179,26 +194,45 @@ void Xdbf::readHeader()
 
 void Xdbf::readEntryTable()
 {
-    // seek to the beginning of the entry table
-    io->SetPosition(0x18);
+    // the last group needs a blank entry after it to stop on. A mapped gpd with room to spare in its table
+    // already has one, so it's read in place, otherwise the whole table is read in one go with one added
+    DWORD tableLength = header.entryTableLength * 0x12;
+    std::vector<BYTE> tableBuffer;
+    BYTE *tableData;
+    size_t tableDataLength;
+    MappedFileIO *mappedIO = dynamic_cast<MappedFileIO*>(io.get());
+    if (mappedIO && header.entryCount < header.entryTableLength)
+    {
+        tableData = const_cast<BYTE*>(mappedIO->View(0x18, tableLength).data());
+        tableDataLength = tableLength;
+    }
+    else
+    {
+        tableBuffer.resize(tableLength + 0x12, 0);
+        io->ReadAt(0x18, tableBuffer.data(), tableLength);
+        tableData = tableBuffer.data();
+        tableDataLength = tableBuffer.size();
+    }
+
+    MemoryIO table(tableData, tableDataLength);
 
     // read achievement table entries
-    readEntryGroup(&achievements, Achievement);
+    readEntryGroup(&achievements, Achievement, &table);
 
     // read images
-    readEntryGroup(&images, Image);
+    readEntryGroup(&images, Image, &table);
 
     // read setting table entries
-    readEntryGroup(&settings, Setting);
+    readEntryGroup(&settings, Setting, &table);
 
     // read title table entries
-    readEntryGroup(&titlesPlayed, Title);
+    readEntryGroup(&titlesPlayed, Title, &table);
 
     // read strings
-    readEntryGroup(&strings, String);
+    readEntryGroup(&strings, String, &table);
 
     // read avatar award table entries
-    readEntryGroup(&avatarAwards, AvatarAward);
+    readEntryGroup(&avatarAwards, AvatarAward, &table);
 }
 
 SyncData Xdbf::readSyncData(XdbfEntry entry)
@@ -315,10 +349,13 @@ void Xdbf::readFreeMemoryTable()
     DWORD tableStartAddr = 0x18 + (header.entryTableLength * 0x12);
     io->SetPosition(tableStartAddr);
 
-    // iterate through all of the free memory table entries
+    // the table is just pairs of dwords, so decode all of it at once
+    std::vector<DWORD> table(header.freeMemTableEntryCount * 2);
+    io->ReadArray<DWORD>(table);
+
     for (DWORD i = 0; i < header.freeMemTableEntryCount; i++)
     {
-        XdbfFreeMemEntry entry = { io->ReadDword(), io->ReadDword() };
+        XdbfFreeMemEntry entry = { table.at(i * 2), table.at(i * 2 + 1) };
         freeMemory.push_back(entry);
     }
 }
@@ -549,9 +586,10 @@ void Xdbf::updateFreeMemTable()
     freeMemory.back().length = 0xFFFFFFFF - len;
 }
 
-void Xdbf::readEntryGroup(XdbfEntryGroup *group, EntryType type)
+void Xdbf::readEntryGroup(XdbfEntryGroup *group, EntryType type, BaseIO *table)
 {
-    XdbfEntry entry = { (EntryType)io->ReadInt16(), io->ReadUInt64(), io->ReadDword(), io->ReadDword() };
+    XdbfEntry entry = { (EntryType)table->ReadInt16(), table->ReadUInt64(), table->ReadDword(),
+            table->ReadDword() };
     group->syncData.entry.type = (EntryType)0;
     group->syncs.entry.type = (EntryType)0;
 
@@ -564,34 +602,34 @@ void Xdbf::readEntryGroup(XdbfEntryGroup *group, EntryType type)
         else
             group->entries.push_back(entry);
 
-        entry.type = (EntryType)io->ReadInt16();
-        entry.id = io->ReadUInt64();
-        entry.addressSpecifier = io->ReadDword();
-        entry.length = io->ReadDword();
+        entry.type = (EntryType)table->ReadInt16();
+        entry.id = table->ReadUInt64();
+        entry.addressSpecifier = table->ReadDword();
+        entry.length = table->ReadDword();
     }
 
-    // back the io up 1 entry
-    io->SetPosition((DWORD)io->GetPosition() - 0x12);
+    // back the table up 1 entry
+    table->SetPosition(table->GetPosition() - 0x12);
 }
 
-void Xdbf::readEntryGroup(vector<XdbfEntry> *group, EntryType type)
+void Xdbf::readEntryGroup(vector<XdbfEntry> *group, EntryType type, BaseIO *table)
 {
     XdbfEntry entry;
 
     while (true)
     {
-        entry.type = (EntryType)io->ReadInt16();
-        entry.id = io->ReadUInt64();
-        entry.addressSpecifier = io->ReadDword();
-        entry.length = io->ReadDword();
+        entry.type = (EntryType)table->ReadInt16();
+        entry.id = table->ReadUInt64();
+        entry.addressSpecifier = table->ReadDword();
+        entry.length = table->ReadDword();
 
         if (entry.type != type)
             break;
         group->push_back(entry);
     }
 
-    // back the io up 1 entry
-    io->SetPosition((DWORD)io->GetPosition() - 0x12);
+    // back the table up 1 entry
+    table->SetPosition(table->GetPosition() - 0x12);
 }
 
 void Xdbf::WriteEntryListing()
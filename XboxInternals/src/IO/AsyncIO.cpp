@@ -0,0 +1,638 @@
+#include <XboxInternals/IO/AsyncIO.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <string.h>
+#include <thread>
+#include <utility>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define ASYNCIO_HAS_URING 1
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+// amount of threads used to run reads when io_uring isn't available
+#define ASYNC_WORKER_THREADS 8
+
+class ReadCompletion::State
+{
+public:
+    virtual ~State() = default;
+    virtual void Wait() = 0;
+    virtual bool IsComplete() = 0;
+};
+
+ReadCompletion::ReadCompletion()
+{
+}
+
+ReadCompletion::ReadCompletion(std::shared_ptr<State> state) : state(std::move(state))
+{
+}
+
+void ReadCompletion::Wait()
+{
+    if (state)
+        state->Wait();
+}
+
+bool ReadCompletion::IsComplete()
+{
+    return !state || state->IsComplete();
+}
+
+namespace
+{
+
+// run the read, turning whatever it throws into an error message
+bool runRead(const std::function<void(const ReadRequest&)> &readFunction, const ReadRequest &request,
+        std::string &error)
+{
+    try
+    {
+        readFunction(request);
+        return true;
+    }
+    catch (const std::string &ex)
+    {
+        error = ex;
+    }
+    catch (const std::exception &ex)
+    {
+        error = std::string("AsyncIO: ") + ex.what() + "\n";
+    }
+    catch (...)
+    {
+        error = "AsyncIO: Unknown error while reading.\n";
+    }
+    return false;
+}
+
+class WorkerPool
+{
+public:
+    static WorkerPool &Instance()
+    {
+        // never destroyed, so the detached workers can't outlive it at exit
+        static WorkerPool *pool = new WorkerPool();
+        return *pool;
+    }
+
+    void Enqueue(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        condition.notify_one();
+    }
+
+private:
+    WorkerPool()
+    {
+        for (int i = 0; i < ASYNC_WORKER_THREADS; i++)
+            std::thread(&WorkerPool::run, this).detach();
+    }
+
+    void run()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [this] { return !tasks.empty(); });
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<std::function<void()>> tasks;
+};
+
+// bookkeeping shared between a pool batch and the workers running it
+class PoolProgress
+{
+public:
+    explicit PoolProgress(size_t count) : remaining(count)
+    {
+    }
+
+    void Finish(const std::string *requestError)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (requestError && error.empty())
+            error = *requestError;
+
+        if (--remaining == 0)
+            condition.notify_all();
+    }
+
+    // returns the first error hit, or an empty string
+    std::string Wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [this] { return remaining == 0; });
+        return error;
+    }
+
+    bool IsComplete()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return remaining == 0;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable condition;
+    size_t remaining;
+    std::string error;
+};
+
+class PoolState : public ReadCompletion::State
+{
+public:
+    explicit PoolState(std::shared_ptr<PoolProgress> progress) : progress(std::move(progress))
+    {
+    }
+
+    ~PoolState() override
+    {
+        // the workers may still be writing into the caller's buffers
+        progress->Wait();
+    }
+
+    void Wait() override
+    {
+        std::string error = progress->Wait();
+        if (!error.empty())
+            throw error;
+    }
+
+    bool IsComplete() override
+    {
+        return progress->IsComplete();
+    }
+
+private:
+    std::shared_ptr<PoolProgress> progress;
+};
+
+#ifdef ASYNCIO_HAS_URING
+
+// an io_uring and its mapped queues, set up once and then used by one batch of reads at a time
+class UringRing
+{
+public:
+    ~UringRing()
+    {
+        if (sqes)
+            munmap(sqes, sqesSize);
+        if (cqRing && cqRing != sqRing)
+            munmap(cqRing, cqRingSize);
+        if (sqRing)
+            munmap(sqRing, sqRingSize);
+        if (ringFd != -1)
+            close(ringFd);
+    }
+
+    // returns nullptr if a ring couldn't be created
+    static std::unique_ptr<UringRing> Create(unsigned entries)
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+
+        std::unique_ptr<UringRing> ring(new UringRing());
+        ring->ringFd = (int)syscall(__NR_io_uring_setup, entries, &params);
+        if (ring->ringFd < 0)
+        {
+            ring->ringFd = -1;
+            return nullptr;
+        }
+
+        ring->sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        ring->cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap)
+            ring->sqRingSize = ring->cqRingSize = std::max(ring->sqRingSize, ring->cqRingSize);
+
+        ring->sqRing = mmap(nullptr, ring->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                ring->ringFd, IORING_OFF_SQ_RING);
+        if (ring->sqRing == MAP_FAILED)
+        {
+            ring->sqRing = nullptr;
+            return nullptr;
+        }
+
+        if (singleMap)
+            ring->cqRing = ring->sqRing;
+        else
+        {
+            ring->cqRing = mmap(nullptr, ring->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ring->ringFd, IORING_OFF_CQ_RING);
+            if (ring->cqRing == MAP_FAILED)
+            {
+                ring->cqRing = nullptr;
+                return nullptr;
+            }
+        }
+
+        ring->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        ring->sqes = (io_uring_sqe*)mmap(nullptr, ring->sqesSize, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, ring->ringFd, IORING_OFF_SQES);
+        if (ring->sqes == MAP_FAILED)
+        {
+            ring->sqes = nullptr;
+            return nullptr;
+        }
+
+        BYTE *sq = (BYTE*)ring->sqRing;
+        ring->sqTail = (unsigned*)(sq + params.sq_off.tail);
+        ring->sqMask = *(unsigned*)(sq + params.sq_off.ring_mask);
+        ring->sqArray = (unsigned*)(sq + params.sq_off.array);
+        ring->sqEntries = params.sq_entries;
+
+        BYTE *cq = (BYTE*)ring->cqRing;
+        ring->cqHead = (unsigned*)(cq + params.cq_off.head);
+        ring->cqTail = (unsigned*)(cq + params.cq_off.tail);
+        ring->cqMask = *(unsigned*)(cq + params.cq_off.ring_mask);
+        ring->cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+
+        return ring;
+    }
+
+    int ringFd = -1;
+
+    void *sqRing = nullptr;
+    void *cqRing = nullptr;
+    io_uring_sqe *sqes = nullptr;
+    size_t sqRingSize = 0;
+    size_t cqRingSize = 0;
+    size_t sqesSize = 0;
+
+    unsigned *sqTail = nullptr;
+    unsigned *sqArray = nullptr;
+    unsigned sqMask = 0;
+    unsigned sqEntries = 0;
+
+    unsigned *cqHead = nullptr;
+    unsigned *cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe *cqes = nullptr;
+
+private:
+    UringRing() = default;
+};
+
+// the ring each thread keeps between batches, so submitting reads doesn't set up and tear down a ring every time
+thread_local std::unique_ptr<UringRing> idleRing;
+
+// take this thread's idle ring, or make a new one when it's already in use by another batch
+std::unique_ptr<UringRing> acquireRing()
+{
+    if (idleRing)
+        return std::move(idleRing);
+    return UringRing::Create(ASYNC_MAX_READS_IN_FLIGHT);
+}
+
+// keep a ring with nothing left in it for the next batch on this thread
+void releaseRing(std::unique_ptr<UringRing> ring)
+{
+    if (!idleRing)
+        idleRing = std::move(ring);
+}
+
+class UringState : public ReadCompletion::State
+{
+public:
+    UringState(int fd, std::vector<ReadRequest> requests) :
+        fd(fd), requests(std::move(requests)), nextRequest(0), inFlight(0), completed(0)
+    {
+        bytesDone.assign(this->requests.size(), 0);
+        iovecs.resize(this->requests.size());
+    }
+
+    ~UringState() override
+    {
+        // the kernel may still be writing into the caller's buffers
+        if (ring)
+        {
+            try
+            {
+                drain();
+                releaseRing(std::move(ring));
+            }
+            catch (...)
+            {
+            }
+        }
+    }
+
+    // returns false if a ring couldn't be created
+    bool Start()
+    {
+        ring = acquireRing();
+        if (!ring)
+            return false;
+
+        submitPending();
+        return true;
+    }
+
+    void Wait() override
+    {
+        drain();
+        releaseRing(std::move(ring));
+
+        if (!error.empty())
+            throw error;
+    }
+
+    bool IsComplete() override
+    {
+        if (!ring)
+            return true;
+
+        reap();
+        submitPending();
+
+        // after an error nothing new is submitted, so it's done once the reads already in flight land
+        if (!error.empty())
+            return inFlight == 0;
+        return completed == requests.size();
+    }
+
+private:
+    void drain()
+    {
+        while (ring && !IsComplete())
+        {
+            if (syscall(__NR_io_uring_enter, ring->ringFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 &&
+                    errno != EINTR)
+                throw std::string("AsyncIO: Error waiting for reads to complete.\n");
+        }
+    }
+
+    // queue up as many reads as the ring has room for, then hand them to the kernel
+    void submitPending()
+    {
+        unsigned tail = *ring->sqTail;
+        unsigned toSubmit = 0;
+
+        while (inFlight < ring->sqEntries && error.empty())
+        {
+            size_t index;
+            if (!resubmit.empty())
+            {
+                index = resubmit.front();
+                resubmit.pop_front();
+            }
+            else if (nextRequest < requests.size())
+                index = nextRequest++;
+            else
+                break;
+
+            const ReadRequest &request = requests.at(index);
+            iovecs.at(index).iov_base = request.buffer + bytesDone.at(index);
+            iovecs.at(index).iov_len = request.length - bytesDone.at(index);
+
+            unsigned slot = tail & ring->sqMask;
+            io_uring_sqe *sqe = &ring->sqes[slot];
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_READV;
+            sqe->fd = fd;
+            sqe->off = request.offset + bytesDone.at(index);
+            sqe->addr = (unsigned long)&iovecs.at(index);
+            sqe->len = 1;
+            sqe->user_data = index;
+            ring->sqArray[slot] = slot;
+
+            tail++;
+            toSubmit++;
+            inFlight++;
+        }
+
+        if (toSubmit == 0)
+            return;
+
+        __atomic_store_n(ring->sqTail, tail, __ATOMIC_RELEASE);
+
+        while (toSubmit > 0)
+        {
+            int submitted = (int)syscall(__NR_io_uring_enter, ring->ringFd, toSubmit, 0, 0, nullptr, 0);
+            if (submitted < 0)
+            {
+                if (errno == EINTR || errno == EAGAIN)
+                    continue;
+                throw std::string("AsyncIO: Error submitting reads.\n");
+            }
+            toSubmit -= submitted;
+        }
+    }
+
+    // handle all the completions that are ready
+    void reap()
+    {
+        unsigned head = *ring->cqHead;
+        unsigned tail = __atomic_load_n(ring->cqTail, __ATOMIC_ACQUIRE);
+
+        while (head != tail)
+        {
+            io_uring_cqe *cqe = &ring->cqes[head & ring->cqMask];
+            size_t index = (size_t)cqe->user_data;
+            int result = cqe->res;
+            head++;
+            inFlight--;
+
+            if (result == -EINTR || result == -EAGAIN)
+                resubmit.push_back(index);
+            else if (result < 0)
+            {
+                if (error.empty())
+                    error = std::string("AsyncIO: Error reading. ") + strerror(-result) + "\n";
+            }
+            else if (result == 0)
+            {
+                if (error.empty())
+                    error = "AsyncIO: Cannot read beyond the end of the file.\n";
+            }
+            else
+            {
+                bytesDone.at(index) += (DWORD)result;
+
+                // pick up the rest of a short read
+                if (bytesDone.at(index) < requests.at(index).length)
+                    resubmit.push_back(index);
+                else
+                    completed++;
+            }
+        }
+
+        __atomic_store_n(ring->cqHead, head, __ATOMIC_RELEASE);
+    }
+
+    int fd;
+    std::unique_ptr<UringRing> ring;
+
+    std::vector<ReadRequest> requests;
+    std::vector<iovec> iovecs;
+    std::vector<DWORD> bytesDone;
+    std::deque<size_t> resubmit;
+    size_t nextRequest;
+    unsigned inFlight;
+    size_t completed;
+    std::string error;
+};
+
+#endif
+
+}
+
+ReadCompletion AsyncIO::SubmitToDescriptor(int fd, std::vector<ReadRequest> requests,
+        std::function<void(const ReadRequest&)> readFunction)
+{
+    if (requests.empty())
+        return ReadCompletion();
+
+#ifdef ASYNCIO_HAS_URING
+    if (fd != -1 && UringAvailable())
+    {
+        auto state = std::make_shared<UringState>(fd, requests);
+        if (state->Start())
+            return ReadCompletion(state);
+    }
+#else
+    (void)fd;
+#endif
+
+    return SubmitToPool(std::move(requests), std::move(readFunction));
+}
+
+ReadCompletion AsyncIO::SubmitToPool(std::vector<ReadRequest> requests,
+        std::function<void(const ReadRequest&)> readFunction)
+{
+    if (requests.empty())
+        return ReadCompletion();
+
+    auto progress = std::make_shared<PoolProgress>(requests.size());
+    auto sharedFunction = std::make_shared<std::function<void(const ReadRequest&)>>(std::move(readFunction));
+
+    for (const ReadRequest &request : requests)
+    {
+        WorkerPool::Instance().Enqueue([progress, sharedFunction, request]()
+        {
+            std::string error;
+            bool success = runRead(*sharedFunction, request, error);
+            progress->Finish(success ? nullptr : &error);
+        });
+    }
+
+    return ReadCompletion(std::make_shared<PoolState>(progress));
+}
+
+void AsyncIO::AppendReadRequests(std::vector<ReadRequest> &requests, UINT64 offset, BYTE *buffer,
+        DWORD len, DWORD pieceSize)
+{
+    while (len > 0)
+    {
+        DWORD pieceLength = (len > pieceSize) ? pieceSize : len;
+        requests.push_back({ offset, buffer, pieceLength });
+
+        offset += pieceLength;
+        buffer += pieceLength;
+        len -= pieceLength;
+    }
+}
+
+void AsyncIO::AppendExtentRequests(std::vector<ReadRequest> &requests,
+        const std::vector<Extent> &extents, BYTE *buffer, DWORD pieceSize)
+{
+    for (const Extent &extent : MergeExtents(extents))
+    {
+        AppendReadRequests(requests, extent.offset, buffer, extent.length, pieceSize);
+        buffer += extent.length;
+    }
+}
+
+std::vector<Extent> AsyncIO::MergeExtents(const std::vector<Extent> &extents)
+{
+    std::vector<Extent> merged;
+    merged.reserve(extents.size());
+
+    for (const Extent &extent : extents)
+    {
+        if (extent.length == 0)
+            continue;
+
+        // don't let a merged run overflow the length field
+        if (!merged.empty() && merged.back().offset + merged.back().length == extent.offset &&
+                (UINT64)merged.back().length + extent.length <= 0xFFFFFFFF)
+            merged.back().length += extent.length;
+        else
+            merged.push_back(extent);
+    }
+
+    return merged;
+}
+
+std::vector<std::vector<Extent>> AsyncIO::SplitExtents(const std::vector<Extent> &extents,
+        DWORD maxLength)
+{
+    std::vector<std::vector<Extent>> batches;
+    DWORD batchLength = maxLength;
+
+    for (Extent extent : extents)
+    {
+        while (extent.length > 0)
+        {
+            if (batchLength == maxLength)
+            {
+                batches.emplace_back();
+                batchLength = 0;
+            }
+
+            DWORD length = std::min(extent.length, maxLength - batchLength);
+            batches.back().push_back({ extent.offset, length });
+
+            batchLength += length;
+            extent.offset += length;
+            extent.length -= length;
+        }
+    }
+
+    return batches;
+}
+
+bool AsyncIO::UringAvailable()
+{
+#ifdef ASYNCIO_HAS_URING
+    static const bool available = []()
+    {
+        io_uring_params params;
+        memset(&params, 0, sizeof(params));
+
+        int ringFd = (int)syscall(__NR_io_uring_setup, 1, &params);
+        if (ringFd < 0)
+            return false;
+
+        close(ringFd);
+        return true;
+    }();
+    return available;
+#else
+    return false;
+#endif
+}
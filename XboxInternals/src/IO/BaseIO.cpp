@@ -24,17 +24,75 @@ EndianType BaseIO::GetEndian()
     return this->byteOrder;
 }
 
-void BaseIO::reverseByteArray(BYTE *array, DWORD len)
+void BaseIO::ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len)
 {
-    BYTE temp;
-    for (DWORD i = 0; i < len / 2; i++)
+    UINT64 originalPosition = GetPosition();
+
+    SetPosition(offset);
+    ReadBytes(outBuffer, len);
+    SetPosition(originalPosition);
+}
+
+void BaseIO::WriteAt(UINT64 offset, BYTE *buffer, DWORD len)
+{
+    UINT64 originalPosition = GetPosition();
+
+    SetPosition(offset);
+    WriteBytes(buffer, len);
+    SetPosition(originalPosition);
+}
+
+ReadCompletion BaseIO::SubmitReads(std::vector<ReadRequest> requests)
+{
+    for (const ReadRequest &request : requests)
+        ReadAt(request.offset, request.buffer, request.length);
+
+    return ReadCompletion();
+}
+
+void BaseIO::ReadV(const std::vector<Extent> &extents, BYTE *dest)
+{
+    std::vector<ReadRequest> requests;
+    AsyncIO::AppendExtentRequests(requests, extents, dest);
+
+    // not worth setting up a batch for a single read
+    if (requests.size() == 1)
+        ReadAt(requests.at(0).offset, requests.at(0).buffer, requests.at(0).length);
+    else if (!requests.empty())
+        SubmitReads(std::move(requests)).Wait();
+}
+
+void BaseIO::WriteV(const std::vector<Extent> &extents, BYTE *src)
+{
+    for (const Extent &extent : AsyncIO::MergeExtents(extents))
     {
-        temp = array[i];
-        array[i] = array[len - i - 1];
-        array[len - i - 1] = temp;
+        WriteAt(extent.offset, src, extent.length);
+        src += extent.length;
     }
 }
 
+WORD BaseIO::ReadWordAt(UINT64 offset)
+{
+    WORD toReturn;
+    ReadAt(offset, reinterpret_cast<BYTE*>(&toReturn), 2);
+
+    if (byteOrder == BigEndian)
+        toReturn = ByteSwap::Swap(toReturn);
+
+    return toReturn;
+}
+
+DWORD BaseIO::ReadDwordAt(UINT64 offset)
+{
+    DWORD toReturn;
+    ReadAt(offset, reinterpret_cast<BYTE*>(&toReturn), 4);
+
+    if (byteOrder == BigEndian)
+        toReturn = ByteSwap::Swap(toReturn);
+
+    return toReturn;
+}
+
 BYTE BaseIO::ReadByte()
 {
     BYTE toReturn;
@@ -53,7 +111,7 @@ WORD BaseIO::ReadWord()
     ReadBytes(reinterpret_cast<BYTE*>(&toReturn), 2);
 
     if (byteOrder == BigEndian)
-        reverseByteArray(reinterpret_cast<BYTE*>(&toReturn), 2);
+        toReturn = ByteSwap::Swap(toReturn);
 
     return toReturn;
 }
@@ -89,7 +147,7 @@ DWORD BaseIO::ReadDword()
     ReadBytes(reinterpret_cast<BYTE*>(&toReturn), 4);
 
     if (byteOrder == BigEndian)
-        reverseByteArray(reinterpret_cast<BYTE*>(&toReturn), 4);
+        toReturn = ByteSwap::Swap(toReturn);
 
     return toReturn;
 }
@@ -105,7 +163,7 @@ UINT64 BaseIO::ReadUInt64()
     ReadBytes(reinterpret_cast<BYTE*>(&toReturn), 8);
 
     if (byteOrder == BigEndian)
-        reverseByteArray(reinterpret_cast<BYTE*>(&toReturn), 8);
+        toReturn = ByteSwap::Swap(toReturn);
 
     return toReturn;
 }
@@ -200,7 +258,7 @@ void BaseIO::Write(BYTE b)
 void BaseIO::Write(WORD w)
 {
     if (byteOrder == BigEndian)
-        reverseByteArray(reinterpret_cast<BYTE*>(&w), 2);
+        w = ByteSwap::Swap(w);
     WriteBytes(reinterpret_cast<BYTE*>(&w), 2);
 }
 
@@ -212,8 +270,7 @@ void BaseIO::Write(INT24 i24, EndianType et)
 
     if(byteOrder == BigEndian)
     {
-        i24 <<= 8;
-        reverseByteArray(reinterpret_cast<BYTE*>(&i24), 4);
+        i24 = (INT24)ByteSwap::Swap((DWORD)i24 << 8);
     }
     WriteBytes(reinterpret_cast<BYTE*>(&i24), 3);
 
@@ -223,14 +280,14 @@ void BaseIO::Write(INT24 i24, EndianType et)
 void BaseIO::Write(DWORD dw)
 {
     if (byteOrder == BigEndian)
-        reverseByteArray(reinterpret_cast<BYTE*>(&dw), 4);
+        dw = ByteSwap::Swap(dw);
     WriteBytes(reinterpret_cast<BYTE*>(&dw), 4);
 }
 
 void BaseIO::Write(UINT64 u64)
 {
     if (byteOrder == BigEndian)
-        reverseByteArray(reinterpret_cast<BYTE*>(&u64), 8);
+        u64 = ByteSwap::Swap(u64);
     WriteBytes(reinterpret_cast<BYTE*>(&u64), 8);
 }
 
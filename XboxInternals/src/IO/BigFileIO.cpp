@@ -3,18 +3,20 @@
 #include <utility>
 
 #ifndef _WIN32
-#include <fstream>
-#include <memory>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #endif
 
-BigFileIO::BigFileIO(std::string filePath, bool create)
-    : filePath(std::move(filePath))
+BigFileIO::BigFileIO(std::string filePath, bool create, bool readOnly)
+    : filePath(std::move(filePath)), pos(0)
 {
 #ifdef _WIN32
     hFile = INVALID_HANDLE_VALUE;
     DWORD disposition = create ? CREATE_ALWAYS : OPEN_EXISTING;
-    DWORD access = GENERIC_READ | GENERIC_WRITE;
-    DWORD share = FILE_SHARE_READ;
+    DWORD access = readOnly ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE;
+    DWORD share = readOnly ? FILE_SHARE_READ | FILE_SHARE_WRITE : FILE_SHARE_READ;
 
     hFile = CreateFileA(this->filePath.c_str(), access, share, nullptr, disposition, 0, nullptr);
     if (hFile == INVALID_HANDLE_VALUE) {
@@ -22,21 +24,23 @@ BigFileIO::BigFileIO(std::string filePath, bool create)
     }
 #else
     length = 0;
-    std::ios::openmode mode = std::ios::binary | std::ios::in | std::ios::out;
+
+    int flags = readOnly ? O_RDONLY : O_RDWR;
     if (create) {
-        mode |= std::ios::trunc;
+        flags |= O_CREAT | O_TRUNC;
     }
 
-    fstr = std::make_unique<std::fstream>(this->filePath, mode);
-    if (!fstr || !fstr->is_open()) {
-        fstr.reset();
+    fd = open(this->filePath.c_str(), flags, 0644);
+    if (fd == -1) {
         throw std::string("BigFileIO: Unable to open the file.");
     }
 
-    fstr->seekg(0, std::ios::end);
-    length = static_cast<UINT64>(fstr->tellg());
-    fstr->seekg(0, std::ios::beg);
-    fstr->seekp(0, std::ios::beg);
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) != 0) {
+        Close();
+        throw std::string("BigFileIO: Unable to open the file.");
+    }
+    length = static_cast<UINT64>(fileInfo.st_size);
 #endif
 }
 
@@ -46,44 +50,83 @@ BigFileIO::~BigFileIO()
 }
 
 void BigFileIO::ReadBytes(BYTE *outBuffer, DWORD len)
+{
+    ReadAt(pos, outBuffer, len);
+    pos += len;
+}
+
+void BigFileIO::WriteBytes(BYTE *buffer, DWORD len)
+{
+    WriteAt(pos, buffer, len);
+    pos += len;
+}
+
+void BigFileIO::ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len)
 {
 #ifdef _WIN32
+    // the offset is given with each call, a synchronous handle moves its file pointer too but nothing here uses it
+    OVERLAPPED overlapped {};
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
     DWORD bytesRead = 0;
-    if (!ReadFile(hFile, outBuffer, len, &bytesRead, nullptr) || bytesRead != len) {
+    if (!ReadFile(hFile, outBuffer, len, &bytesRead, &overlapped) || bytesRead != len) {
         throw std::string("BigFileIO: Error reading from file.");
     }
 #else
-    if (!fstr || !fstr->good()) {
-        throw std::string("BigFileIO: File stream is not available.");
+    if (fd == -1) {
+        throw std::string("BigFileIO: File is not open.");
     }
 
-    fstr->read(reinterpret_cast<char*>(outBuffer), len);
-    if (fstr->gcount() != static_cast<std::streamsize>(len)) {
-        throw std::string("BigFileIO: Error reading from file.");
+    while (len > 0) {
+        ssize_t bytesRead = pread(fd, outBuffer, len, static_cast<off_t>(offset));
+        if (bytesRead < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytesRead <= 0) {
+            throw std::string("BigFileIO: Error reading from file.");
+        }
+
+        outBuffer += bytesRead;
+        offset += static_cast<UINT64>(bytesRead);
+        len -= static_cast<DWORD>(bytesRead);
     }
 #endif
 }
 
-void BigFileIO::WriteBytes(BYTE *buffer, DWORD len)
+void BigFileIO::WriteAt(UINT64 offset, BYTE *buffer, DWORD len)
 {
 #ifdef _WIN32
+    OVERLAPPED overlapped {};
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
     DWORD bytesWritten = 0;
-    if (!WriteFile(hFile, buffer, len, &bytesWritten, nullptr) || bytesWritten != len) {
+    if (!WriteFile(hFile, buffer, len, &bytesWritten, &overlapped) || bytesWritten != len) {
         throw std::string("BigFileIO: Error writing to the file.");
     }
 #else
-    if (!fstr || !fstr->good()) {
-        throw std::string("BigFileIO: File stream is not available.");
+    if (fd == -1) {
+        throw std::string("BigFileIO: File is not open.");
     }
 
-    fstr->write(reinterpret_cast<char*>(buffer), len);
-    if (!fstr->good()) {
-        throw std::string("BigFileIO: Error writing to the file.");
+    const UINT64 endingOffset = offset + len;
+    while (len > 0) {
+        ssize_t bytesWritten = pwrite(fd, buffer, len, static_cast<off_t>(offset));
+        if (bytesWritten < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytesWritten <= 0) {
+            throw std::string("BigFileIO: Error writing to the file.");
+        }
+
+        buffer += bytesWritten;
+        offset += static_cast<UINT64>(bytesWritten);
+        len -= static_cast<DWORD>(bytesWritten);
     }
 
-    const UINT64 newPos = static_cast<UINT64>(fstr->tellp());
-    if (newPos > length) {
-        length = newPos;
+    if (endingOffset > length) {
+        length = endingOffset;
     }
 #endif
 }
@@ -103,59 +146,18 @@ UINT64 BigFileIO::Length()
 
 UINT64 BigFileIO::GetPosition()
 {
-#ifdef _WIN32
-    LARGE_INTEGER distance {};
-    LARGE_INTEGER current {};
-    if (!SetFilePointerEx(hFile, distance, &current, FILE_CURRENT)) {
-        throw std::string("BigFileIO: Error getting file position.");
-    }
-    return static_cast<UINT64>(current.QuadPart);
-#else
-    if (!fstr) {
-        throw std::string("BigFileIO: File stream is not available.");
-    }
-
-    auto gpos = fstr->tellg();
-    if (gpos >= 0) {
-        return static_cast<UINT64>(gpos);
-    }
-
-    auto ppos = fstr->tellp();
-    if (ppos >= 0) {
-        return static_cast<UINT64>(ppos);
-    }
-
-    throw std::string("BigFileIO: Error getting file position.");
-#endif
+    return pos;
 }
 
 void BigFileIO::SetPosition(UINT64 position, std::ios_base::seekdir dir)
 {
-#ifdef _WIN32
-    LARGE_INTEGER distance {};
-    distance.QuadPart = static_cast<LONGLONG>(position);
-
-    DWORD moveMethod = FILE_BEGIN;
     if (dir == std::ios_base::cur) {
-        moveMethod = FILE_CURRENT;
+        position += pos;
     } else if (dir == std::ios_base::end) {
-        moveMethod = FILE_END;
+        position += Length();
     }
 
-    if (!SetFilePointerEx(hFile, distance, nullptr, moveMethod)) {
-        throw std::string("BigFileIO: Error setting position.");
-    }
-#else
-    if (!fstr) {
-        throw std::string("BigFileIO: File stream is not available.");
-    }
-
-    fstr->seekg(static_cast<std::streamoff>(position), dir);
-    fstr->seekp(static_cast<std::streamoff>(position), dir);
-    if (!fstr->good()) {
-        throw std::string("BigFileIO: Error setting position.");
-    }
-#endif
+    pos = position;
 }
 
 void BigFileIO::Close()
@@ -166,9 +168,9 @@ void BigFileIO::Close()
         hFile = INVALID_HANDLE_VALUE;
     }
 #else
-    if (fstr) {
-        fstr->close();
-        fstr.reset();
+    if (fd != -1) {
+        close(fd);
+        fd = -1;
         length = 0;
     }
 #endif
@@ -181,13 +183,62 @@ void BigFileIO::Flush()
         throw std::string("BigFileIO: Unable to flush file buffers.");
     }
 #else
-    if (!fstr) {
-        throw std::string("BigFileIO: File stream is not available.");
+    // every write already went straight to the descriptor, so there's nothing buffered here
+    if (fd == -1) {
+        throw std::string("BigFileIO: File is not open.");
     }
+#endif
+}
 
-    fstr->flush();
-    if (!fstr->good()) {
-        throw std::string("BigFileIO: Unable to flush file buffers.");
-    }
+ReadCompletion BigFileIO::SubmitReads(std::vector<ReadRequest> requests)
+{
+    auto readFunction = [this](const ReadRequest &request)
+    {
+        ReadAt(request.offset, request.buffer, request.length);
+    };
+
+#ifdef _WIN32
+    return AsyncIO::SubmitToPool(std::move(requests), readFunction);
+#else
+    return AsyncIO::SubmitToDescriptor(fd, std::move(requests), readFunction);
+#endif
+}
+
+void BigFileIO::AdviseSequential()
+{
+#if defined(__linux__)
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#elif defined(__APPLE__)
+    fcntl(fd, F_RDAHEAD, 1);
+#endif
+}
+
+void BigFileIO::Preallocate(UINT64 reservedLength)
+{
+    // only a hint, filesystems that can't reserve space just grow the file as it's written
+#ifdef _WIN32
+    FILE_ALLOCATION_INFO allocation {};
+    allocation.AllocationSize.QuadPart = static_cast<LONGLONG>(reservedLength);
+    SetFileInformationByHandle(hFile, FileAllocationInfo, &allocation, sizeof(allocation));
+#elif defined(__linux__)
+    fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(reservedLength));
+#elif defined(__APPLE__)
+    fstore_t store {};
+    store.fst_flags = F_ALLOCATEALL;
+    store.fst_posmode = F_PEOFPOSMODE;
+    store.fst_length = static_cast<off_t>(reservedLength);
+    fcntl(fd, F_PREALLOCATE, &store);
+#endif
+}
+
+void BigFileIO::DropCache(UINT64 offset, UINT64 len)
+{
+#if defined(__linux__)
+    // dirty pages can't be dropped, so they have to be written back first
+    sync_file_range(fd, static_cast<off_t>(offset), static_cast<off_t>(len),
+            SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+    posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(len), POSIX_FADV_DONTNEED);
+#elif !defined(_WIN32)
+    fsync(fd);
 #endif
 }
@@ -0,0 +1,177 @@
+#include <XboxInternals/IO/BufferPool.h>
+
+#include <stdlib.h>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+BufferLease::BufferLease() :
+    pool(nullptr), data(nullptr), size(0), capacity(0)
+{
+}
+
+BufferLease::BufferLease(BufferPool *pool, BYTE *data, DWORD size, DWORD capacity) :
+    pool(pool), data(data), size(size), capacity(capacity)
+{
+}
+
+BufferLease::~BufferLease()
+{
+    Release();
+}
+
+BufferLease::BufferLease(BufferLease &&other) noexcept :
+    pool(other.pool), data(other.data), size(other.size), capacity(other.capacity)
+{
+    other.pool = nullptr;
+    other.data = nullptr;
+    other.size = 0;
+    other.capacity = 0;
+}
+
+BufferLease &BufferLease::operator=(BufferLease &&other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+        std::swap(pool, other.pool);
+        std::swap(data, other.data);
+        std::swap(size, other.size);
+        std::swap(capacity, other.capacity);
+    }
+    return *this;
+}
+
+BYTE *BufferLease::Data() const
+{
+    return data;
+}
+
+DWORD BufferLease::Size() const
+{
+    return size;
+}
+
+void BufferLease::Release()
+{
+    if (data != nullptr)
+        pool->release(data, capacity);
+
+    pool = nullptr;
+    data = nullptr;
+    size = 0;
+    capacity = 0;
+}
+
+BufferPool::BufferPool(UINT64 maxCachedBytes) :
+    cachedBytes(0), maxCachedBytes(maxCachedBytes)
+{
+}
+
+BufferPool::~BufferPool()
+{
+    Trim();
+}
+
+BufferPool &BufferPool::Shared()
+{
+    // never destroyed, so leases held by other static objects can still be returned at exit
+    static BufferPool *shared = new BufferPool();
+    return *shared;
+}
+
+BufferLease BufferPool::Acquire(DWORD size)
+{
+    int index = sizeClass(size);
+    if (index == -1)
+        return BufferLease(this, allocate(size), size, size);
+
+    DWORD capacity = BUFFERPOOL_MIN_CLASS_SIZE << index;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!freeBuffers[index].empty())
+        {
+            BYTE *data = freeBuffers[index].back();
+            freeBuffers[index].pop_back();
+            cachedBytes -= capacity;
+            return BufferLease(this, data, size, capacity);
+        }
+    }
+
+    return BufferLease(this, allocate(capacity), size, capacity);
+}
+
+void BufferPool::Trim()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (std::vector<BYTE*> &buffers : freeBuffers)
+    {
+        for (BYTE *data : buffers)
+            free(data);
+        buffers.clear();
+    }
+    cachedBytes = 0;
+}
+
+UINT64 BufferPool::CachedBytes()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return cachedBytes;
+}
+
+void BufferPool::release(BYTE *data, DWORD capacity)
+{
+    int index = sizeClass(capacity);
+    if (index != -1 && (DWORD)(BUFFERPOOL_MIN_CLASS_SIZE << index) == capacity)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (cachedBytes + capacity <= maxCachedBytes)
+        {
+            freeBuffers[index].push_back(data);
+            cachedBytes += capacity;
+            return;
+        }
+    }
+
+    free(data);
+}
+
+int BufferPool::sizeClass(DWORD size)
+{
+    for (int index = 0; index < BUFFERPOOL_CLASS_COUNT; index++)
+        if (size <= (DWORD)(BUFFERPOOL_MIN_CLASS_SIZE << index))
+            return index;
+    return -1;
+}
+
+BYTE *BufferPool::allocate(DWORD size)
+{
+    // round up so the end of the buffer is page aligned too
+    size_t allocationSize = ((size_t)size + BUFFERPOOL_ALIGNMENT - 1) & ~(size_t)(BUFFERPOOL_ALIGNMENT - 1);
+    if (allocationSize == 0)
+        allocationSize = BUFFERPOOL_ALIGNMENT;
+
+#ifdef _WIN32
+    BYTE *data = static_cast<BYTE*>(_aligned_malloc(allocationSize, BUFFERPOOL_ALIGNMENT));
+#else
+    void *memory = nullptr;
+    BYTE *data = (posix_memalign(&memory, BUFFERPOOL_ALIGNMENT, allocationSize) == 0) ?
+            static_cast<BYTE*>(memory) : nullptr;
+#endif
+
+    if (data == nullptr)
+        throw std::string("BufferPool: Unable to allocate a buffer.\n");
+    return data;
+}
+
+void BufferPool::free(BYTE *data)
+{
+#ifdef _WIN32
+    _aligned_free(data);
+#else
+    ::free(data);
+#endif
+}
@@ -0,0 +1,239 @@
+#include <XboxInternals/IO/BufferedIO.h>
+
+#include <algorithm>
+#include <string.h>
+
+// the largest run of consecutive dirty pages written back in one go
+#define BUFFEREDIO_MAX_WRITE_BACK_SIZE 0x100000
+
+BufferedIO::BufferedIO(BaseIO *io) : BaseIO(), io(io)
+{
+    if (io == nullptr)
+        throw std::string("BufferedIO: Cannot buffer a null io.\n");
+
+    byteOrder = io->GetEndian();
+
+    // pick up where the io is, and how long it really is
+    pos = io->GetPosition();
+    io->SetPosition(0, std::ios_base::end);
+    ioLength = io->GetPosition();
+    io->SetPosition(pos);
+
+    length = ioLength;
+}
+
+BufferedIO::~BufferedIO()
+{
+    try
+    {
+        WriteBack();
+    }
+    catch (...)
+    {
+    }
+}
+
+void BufferedIO::SetPosition(UINT64 position, std::ios_base::seekdir dir)
+{
+    if (dir == std::ios_base::cur)
+        position += pos;
+    else if (dir == std::ios_base::end)
+        position += length;
+
+    pos = position;
+}
+
+UINT64 BufferedIO::GetPosition()
+{
+    return pos;
+}
+
+UINT64 BufferedIO::Length()
+{
+    return length;
+}
+
+void BufferedIO::ReadBytes(BYTE *outBuffer, DWORD len)
+{
+    ReadAt(pos, outBuffer, len);
+    pos += len;
+}
+
+void BufferedIO::WriteBytes(BYTE *buffer, DWORD len)
+{
+    WriteAt(pos, buffer, len);
+    pos += len;
+}
+
+void BufferedIO::ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len)
+{
+    if (pages.empty())
+    {
+        io->ReadAt(offset, outBuffer, len);
+        return;
+    }
+
+    if (offset + len > length)
+        throw std::string("BufferedIO: Cannot read beyond the end of the io.\n");
+
+    // the start of a run of bytes that aren't in any dirty page
+    UINT64 cleanStart = offset;
+    BYTE *cleanBuffer = outBuffer;
+
+    auto readClean = [&](UINT64 end)
+    {
+        if (end <= cleanStart)
+            return;
+
+        // anything past what the io holds is a gap that hasn't been written back yet, so it's zero
+        UINT64 ioEnd = std::min(end, std::max(cleanStart, ioLength));
+        if (ioEnd > cleanStart)
+            io->ReadAt(cleanStart, cleanBuffer, (DWORD)(ioEnd - cleanStart));
+        memset(cleanBuffer + (ioEnd - cleanStart), 0, (size_t)(end - ioEnd));
+    };
+
+    UINT64 end = offset + len;
+    auto page = pages.lower_bound(offset - (offset % BUFFEREDIO_PAGE_SIZE));
+    for (; page != pages.end() && page->first < end; ++page)
+    {
+        UINT64 copyStart = std::max(page->first, offset);
+        UINT64 copyEnd = std::min(page->first + BUFFEREDIO_PAGE_SIZE, end);
+
+        readClean(copyStart);
+        memcpy(outBuffer + (copyStart - offset), page->second.data() + (copyStart - page->first),
+                (size_t)(copyEnd - copyStart));
+
+        cleanStart = copyEnd;
+        cleanBuffer = outBuffer + (copyEnd - offset);
+    }
+
+    readClean(end);
+}
+
+void BufferedIO::WriteAt(UINT64 offset, BYTE *buffer, DWORD len)
+{
+    UINT64 end = offset + len;
+
+    if (len >= BUFFEREDIO_WRITE_THROUGH_SIZE)
+    {
+        io->WriteAt(offset, buffer, len);
+        ioLength = std::max(ioLength, end);
+
+        // keep any dirty pages it overlaps in step, so writing them back later doesn't undo this
+        auto page = pages.lower_bound(offset - (offset % BUFFEREDIO_PAGE_SIZE));
+        for (; page != pages.end() && page->first < end; ++page)
+        {
+            UINT64 copyStart = std::max(page->first, offset);
+            UINT64 copyEnd = std::min(page->first + BUFFEREDIO_PAGE_SIZE, end);
+            memcpy(page->second.data() + (copyStart - page->first), buffer + (copyStart - offset),
+                    (size_t)(copyEnd - copyStart));
+        }
+    }
+    else
+    {
+        UINT64 pageOffset = offset - (offset % BUFFEREDIO_PAGE_SIZE);
+        while (pageOffset < end)
+        {
+            UINT64 copyStart = std::max(pageOffset, offset);
+            UINT64 copyEnd = std::min(pageOffset + BUFFEREDIO_PAGE_SIZE, end);
+
+            std::vector<BYTE> &page = getPage(pageOffset, copyEnd - copyStart == BUFFEREDIO_PAGE_SIZE);
+            memcpy(page.data() + (copyStart - pageOffset), buffer + (copyStart - offset),
+                    (size_t)(copyEnd - copyStart));
+
+            pageOffset += BUFFEREDIO_PAGE_SIZE;
+        }
+    }
+
+    length = std::max(length, end);
+
+    if (pages.size() >= BUFFEREDIO_MAX_DIRTY_PAGES)
+        WriteBack();
+}
+
+std::vector<BYTE> &BufferedIO::getPage(UINT64 pageOffset, bool overwritingPage)
+{
+    auto page = pages.find(pageOffset);
+    if (page != pages.end())
+        return page->second;
+
+    std::vector<BYTE> &data = pages[pageOffset];
+    data.resize(BUFFEREDIO_PAGE_SIZE);
+
+    if (!overwritingPage && pageOffset < ioLength)
+    {
+        try
+        {
+            io->ReadAt(pageOffset, data.data(), (DWORD)std::min<UINT64>(BUFFEREDIO_PAGE_SIZE,
+                    ioLength - pageOffset));
+        }
+        catch (std::string&)
+        {
+            pages.erase(pageOffset);
+            throw;
+        }
+    }
+
+    return data;
+}
+
+ReadCompletion BufferedIO::SubmitReads(std::vector<ReadRequest> requests)
+{
+    WriteBack();
+    return io->SubmitReads(std::move(requests));
+}
+
+void BufferedIO::WriteBack()
+{
+    std::vector<BYTE> run;
+    run.reserve(BUFFEREDIO_MAX_WRITE_BACK_SIZE);
+    UINT64 runStart = 0;
+
+    auto writeRun = [&]()
+    {
+        if (run.empty())
+            return;
+
+        io->WriteAt(runStart, run.data(), (DWORD)run.size());
+        ioLength = std::max(ioLength, runStart + run.size());
+        run.clear();
+    };
+
+    // the map keeps the pages sorted by offset, so consecutive ones are joined into a single Write
+    for (auto &page : pages)
+    {
+        if (page.first >= length)
+            continue;
+
+        if (!run.empty() && (runStart + run.size() != page.first ||
+                run.size() + BUFFEREDIO_PAGE_SIZE > BUFFEREDIO_MAX_WRITE_BACK_SIZE))
+            writeRun();
+
+        if (run.empty())
+            runStart = page.first;
+
+        // don't Write the end of the last page past the end of the io
+        size_t pageLength = (size_t)std::min<UINT64>(BUFFEREDIO_PAGE_SIZE, length - page.first);
+        run.insert(run.end(), page.second.begin(), page.second.begin() + pageLength);
+    }
+    writeRun();
+
+    pages.clear();
+}
+
+void BufferedIO::Flush()
+{
+    WriteBack();
+    io->Flush();
+}
+
+void BufferedIO::Close()
+{
+    Flush();
+    io->Close();
+}
+
+size_t BufferedIO::GetDirtyPageCount()
+{
+    return pages.size();
+}
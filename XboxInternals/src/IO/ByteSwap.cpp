@@ -0,0 +1,186 @@
+#include <XboxInternals/IO/ByteSwap.h>
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define BYTESWAP_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define BYTESWAP_TARGET(isa)
+#else
+#define BYTESWAP_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+WORD ByteSwap::Swap(WORD value)
+{
+#ifdef _MSC_VER
+    return _byteswap_ushort(value);
+#else
+    return __builtin_bswap16(value);
+#endif
+}
+
+DWORD ByteSwap::Swap(DWORD value)
+{
+#ifdef _MSC_VER
+    return _byteswap_ulong(value);
+#else
+    return __builtin_bswap32(value);
+#endif
+}
+
+UINT64 ByteSwap::Swap(UINT64 value)
+{
+#ifdef _MSC_VER
+    return _byteswap_uint64(value);
+#else
+    return __builtin_bswap64(value);
+#endif
+}
+
+namespace
+{
+
+template <typename T>
+void swapScalar(BYTE *data, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        T value;
+        memcpy(&value, data + i * sizeof(T), sizeof(T));
+        value = ByteSwap::Swap(value);
+        memcpy(data + i * sizeof(T), &value, sizeof(T));
+    }
+}
+
+#ifdef BYTESWAP_X86
+
+// shuffle control that reverses every elementSize byte group in a 16 byte lane
+void buildShuffleMask(BYTE *mask, size_t length, size_t elementSize)
+{
+    for (size_t i = 0; i < length; i++)
+        mask[i] = (BYTE)(((i % 16) / elementSize) * elementSize + (elementSize - 1 - (i % elementSize)));
+}
+
+template <typename T>
+BYTESWAP_TARGET("ssse3") void swapSsse3(BYTE *data, size_t count)
+{
+    BYTE maskBytes[16];
+    buildShuffleMask(maskBytes, 16, sizeof(T));
+    const __m128i mask = _mm_loadu_si128((const __m128i*)maskBytes);
+
+    size_t bytes = count * sizeof(T);
+    size_t i = 0;
+    for (; i + 16 <= bytes; i += 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)(data + i));
+        _mm_storeu_si128((__m128i*)(data + i), _mm_shuffle_epi8(block, mask));
+    }
+
+    swapScalar<T>(data + i, (bytes - i) / sizeof(T));
+}
+
+template <typename T>
+BYTESWAP_TARGET("avx2") void swapAvx2(BYTE *data, size_t count)
+{
+    BYTE maskBytes[32];
+    buildShuffleMask(maskBytes, 32, sizeof(T));
+    const __m256i mask = _mm256_loadu_si256((const __m256i*)maskBytes);
+
+    size_t bytes = count * sizeof(T);
+    size_t i = 0;
+    for (; i + 32 <= bytes; i += 32)
+    {
+        __m256i block = _mm256_loadu_si256((const __m256i*)(data + i));
+        _mm256_storeu_si256((__m256i*)(data + i), _mm256_shuffle_epi8(block, mask));
+    }
+
+    swapScalar<T>(data + i, (bytes - i) / sizeof(T));
+}
+
+enum SimdLevel
+{
+    SimdNone,
+    SimdSsse3,
+    SimdAvx2
+};
+
+SimdLevel detectSimdLevel()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    bool ssse3 = (info[2] & (1 << 9)) != 0;
+
+    // AVX2 also needs the os to save the ymm registers
+    bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+    bool avx2 = false;
+    if (maxLeaf >= 7 && osSavesYmm)
+    {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    bool ssse3 = __builtin_cpu_supports("ssse3");
+    bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+
+    if (avx2)
+        return SimdAvx2;
+    if (ssse3)
+        return SimdSsse3;
+    return SimdNone;
+}
+
+SimdLevel simdLevel()
+{
+    static const SimdLevel level = detectSimdLevel();
+    return level;
+}
+
+#endif
+
+template <typename T>
+void swapArray(T *values, size_t count)
+{
+    BYTE *data = reinterpret_cast<BYTE*>(values);
+
+#ifdef BYTESWAP_X86
+    switch (simdLevel())
+    {
+        case SimdAvx2:
+            swapAvx2<T>(data, count);
+            return;
+        case SimdSsse3:
+            swapSsse3<T>(data, count);
+            return;
+        default:
+            break;
+    }
+#endif
+
+    swapScalar<T>(data, count);
+}
+
+}
+
+void ByteSwap::SwapArray(WORD *values, size_t count)
+{
+    swapArray(values, count);
+}
+
+void ByteSwap::SwapArray(DWORD *values, size_t count)
+{
+    swapArray(values, count);
+}
+
+void ByteSwap::SwapArray(UINT64 *values, size_t count)
+{
+    swapArray(values, count);
+}
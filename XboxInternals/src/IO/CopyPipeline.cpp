@@ -0,0 +1,212 @@
+#include <XboxInternals/IO/CopyPipeline.h>
+#include <XboxInternals/IO/BufferPool.h>
+#include <XboxInternals/IO/OperationContext.h>
+#include <XboxInternals/IO/TracingIO.h>
+
+#include <string>
+#include <thread>
+#include <utility>
+
+CopyPipeline::CopyPipeline(DWORD bufferSize, DWORD bufferCount) :
+    bufferSize(bufferSize), bufferCount(bufferCount), context(nullptr), stopped(false), cancelled(false),
+    bytesRead(0), bytesWritten(0)
+{
+    if (bufferSize == 0 || bufferCount == 0)
+        throw std::string("CopyPipeline: Invalid buffer geometry.\n");
+}
+
+DWORD CopyPipeline::BufferSize()
+{
+    return bufferSize;
+}
+
+void CopyPipeline::SetTransform(TransformFunction transform)
+{
+    this->transform = std::move(transform);
+}
+
+void CopyPipeline::SetProgress(ProgressFunction progress)
+{
+    this->progress = std::move(progress);
+}
+
+void CopyPipeline::SetContext(OperationContext *context)
+{
+    this->context = context;
+}
+
+bool CopyPipeline::Run(ReadFunction reader, WriteFunction writer)
+{
+    std::vector<BufferLease> buffers;
+    for (DWORD i = 0; i < bufferCount; i++)
+        buffers.push_back(BufferPool::Shared().Acquire(bufferSize));
+
+    freeChunks.clear();
+    readChunks.clear();
+    transformedChunks.clear();
+    for (BufferLease &buffer : buffers)
+        freeChunks.push_back({ 0, buffer.Data(), 0 });
+
+    {
+        // once it's been cancelled it stays that way
+        std::lock_guard<std::mutex> lock(mutex);
+        if (cancelled)
+            return false;
+
+        stopped = false;
+        error = nullptr;
+    }
+    bytesRead = 0;
+    bytesWritten = 0;
+
+    // the stages' io is traced under the operation that started the copy, not whatever their threads default to
+    const char *operation = TracingIO::Operation::Current();
+    std::thread readerThread([this, &reader, operation]()
+    {
+        TracingIO::Operation trace(operation);
+        readerLoop(reader);
+    });
+    std::thread writerThread([this, &writer, operation]()
+    {
+        TracingIO::Operation trace(operation);
+        writerLoop(writer);
+    });
+
+    // the transform runs here, so the progress function gets called on the caller's thread too
+    try
+    {
+        Chunk chunk;
+        while (pop(readChunks, chunk))
+        {
+            if (chunk.length != 0 && transform)
+                transform(chunk.index, chunk.buffer, chunk.length);
+
+            push(transformedChunks, chunk);
+            if (chunk.length == 0)
+                break;
+
+            if (progress)
+                progress(bytesWritten);
+        }
+    }
+    catch (...)
+    {
+        fail();
+    }
+
+    readerThread.join();
+    writerThread.join();
+
+    if (error)
+        std::rethrow_exception(error);
+    if (cancelled)
+        return false;
+
+    if (progress)
+        progress(bytesWritten);
+    return true;
+}
+
+void CopyPipeline::Cancel()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    cancelled = true;
+    stopped = true;
+    changed.notify_all();
+}
+
+bool CopyPipeline::IsCancelled()
+{
+    return cancelled;
+}
+
+UINT64 CopyPipeline::BytesRead()
+{
+    return bytesRead;
+}
+
+UINT64 CopyPipeline::BytesWritten()
+{
+    return bytesWritten;
+}
+
+bool CopyPipeline::pop(std::deque<Chunk> &queue, Chunk &chunk)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    changed.wait(lock, [&]() { return stopped || !queue.empty(); });
+    if (stopped)
+        return false;
+
+    chunk = queue.front();
+    queue.pop_front();
+    return true;
+}
+
+void CopyPipeline::push(std::deque<Chunk> &queue, const Chunk &chunk)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    queue.push_back(chunk);
+    changed.notify_all();
+}
+
+void CopyPipeline::fail()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!error)
+        error = std::current_exception();
+    stopped = true;
+    changed.notify_all();
+}
+
+void CopyPipeline::readerLoop(ReadFunction &reader)
+{
+    try
+    {
+        Chunk chunk;
+        for (UINT64 index = 0; pop(freeChunks, chunk); index++)
+        {
+            // the reader is the first to notice, so nothing more gets read in
+            if (context && context->IsCancelled())
+            {
+                Cancel();
+                return;
+            }
+
+            chunk.index = index;
+            chunk.length = reader(index, chunk.buffer);
+            bytesRead += chunk.length;
+
+            push(readChunks, chunk);
+            if (chunk.length == 0)
+                return;
+        }
+    }
+    catch (...)
+    {
+        fail();
+    }
+}
+
+void CopyPipeline::writerLoop(WriteFunction &writer)
+{
+    try
+    {
+        Chunk chunk;
+        while (pop(transformedChunks, chunk))
+        {
+            if (chunk.length == 0)
+                return;
+
+            writer(chunk.index, chunk.buffer, chunk.length);
+            bytesWritten += chunk.length;
+            if (context)
+                context->AddBytes(chunk.length);
+
+            push(freeChunks, chunk);
+        }
+    }
+    catch (...)
+    {
+        fail();
+    }
+}
@@ -1,7 +1,17 @@
 #include <XboxInternals/IO/DeviceIO.h>
-
+#include <XboxInternals/IO/BufferPool.h>
+#include <XboxInternals/IO/Readahead.h>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <future>
+#include <list>
 #include <memory>
+#include <mutex>
 #include <string.h>
+#include <unordered_map>
+#include <vector>
 
 #ifdef _WIN32
 #ifndef WIN32_LEAN_AND_MEAN
@@ -13,9 +23,11 @@
 #include <windows.h>
 #include <WinIoCtl.h>
 #else
+#include <errno.h>
 #include <fcntl.h>
 #include <sys/types.h>
 #include <sys/ioctl.h>
+#include <sys/stat.h>
 #if __APPLE__
 #include <sys/disk.h>
 #elif __linux__
@@ -24,6 +36,9 @@
 #include <unistd.h>
 #endif
 
+// size of the pieces a bulk buffer is read in, so several are in flight at once
+#define DEVICEIO_BULK_PIECE_SIZE 0x100000
+
 #ifdef __linux__
 #define SECTOR_COUNT BLKGETSIZE
 #define SECTOR_SIZE BLKSSZGET
@@ -36,18 +51,271 @@ class DeviceIO::Impl
 {
 public:
 #ifdef _WIN32
-    Impl() : deviceHandle(INVALID_HANDLE_VALUE), offset{} {}
+    Impl() : deviceHandle(INVALID_HANDLE_VALUE), offset{}, cachePageSize(DEVICEIO_DEFAULT_CACHE_PAGE_SIZE),
+        cachePageCount(DEVICEIO_DEFAULT_CACHE_PAGE_COUNT), cacheHits(0), cacheMisses(0), deviceLength(0) {}
     HANDLE deviceHandle;
     OVERLAPPED offset;
 #else
-    Impl() : device(-1), offset(0) {}
+    Impl() : device(-1), offset(0), cachePageSize(DEVICEIO_DEFAULT_CACHE_PAGE_SIZE),
+        cachePageCount(DEVICEIO_DEFAULT_CACHE_PAGE_COUNT), cacheHits(0), cacheMisses(0), deviceLength(0) {}
     int device;
     INT64 offset;
 #endif
+
+    struct CachePage
+    {
+        std::vector<BYTE> data;
+
+        // the amount of bytes actually read, the last page on the device may be short
+        DWORD validLength;
+
+        std::list<UINT64>::iterator lruPosition;
+    };
+
+    // page cache, keyed by the page's address on the device, most recently used at the front of lru
+    std::mutex cacheMutex;
+    std::unordered_map<UINT64, CachePage> cachePages;
+    std::list<UINT64> lru;
+    DWORD cachePageSize;
+    DWORD cachePageCount;
+    std::atomic<UINT64> cacheHits;
+    std::atomic<UINT64> cacheMisses;
+
+    // length of the device when it could be determined, used to keep page reads from running off the end
+    UINT64 deviceLength;
+
+    // prefetches long sequential runs of ReadBytes calls
+    std::unique_ptr<Readahead> readahead;
+
+#ifndef _WIN32
+    std::string devicePath;
+
+    // second descriptor that bypasses the os cache, opened the first time a bulk transfer needs it
+    int directDevice = -1;
+    bool directOpenAttempted = false;
+
+    // get the descriptor bulk transfers go through
+    int BulkDescriptor()
+    {
+        if (!directOpenAttempted)
+        {
+            directOpenAttempted = true;
+#if defined(__linux__)
+            directDevice = open(devicePath.c_str(), O_RDWR | O_DIRECT);
+#elif defined(__APPLE__)
+            directDevice = open(devicePath.c_str(), O_RDWR);
+            if (directDevice != -1)
+                fcntl(directDevice, F_NOCACHE, 1);
+#endif
+        }
+
+        // some filesystems refuse O_DIRECT, the transfer still streams through the aligned buffers then
+        return (directDevice != -1) ? directDevice : device;
+    }
+#endif
+
+    // read len bytes at the page aligned offset through the bulk descriptor
+    void ReadBulk(UINT64 address, BYTE *outBuffer, DWORD len)
+    {
+#ifdef _WIN32
+        ReadSectors(address, outBuffer, len);
+#else
+        int bulkDevice = BulkDescriptor();
+        while (len > 0)
+        {
+            ssize_t bytesRead = pread(bulkDevice, outBuffer, len, address);
+            if (bytesRead < 0 && errno == EINTR)
+                continue;
+            if (bytesRead <= 0)
+                throw std::string("DeviceIO: Error reading from device.\n");
+
+            outBuffer += bytesRead;
+            address += bytesRead;
+            len -= bytesRead;
+        }
+#endif
+    }
+
+    // Write len bytes at the page aligned offset through the bulk descriptor
+    void WriteBulk(UINT64 address, BYTE *buffer, DWORD len)
+    {
+#ifdef _WIN32
+        WriteSectors(address, buffer, len);
+#else
+        int bulkDevice = BulkDescriptor();
+        while (len > 0)
+        {
+            ssize_t bytesWritten = pwrite(bulkDevice, buffer, len, address);
+            if (bytesWritten < 0 && errno == EINTR)
+                continue;
+            if (bytesWritten <= 0)
+                throw std::string("DeviceIO: Error writing to device.\n");
+
+            buffer += bytesWritten;
+            address += bytesWritten;
+            len -= bytesWritten;
+        }
+#endif
+    }
+
+    // read up to len bytes at the sector aligned offset, stopping early at the end of the device
+    DWORD ReadUpTo(UINT64 address, BYTE *outBuffer, DWORD len)
+    {
+#ifdef _WIN32
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = (DWORD)address;
+        overlapped.OffsetHigh = (DWORD)(address >> 32);
+
+        DWORD bytesRead = 0;
+        if (!ReadFile(deviceHandle, outBuffer, len, &bytesRead, &overlapped))
+            throw std::string("DeviceIO: Error reading from device, may be disconnected.\n");
+        return bytesRead;
+#else
+        DWORD totalRead = 0;
+        while (totalRead < len)
+        {
+            ssize_t bytesRead = pread(device, outBuffer + totalRead, len - totalRead, address + totalRead);
+            if (bytesRead < 0 && errno == EINTR)
+                continue;
+            if (bytesRead < 0)
+                throw std::string("DeviceIO: Error reading from device.\n");
+            if (bytesRead == 0)
+                break;
+
+            totalRead += bytesRead;
+        }
+        return totalRead;
+#endif
+    }
+
+    // read len bytes at the sector aligned offset, without using the shared position
+    void ReadSectors(UINT64 address, BYTE *outBuffer, DWORD len)
+    {
+        if (ReadUpTo(address, outBuffer, len) != len)
+            throw std::string("DeviceIO: Error reading from device.\n");
+    }
+
+    // Write len bytes at the sector aligned offset, without using the shared position
+    void WriteSectors(UINT64 address, BYTE *buffer, DWORD len)
+    {
+#ifdef _WIN32
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = (DWORD)address;
+        overlapped.OffsetHigh = (DWORD)(address >> 32);
+
+        if (!WriteFile(deviceHandle, buffer, len, NULL, &overlapped))
+            throw std::string("DeviceIO: Error writing to the device, may be disconnected.\n");
+#else
+        while (len > 0)
+        {
+            ssize_t bytesWritten = pwrite(device, buffer, len, address);
+            if (bytesWritten < 0 && errno == EINTR)
+                continue;
+            if (bytesWritten <= 0)
+                throw std::string("DeviceIO: Error writing to device.\n");
+
+            buffer += bytesWritten;
+            address += bytesWritten;
+            len -= bytesWritten;
+        }
+#endif
+    }
+
+    // copy len bytes at address out of the page cache, reading in the pages that aren't cached
+    void ReadCached(UINT64 address, BYTE *outBuffer, DWORD len)
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+
+        while (len > 0)
+        {
+            UINT64 pageAddress = address - (address % cachePageSize);
+            DWORD offsetInPage = (DWORD)(address - pageAddress);
+
+            CachePage &page = getPage(pageAddress);
+            if (offsetInPage >= page.validLength)
+                throw std::string("DeviceIO: Error reading from device.\n");
+
+            DWORD bytesToCopy = page.validLength - offsetInPage;
+            if (bytesToCopy > len)
+                bytesToCopy = len;
+
+            memcpy(outBuffer, page.data.data() + offsetInPage, bytesToCopy);
+
+            address += bytesToCopy;
+            outBuffer += bytesToCopy;
+            len -= bytesToCopy;
+        }
+    }
+
+    // drop all the cached pages that overlap the range, so the next read picks up what was written
+    void Invalidate(UINT64 address, UINT64 len)
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+
+        if (cachePages.empty())
+            return;
+
+        UINT64 firstPage = address - (address % cachePageSize);
+        for (UINT64 pageAddress = firstPage; pageAddress < address + len; pageAddress += cachePageSize)
+        {
+            auto cached = cachePages.find(pageAddress);
+            if (cached == cachePages.end())
+                continue;
+
+            lru.erase(cached->second.lruPosition);
+            cachePages.erase(cached);
+        }
+    }
+
+    void ClearCache()
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        cachePages.clear();
+        lru.clear();
+    }
+
+private:
+    // must be called with cacheMutex held
+    CachePage &getPage(UINT64 pageAddress)
+    {
+        auto cached = cachePages.find(pageAddress);
+        if (cached != cachePages.end())
+        {
+            cacheHits++;
+            lru.splice(lru.begin(), lru, cached->second.lruPosition);
+            return cached->second;
+        }
+
+        cacheMisses++;
+
+        // evict the least recently used page, reusing its buffer
+        std::vector<BYTE> pageData;
+        if (cachePages.size() >= cachePageCount && !lru.empty())
+        {
+            auto evicted = cachePages.find(lru.back());
+            pageData = std::move(evicted->second.data);
+            cachePages.erase(evicted);
+            lru.pop_back();
+        }
+        pageData.resize(cachePageSize);
+
+        DWORD bytesToRead = cachePageSize;
+        if (deviceLength != 0 && pageAddress + bytesToRead > deviceLength)
+            bytesToRead = (pageAddress < deviceLength) ? (DWORD)(deviceLength - pageAddress) : 0;
+
+        DWORD validLength = ReadUpTo(pageAddress, pageData.data(), bytesToRead);
+
+        lru.push_front(pageAddress);
+        CachePage &page = cachePages[pageAddress];
+        page.data = std::move(pageData);
+        page.validLength = validLength;
+        page.lruPosition = lru.begin();
+        return page;
+    }
 };
 
 DeviceIO::DeviceIO(std::string devicePath) :
-    impl(std::make_unique<Impl>()), lastReadOffset(-1)
+    impl(std::make_unique<Impl>()), pos(0)
 {
     // convert it to a wstring
     std::wstring wsDevicePath;
@@ -58,7 +326,7 @@ DeviceIO::DeviceIO(std::string devicePath) :
 }
 
 DeviceIO::DeviceIO(std::wstring devicePath) :
-    impl(std::make_unique<Impl>()), lastReadOffset(-1)
+    impl(std::make_unique<Impl>()), pos(0)
 {
     // load the device
     loadDevice(devicePath);
@@ -71,227 +339,266 @@ DeviceIO::~DeviceIO()
 
 void DeviceIO::ReadBytes(BYTE *outBuffer, DWORD len)
 {
-    UINT64 endingPos = pos + len;
-    if ((pos & 0x1FF) == 0 && (len & 0x1FF) == 0)
+    if (impl->readahead && impl->readahead->Read(pos, outBuffer, len))
     {
-#ifdef _WIN32
-        bool success = ReadFile(
-                    impl->deviceHandle,   // Device to read from
-                    outBuffer,            // Output buffer
-                    len,                  // Length to read
-                    NULL,                 // Pointer to the number of bytes read
-                    &impl->offset);       // OVERLAPPED structure containing the offset to read from
-
-        if (!success)
-            throw std::string("DeviceIO: Error reading from device, may be disconnected.\n");
-#else
-        ssize_t bytesRead = read(impl->device, outBuffer, len);
-        if (bytesRead < 0)
-            throw std::string("DeviceIO: Error reading from device.\n");
-#endif
+        SetPosition(pos + len);
+        return;
+    }
+
+    ReadAt(pos, outBuffer, len);
+    SetPosition(pos + len);
+}
+
+void DeviceIO::WriteBytes(BYTE *buffer, DWORD len)
+{
+    WriteAt(pos, buffer, len);
+    SetPosition(pos + len);
+}
 
-        SetPosition(endingPos);
+void DeviceIO::ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len)
+{
+    if (len == 0)
+        return;
 
+    // small reads are served from the page cache, that's where all the field by field parsing ends up
+    bool cacheEnabled = (impl->cachePageCount != 0);
+    if (cacheEnabled && len < impl->cachePageSize)
+    {
+        impl->ReadCached(offset, outBuffer, len);
         return;
     }
 
-    UINT64 originalPos = pos;
-    SetPosition(DOWN_TO_NEAREST_SECTOR(pos));
+    // aligned bulk reads can go straight to the device
+    if ((offset & 0x1FF) == 0 && (len & 0x1FF) == 0)
+    {
+        impl->ReadSectors(offset, outBuffer, len);
+        return;
+    }
 
-    if (lastReadOffset != pos)
+    if (!cacheEnabled)
     {
-#ifdef _WIN32
-        bool success = ReadFile(
-                    impl->deviceHandle,   // Device to read from
-                    lastReadData,         // Output buffer
-                    FAT_SECTOR_SIZE,                // Length to read
-                    NULL,                 // Pointer to the number of bytes read
-                    &impl->offset);       // OVERLAPPED structure containing the offset to read from
-
-        if (!success)
-            throw std::string("DeviceIO: Error reading from device, may be disconnected.\n");
-#else
-        ssize_t bytesRead = read(impl->device, lastReadData, FAT_SECTOR_SIZE);
-        if (bytesRead < 0)
-            throw std::string("DeviceIO: Error reading from device.\n");
-#endif
+        // read all the sectors spanned in one go and copy out the requested part
+        UINT64 alignedStart = DOWN_TO_NEAREST_SECTOR(offset);
+        UINT64 alignedEnd = UP_TO_NEAREST_SECTOR(offset + len);
+        std::vector<BYTE> sectors(alignedEnd - alignedStart);
 
-        lastReadOffset = pos;
+        impl->ReadSectors(alignedStart, sectors.data(), (DWORD)sectors.size());
+        memcpy(outBuffer, sectors.data() + (offset - alignedStart), len);
+        return;
     }
 
-    // copy over the data requested
-    WORD bytesLeftInSector = FAT_SECTOR_SIZE - (originalPos & 0x1FF);
-    WORD neededBytes = (len > bytesLeftInSector) ? bytesLeftInSector : len;
-    memcpy(outBuffer, lastReadData + (originalPos & 0x1FF), neededBytes);
+    // unaligned bulk read, the partial sectors on either end come out of the cache
+    UINT64 middleStart = UP_TO_NEAREST_SECTOR(offset);
+    UINT64 middleEnd = DOWN_TO_NEAREST_SECTOR(offset + len);
 
-    len -= neededBytes;
-    outBuffer += neededBytes;
+    if (middleStart != offset)
+        impl->ReadCached(offset, outBuffer, (DWORD)(middleStart - offset));
+    impl->ReadSectors(middleStart, outBuffer + (middleStart - offset), (DWORD)(middleEnd - middleStart));
+    if (middleEnd != offset + len)
+        impl->ReadCached(middleEnd, outBuffer + (middleEnd - offset), (DWORD)(offset + len - middleEnd));
+}
 
+void DeviceIO::WriteAt(UINT64 offset, BYTE *buffer, DWORD len)
+{
     if (len == 0)
-    {
-        SetPosition(endingPos);
         return;
-    }
 
-    // seek to the next sector
-    SetPosition(pos + FAT_SECTOR_SIZE); // 0x200
+    UINT64 alignedStart = DOWN_TO_NEAREST_SECTOR(offset);
+    UINT64 alignedEnd = UP_TO_NEAREST_SECTOR(offset + len);
 
-    INT64 downTo = DOWN_TO_NEAREST_SECTOR(len);
+    if ((offset & 0x1FF) == 0 && (len & 0x1FF) == 0)
+    {
+        impl->WriteSectors(offset, buffer, len);
+        impl->Invalidate(alignedStart, alignedEnd - alignedStart);
+        if (impl->readahead)
+            impl->readahead->Invalidate(alignedStart, alignedEnd - alignedStart);
+        return;
+    }
 
-    // read the consecutive sectors
-#ifdef _WIN32
-    bool success = ReadFile(
-                impl->deviceHandle,                 // Device to read from
-                outBuffer,                          // Output buffer
-                downTo,                             // Length to read
-                NULL,                               // Pointer to the number of bytes read
-                &impl->offset);                     // OVERLAPPED structure containing the offset to read from
-
-    if (!success)
-        throw std::string("DeviceIO: Error reading from device, may be disconnected.\n");
-#else
-    ssize_t bytesRead = read(impl->device, outBuffer, downTo);
-    if (bytesRead < 0)
-        throw std::string("DeviceIO: Error reading from device.\n");
-#endif
+    // We can't Write beyond the end of the stream
+    if (offset + len > Length())
+        throw std::string("DeviceIO: Cannot Write beyond the end of the stream.\n");
 
-    // update all our values
-    SetPosition(DOWN_TO_NEAREST_SECTOR(endingPos));
-    outBuffer += downTo;
-    len &= 0x1FF;
+    // read-modify-Write the partial sectors on either end of the range
+    std::vector<BYTE> sectors(alignedEnd - alignedStart);
+    bool readFirstSector = (offset != alignedStart);
+    if (readFirstSector)
+        ReadAt(alignedStart, sectors.data(), FAT_SECTOR_SIZE);
+
+    UINT64 lastSector = alignedEnd - FAT_SECTOR_SIZE;
+    if (offset + len != alignedEnd && !(readFirstSector && lastSector == alignedStart))
+        ReadAt(lastSector, sectors.data() + (lastSector - alignedStart), FAT_SECTOR_SIZE);
+
+    memcpy(sectors.data() + (offset - alignedStart), buffer, len);
+    impl->WriteSectors(alignedStart, sectors.data(), (DWORD)sectors.size());
+    impl->Invalidate(alignedStart, alignedEnd - alignedStart);
+    if (impl->readahead)
+        impl->readahead->Invalidate(alignedStart, alignedEnd - alignedStart);
+}
 
-    if (len == 0)
+ReadCompletion DeviceIO::SubmitReads(std::vector<ReadRequest> requests)
+{
+    auto readFunction = [this](const ReadRequest &request)
     {
-        SetPosition(endingPos);
-        return;
-    }
+        ReadAt(request.offset, request.buffer, request.length);
+    };
 
-    // read the stragglers
 #ifdef _WIN32
-    success = ReadFile(
-            impl->deviceHandle,                 // Device to read from
-            lastReadData,                       // Output buffer
-            FAT_SECTOR_SIZE,                              // Length to read
-            NULL,                               // Pointer to the number of bytes read
-            &impl->offset);                     // OVERLAPPED structure containing the offset to read from
-
-    if (!success)
-        throw std::string("DeviceIO: Error reading from device, may be disconnected.\n");
+    return AsyncIO::SubmitToPool(std::move(requests), readFunction);
 #else
-    ssize_t lastBytesRead = read(impl->device, lastReadData, FAT_SECTOR_SIZE);
-    if (lastBytesRead < 0)
-        throw std::string("DeviceIO: Error reading from device.\n");
+    return AsyncIO::SubmitToDescriptor(impl->device, std::move(requests), readFunction);
 #endif
+}
 
-    lastReadOffset = pos;
+void DeviceIO::SetCacheSize(DWORD pageSize, DWORD pageCount)
+{
+    if (pageSize == 0 || pageSize % FAT_SECTOR_SIZE != 0)
+        throw std::string("DeviceIO: Cache page size must be a multiple of the sector size.\n");
 
-    // copy over the requested data
-    memcpy(outBuffer, lastReadData, len);
+    impl->ClearCache();
 
-    SetPosition(endingPos);
+    std::lock_guard<std::mutex> lock(impl->cacheMutex);
+    impl->cachePageSize = pageSize;
+    impl->cachePageCount = pageCount;
 }
 
-void DeviceIO::WriteBytes(BYTE *buffer, DWORD len)
+void DeviceIO::SetReadahead(DWORD segmentSize, DWORD segmentCount)
 {
-    UINT64 endingPos = pos + len;
-    if ((pos & 0x1FF) == 0 && (len & 0x1FF) == 0)
-    {
-#ifdef _WIN32
-        bool success = WriteFile(
-                    impl->deviceHandle,     // Device to read from
-                    buffer,                 // Output buffer
-                    len,                    // Length to read
-                    NULL,                   // Pointer to the number of bytes read
-                    &impl->offset);         // OVERLAPPED structure containing the offset to read from
-
-        if (!success)
-            throw std::string("DeviceIO: Error writing to the device, may be disconnected.\n");
-#else
-        ssize_t bytesWritten = write(impl->device, buffer, len);
-        if (bytesWritten < 0)
-            throw std::string("DeviceIO: Error writing to device.\n");
-#endif
+    impl->readahead.reset();
+    if (segmentCount == 0)
+        return;
 
-        SetPosition(endingPos);
+    // the helper reads straight from the device, so its segments have to start on a sector
+    impl->readahead = std::make_unique<Readahead>([this](UINT64 offset, BYTE *outBuffer, DWORD len)
+    {
+        return impl->ReadUpTo(offset, outBuffer, len);
+    }, segmentSize, segmentCount, FAT_SECTOR_SIZE);
+}
 
-        return;
-    }
+void DeviceIO::BulkRead(UINT64 offset, UINT64 len, std::function<void(const BYTE*, DWORD)> consumer)
+{
+    if (offset % DEVICEIO_BULK_ALIGNMENT != 0)
+        throw std::string("DeviceIO: Bulk transfers must start on a page boundary.\n");
 
-    // nothing to do
-    if (len == 0)
-        return;
+    // the pool's buffers are page aligned, as the os needs them to be to bypass its cache
+    std::vector<BufferLease> buffers;
+    for (DWORD i = 0; i < DEVICEIO_BULK_BUFFER_COUNT; i++)
+        buffers.push_back(BufferPool::Shared().Acquire(DEVICEIO_BULK_BUFFER_SIZE));
+    const UINT64 chunkCount = (len + DEVICEIO_BULK_BUFFER_SIZE - 1) / DEVICEIO_BULK_BUFFER_SIZE;
 
-    // We can't Write beyond the end of the stream
-    if (pos + len > Length())
-        throw std::string("DeviceIO: Cannot Write beyond the end of the stream.\n");
+    auto chunkLength = [&](UINT64 chunk)
+    {
+        return (DWORD)std::min<UINT64>(len - chunk * DEVICEIO_BULK_BUFFER_SIZE, DEVICEIO_BULK_BUFFER_SIZE);
+    };
 
+    // queue up the reads for a chunk, only whole pages can bypass the cache so the end of the last
+    // chunk is read normally
+    auto submitChunk = [&](UINT64 chunk)
+    {
+        BYTE *buffer = buffers[chunk % DEVICEIO_BULK_BUFFER_COUNT].Data();
+        UINT64 chunkOffset = offset + chunk * DEVICEIO_BULK_BUFFER_SIZE;
+        DWORD chunkLen = chunkLength(chunk);
+        DWORD directLen = chunkLen - (chunkLen % DEVICEIO_BULK_ALIGNMENT);
 
-    UINT64 originalPos = pos;
-    UINT64 currentSector = DOWN_TO_NEAREST_SECTOR(pos);
+        std::vector<ReadRequest> requests;
+        AsyncIO::AppendReadRequests(requests, chunkOffset, buffer, directLen, DEVICEIO_BULK_PIECE_SIZE);
 
-    // Write the bytes up to the next sector
-    SetPosition(currentSector);
-    ReadBytes(lastReadData, FAT_SECTOR_SIZE);
-    lastReadOffset = currentSector;
-    WORD bytesLeftInSector = FAT_SECTOR_SIZE - (originalPos - currentSector);
-    WORD bytesToWrite = (len >= bytesLeftInSector) ? bytesLeftInSector : len;
-    memcpy(lastReadData + (originalPos - currentSector), buffer, bytesToWrite);
+        auto readFunction = [this](const ReadRequest &request)
+        {
+            impl->ReadBulk(request.offset, request.buffer, request.length);
+        };
 
-    // Write the actual data
-    SetPosition(currentSector);
 #ifdef _WIN32
-    DWORD bytesWritten;
-
-    WriteFile(
-        impl->deviceHandle,   // Device to read from
-        lastReadData,         // Data to Write
-        FAT_SECTOR_SIZE,                // Amount of data to Write
-        &bytesWritten,        // Pointer to number of bytes written
-        &impl->offset);       // OVERLAPPED structure containing the offset to Write from
+        ReadCompletion completion = AsyncIO::SubmitToPool(std::move(requests), readFunction);
 #else
-    ssize_t bytesWritten = write(impl->device, lastReadData, FAT_SECTOR_SIZE);
-    if (bytesWritten < 0)
-        throw std::string("DeviceIO: Error writing to device.\n");
+        ReadCompletion completion = AsyncIO::SubmitToDescriptor(impl->BulkDescriptor(), std::move(requests),
+                readFunction);
 #endif
 
-    // update the values
-    buffer += bytesToWrite;
-    currentSector += FAT_SECTOR_SIZE;
-    len -= bytesToWrite;
+        if (directLen != chunkLen)
+            ReadAt(chunkOffset + directLen, buffer + directLen, chunkLen - directLen);
+        return completion;
+    };
 
-    // Write the rest of the data
-    while (len > 0)
+    // every buffer but the one being consumed is kept busy reading
+    std::deque<ReadCompletion> inFlight;
+    UINT64 nextChunk = 0;
+    for (UINT64 chunk = 0; chunk < chunkCount; chunk++)
     {
-        SetPosition(currentSector);
-        lastReadOffset = DOWN_TO_NEAREST_SECTOR(pos);
-        ReadBytes(lastReadData, FAT_SECTOR_SIZE);
-        bytesToWrite = (len >= FAT_SECTOR_SIZE) ? FAT_SECTOR_SIZE : len;
-        memcpy(lastReadData, buffer, bytesToWrite);
+        while (nextChunk < chunkCount && nextChunk < chunk + DEVICEIO_BULK_BUFFER_COUNT)
+            inFlight.push_back(submitChunk(nextChunk++));
 
-        // go to the top of the sector
-        SetPosition(currentSector);
+        inFlight.front().Wait();
+        inFlight.pop_front();
 
-        // update values
-        buffer += bytesToWrite;
-        currentSector += FAT_SECTOR_SIZE;
-        len -= bytesToWrite;
+        consumer(buffers[chunk % DEVICEIO_BULK_BUFFER_COUNT].Data(), chunkLength(chunk));
+    }
+}
 
-#ifdef _WIN32
-        WriteFile(
-            impl->deviceHandle,   // Device to read from
-            lastReadData,         // Data to Write
-            FAT_SECTOR_SIZE,                // Amount of data to Write
-            &bytesWritten,        // Pointer to number of bytes written
-            &impl->offset);       // OVERLAPPED structure containing the offset to Write from
-#else
-        ssize_t bytesWritten = write(impl->device, buffer, FAT_SECTOR_SIZE);
-        if (bytesWritten < 0)
-            throw std::string("DeviceIO: Error writing to device.\n");
-#endif
+void DeviceIO::BulkWrite(UINT64 offset, UINT64 len, std::function<void(BYTE*, DWORD)> producer)
+{
+    if (offset % DEVICEIO_BULK_ALIGNMENT != 0)
+        throw std::string("DeviceIO: Bulk transfers must start on a page boundary.\n");
+
+    // the pool's buffers are page aligned, as the os needs them to be to bypass its cache
+    std::vector<BufferLease> buffers;
+    for (DWORD i = 0; i < DEVICEIO_BULK_BUFFER_COUNT; i++)
+        buffers.push_back(BufferPool::Shared().Acquire(DEVICEIO_BULK_BUFFER_SIZE));
+    const UINT64 chunkCount = (len + DEVICEIO_BULK_BUFFER_SIZE - 1) / DEVICEIO_BULK_BUFFER_SIZE;
+
+    // the writes happen in the background while the producer fills the next buffer
+    std::deque<std::future<void>> inFlight;
+    for (UINT64 chunk = 0; chunk < chunkCount; chunk++)
+    {
+        // wait for the Write that last used this buffer, which also passes along anything it threw
+        if (inFlight.size() == DEVICEIO_BULK_BUFFER_COUNT)
+        {
+            inFlight.front().get();
+            inFlight.pop_front();
+        }
+
+        BYTE *buffer = buffers[chunk % DEVICEIO_BULK_BUFFER_COUNT].Data();
+        UINT64 chunkOffset = offset + chunk * DEVICEIO_BULK_BUFFER_SIZE;
+        DWORD chunkLen = (DWORD)std::min<UINT64>(len - chunk * DEVICEIO_BULK_BUFFER_SIZE,
+                DEVICEIO_BULK_BUFFER_SIZE);
+
+        producer(buffer, chunkLen);
+
+        inFlight.push_back(std::async(std::launch::async, [this, buffer, chunkOffset, chunkLen]()
+        {
+            // only whole pages can bypass the cache, the rest of the last chunk is written normally
+            DWORD directLen = chunkLen - (chunkLen % DEVICEIO_BULK_ALIGNMENT);
+            impl->WriteBulk(chunkOffset, buffer, directLen);
+            if (directLen != chunkLen)
+                WriteAt(chunkOffset + directLen, buffer + directLen, chunkLen - directLen);
+        }));
+    }
+
+    while (!inFlight.empty())
+    {
+        inFlight.front().get();
+        inFlight.pop_front();
     }
 
-    // set the position
-    SetPosition(endingPos);
+    // anything cached from before is stale now
+    impl->ClearCache();
+    if (impl->readahead)
+        impl->readahead->Invalidate(offset, len);
+}
+
+void DeviceIO::ClearCache()
+{
+    impl->ClearCache();
+}
+
+UINT64 DeviceIO::GetCacheHits()
+{
+    return impl->cacheHits;
+}
+
+UINT64 DeviceIO::GetCacheMisses()
+{
+    return impl->cacheMisses;
 }
 
 UINT64 DeviceIO::Length()
@@ -327,6 +634,11 @@ UINT64 DeviceIO::Length()
 
     // calculate the length in bytes
     length = (UINT64)numberOfSectors * (UINT64)sectorSize;
+
+    // the ioctls only work on block devices, an image file just has a size
+    struct stat deviceInfo;
+    if (length == 0 && fstat(device, &deviceInfo) == 0 && S_ISREG(deviceInfo.st_mode))
+        length = (UINT64)deviceInfo.st_size;
 #endif
 
     return length;
@@ -347,16 +659,7 @@ void DeviceIO::SetPosition(UINT64 address, std::ios_base::seekdir dir)
     impl->offset = address;
 #endif
 
-#ifdef __linux__
-    lseek64(impl->device, address, SEEK_SET);
-#else
-#ifdef _WIN32
-    LONG addressHigh = impl->offset.OffsetHigh;
-    SetFilePointer(impl->deviceHandle, impl->offset.Offset, &addressHigh, FILE_BEGIN);
-#else
-    lseek(impl->device, address, SEEK_SET);
-#endif
-#endif
+    // all the device io is positional, so there's no need to move the handle's file pointer
 }
 
 UINT64 DeviceIO::realPosition()
@@ -375,6 +678,10 @@ UINT64 DeviceIO::GetPosition()
 
 void DeviceIO::Close()
 {
+    // the helper thread reads from the handle, so it has to go first
+    if (impl)
+        impl->readahead.reset();
+
 #if defined _WIN32
     if (impl && impl->deviceHandle != INVALID_HANDLE_VALUE) {
         CloseHandle(impl->deviceHandle);
@@ -385,6 +692,11 @@ void DeviceIO::Close()
         close(impl->device);
         impl->device = -1;
     }
+
+    if (impl && impl->directDevice != -1) {
+        close(impl->directDevice);
+        impl->directDevice = -1;
+    }
 #endif
 }
 
@@ -415,7 +727,10 @@ void DeviceIO::loadDevice(std::wstring devicePath)
     impl->device = open(tempPath.c_str(), O_RDWR);
     if (impl->device == -1)
         throw std::string("DeviceIO: Error opening device.\n" + std::string(strerror(errno)));
+    impl->devicePath = tempPath;
 #endif
+
+    impl->deviceLength = Length();
 }
 
 void DeviceIO::Flush()
@@ -1,12 +1,19 @@
 #include <XboxInternals/IO/FatxIO.h>
+#include <XboxInternals/IO/BufferPool.h>
+#include <XboxInternals/IO/CopyPipeline.h>
 
+#include <algorithm>
+#include <atomic>
+#include <stdio.h>
 #include <vector>
 
-FatxIO::FatxIO(DeviceIO *device, FatxFileEntry *entry) : entry(entry), device(device)
+// the last chain generation handed out. Generations are unique across every entry, so an entry that's been
+// replaced by another one at the same address can't look like it has the same chain.
+static std::atomic<UINT64> lastChainGeneration(0);
+
+FatxIO::FatxIO(BaseIO *device, FatxFileEntry *entry) :
+    entry(entry), device(device), pos(0), extentsGeneration(0)
 {
-    // if it's a new file, then don't do any seeking yet
-    if (entry->startingCluster != 0)
-        SetPosition(0);
 }
 
 FatxIO::~FatxIO()
@@ -27,29 +34,8 @@ void FatxIO::SetPosition(UINT64 position, std::ios_base::seekdir dir)
         AllocateMemory(position - entry->fileSize);
     }
 
+    // the device is only positioned when something is read or written, at the run the position is in
     pos = position;
-
-    if (pos == entry->fileSize && !(entry->fileAttributes & FatxDirectory))
-        return;
-
-    // calculate the cluster index to look at
-    DWORD clusterIndex =  position / entry->partition->clusterSize;
-
-    if (clusterIndex >= entry->clusterChain.size())
-        throw std::string("FATX: Cluster chain not sufficient enough for file size.\n");
-
-    DWORD cluster = entry->clusterChain.at(clusterIndex);
-
-    // calculate the read position
-    DWORD startInCluster = (position % entry->partition->clusterSize);
-    INT64 driveOff = (entry->partition->clusterStartingAddress + (entry->partition->clusterSize *
-            (INT64)(cluster - 1))) + startInCluster;
-
-    // this stores how many bytes we have until we reach another cluster
-    maxReadConsecutive = entry->partition->clusterSize - startInCluster;
-
-    // set the position
-    device->SetPosition(driveOff);
 }
 
 void FatxIO::Flush()
@@ -99,6 +85,7 @@ int FatxIO::AllocateMemory(DWORD byteAmount)
     // add the free clusters to the cluster chain
     for (size_t i = 0; i < freeClusters.size(); i++)
         entry->clusterChain.push_back(freeClusters.at(i));
+    ChainChanged(entry);
 
     if (fileIsNull)
         entry->startingCluster = entry->clusterChain.at(0);
@@ -128,7 +115,9 @@ UINT64 FatxIO::Length()
 
 UINT64 FatxIO::GetDrivePosition()
 {
-    return device->GetPosition();
+    UINT64 driveOffset;
+    getConsecutiveRun(pos, 1, &driveOffset);
+    return driveOffset;
 }
 
 FatxFileEntry* FatxIO::GetFatxFileEntry()
@@ -138,170 +127,138 @@ FatxFileEntry* FatxIO::GetFatxFileEntry()
 
 void FatxIO::ReadBytes(BYTE *outBuffer, DWORD len)
 {
-    // get the length
-    DWORD origLen = len;
+    transferRuns(pos, outBuffer, len, false);
+    pos += len;
+}
 
-    DWORD bytesToRead = (len <= maxReadConsecutive) ? len : maxReadConsecutive;
-    device->ReadBytes(outBuffer, bytesToRead);
-    len -= bytesToRead;
-    SetPosition(pos + bytesToRead);
+void FatxIO::WriteBytes(BYTE *buffer, DWORD len)
+{
+    // grow the file first, so every cluster that's written to is already in the chain
+    if (!(entry->fileAttributes & FatxDirectory) && pos + len > entry->fileSize)
+        AllocateMemory(pos + len - entry->fileSize);
 
-    while (len >= entry->partition->clusterSize)
-    {
-        // calculate how many bytes to read
-        device->ReadBytes(outBuffer + (origLen - len), maxReadConsecutive);
+    transferRuns(pos, buffer, len, true);
+    pos += len;
+}
 
-        // update the position
-        SetPosition(pos + maxReadConsecutive);
+void FatxIO::ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len)
+{
+    if (!(entry->fileAttributes & FatxDirectory) && offset + len > entry->fileSize)
+        throw std::string("FATX: Cannot read beyond the end of the file.\n");
 
-        // update the length
-        len -= maxReadConsecutive;
-    }
+    transferRuns(offset, outBuffer, len, false);
+}
 
-    if (len > 0)
+void FatxIO::WriteAt(UINT64 offset, BYTE *buffer, DWORD len)
+{
+    // writing past the end needs memory allocated, which the stateful path handles
+    if (!(entry->fileAttributes & FatxDirectory) && offset + len > entry->fileSize)
     {
-        device->ReadBytes(outBuffer + (origLen - len), len);
-        SetPosition(pos + len);
+        BaseIO::WriteAt(offset, buffer, len);
+        return;
     }
+
+    transferRuns(offset, buffer, len, true);
 }
 
-void FatxIO::WriteBytes(BYTE *buffer, DWORD len)
+void FatxIO::transferRuns(UINT64 offset, BYTE *buffer, DWORD len, bool write)
 {
-    // get the length
-    DWORD origLen = len;
-
-    DWORD bytesToWrite = (len <= maxReadConsecutive) ? len : maxReadConsecutive;
-    device->WriteBytes(buffer, bytesToWrite);
-    len -= bytesToWrite;
-    SetPosition(pos + bytesToWrite);
+    // a package header the drive kept for the file is out of date once the file is written to
+    if (write)
+        entry->partition->cachedHeaders.erase(entry->address);
 
-    while (len >= entry->partition->clusterSize)
+    while (len > 0)
     {
-        // calculate how many bytes to read
-        device->WriteBytes(buffer + (origLen - len), maxReadConsecutive);
+        UINT64 driveOffset;
+        DWORD runLength = getConsecutiveRun(offset, len, &driveOffset);
 
-        // update the position
-        SetPosition(pos + maxReadConsecutive);
+        if (write)
+            device->WriteAt(driveOffset, buffer, runLength);
+        else
+            device->ReadAt(driveOffset, buffer, runLength);
 
-        // update the length
-        len -= maxReadConsecutive;
+        offset += runLength;
+        buffer += runLength;
+        len -= runLength;
     }
-
-    if (len > 0)
-        device->WriteBytes(buffer + (origLen - len), len);
 }
 
-std::vector<DWORD> FatxIO::getFreeClusters(Partition *part, DWORD count)
+DWORD FatxIO::getConsecutiveRun(UINT64 offset, DWORD len, UINT64 *driveOffset)
 {
-    std::vector<DWORD> freeClusters(count);
-    std::vector<Range> consecutiveClusters;
-    std::vector<Range> usedRanges;
+    updateChainExtents();
 
-    // check to see if we have enough free clusters left
-    if (count > part->freeClusters.size())
-    {
-        std::stringstream ss;
-        ss << "FATX: Out of memory. There are only ";
-        ss << ByteSizeToString(part->freeClusters.size() * part->clusterSize).c_str();
-        ss << " of free memory remaining on this partition.\n";
+    // the offset is in the last run that starts at or before it
+    auto nextRun = std::upper_bound(chainExtentStarts.begin(), chainExtentStarts.end(), offset);
+    if (nextRun == chainExtentStarts.begin())
+        throw std::string("FATX: Cluster chain not sufficient enough for file size.\n");
 
-        throw ss.str();
-    }
+    size_t run = (nextRun - chainExtentStarts.begin()) - 1;
+    UINT64 offsetInRun = offset - chainExtentStarts.at(run);
+    if (offsetInRun >= chainExtents.at(run).length)
+        throw std::string("FATX: Cluster chain not sufficient enough for file size.\n");
 
-    // get the consecutive clusters
-    GetConsecutive(part->freeClusters, consecutiveClusters);
+    *driveOffset = chainExtents.at(run).offset + offsetInRun;
 
-    // sort the consecutive clusters so that the longest ranges are at the beginning
-    std::sort(consecutiveClusters.begin(), consecutiveClusters.end(), compareRanges);
+    UINT64 runLength = chainExtents.at(run).length - offsetInRun;
+    return (runLength < len) ? (DWORD)runLength : len;
+}
 
-    // first get clusters that are consecutive
-    DWORD i = 0, currentIndex = 0;
-    while (count > 0 && i < consecutiveClusters.size())
-    {
-        // get the amount of clusters to copy from the consecutive cluster range
-        DWORD clustersToCopy = (count > consecutiveClusters.at(i).len) ? consecutiveClusters.at(
-                    i).len : count;
-        std::vector<DWORD>::iterator rangeStart = part->freeClusters.begin() + consecutiveClusters.at(
-                    i).start;
+void FatxIO::updateChainExtents()
+{
+    if (entry->chainGeneration == extentsGeneration)
+        return;
 
-        // get that calculated amount of consecutive clusters
-        std::copy(rangeStart, rangeStart + clustersToCopy, freeClusters.begin() + currentIndex);
+    const std::vector<DWORD> &chain = entry->clusterChain;
 
-        Range r = { consecutiveClusters.at(i).start, clustersToCopy };
-        usedRanges.push_back(r);
+    Partition *part = entry->partition;
+    chainExtents.clear();
+    chainExtentStarts.clear();
 
-        count -= clustersToCopy;
-        currentIndex += clustersToCopy;
-        i++;
-    }
+    UINT64 fileOffset = 0;
+    for (DWORD cluster : chain)
+    {
+        UINT64 offset = ClusterToOffset(part, cluster);
 
-    // remove all of the used clusters
-    for (DWORD i = 0; i < usedRanges.size(); i++)
-        part->freeClusters.erase(part->freeClusters.begin() + usedRanges.at(i).start,
-                part->freeClusters.begin() + usedRanges.at(i).start + usedRanges.at(i).len);
+        // extend the current run if this cluster directly follows it and it still fits in an extent
+        if (!chainExtents.empty() && chainExtents.back().offset + chainExtents.back().length == offset &&
+                chainExtents.back().length <= 0xFFFFFFFF - part->clusterSize)
+            chainExtents.back().length += part->clusterSize;
+        else
+        {
+            chainExtents.push_back({ offset, part->clusterSize });
+            chainExtentStarts.push_back(fileOffset);
+        }
 
-    // if we still need more clusters, then we'll just copy over non-consecutive ones that are left
-    std::copy(part->freeClusters.begin(), part->freeClusters.begin() + count,
-              freeClusters.begin() + currentIndex);
-    part->freeClusters.erase(part->freeClusters.begin(), part->freeClusters.begin() + count);
+        fileOffset += part->clusterSize;
+    }
 
-    return freeClusters;
+    extentsGeneration = entry->chainGeneration;
 }
 
-void FatxIO::SetAllClusters(DeviceIO *device, Partition *part, std::vector<DWORD> &clusters,
-        DWORD value)
+std::vector<DWORD> FatxIO::getFreeClusters(Partition *part, DWORD count)
 {
-    // sort the clusters numerically, order doesn't matter any more since we're just setting them all to the same value
-    XeCrypt::InsertionSort(clusters.begin(), clusters.end());
-
-    // we'll work with the clusters in 0x10000 chunks to minimize the amount of reads
-    BYTE buffer[0x10000];
-
-    for (DWORD i = 0; i < clusters.size(); i++)
+    // check to see if we have enough free clusters left
+    if (count > part->freeClusters.FreeCount())
     {
-        // seek to the lowest cluster in the chainmap, but round to get a fast read
-        UINT64 clusterEntryAddr = (part->address + 0x1000 + clusters.at(i) * part->clusterEntrySize);
-        device->SetPosition(DOWN_TO_NEAREST_SECTOR(clusterEntryAddr));
-
-        // read in a chunk of the chainmap
-        device->ReadBytes(buffer, 0x10000);
-
-        // open a MemoryIO on the memory for easier access
-        MemoryIO bufferIO(buffer, 0x10000);
+        std::stringstream ss;
+        ss << "FATX: Out of memory. There are only ";
+        ss << ByteSizeToString(part->freeClusters.FreeCount() * part->clusterSize).c_str();
+        ss << " of free memory remaining on this partition.\n";
 
-        // calculate the offset of the cluster in the buffer
-        UINT64 clusterEntryOffset = clusterEntryAddr - DOWN_TO_NEAREST_SECTOR(clusterEntryAddr);
+        throw ss.str();
+    }
 
-        // loop while still in the bounds of the buffer
-        while (clusterEntryOffset < 0x10000)
-        {
-            // seek to the address of the cluster in the buffer
-            bufferIO.SetPosition(clusterEntryOffset);
-
-            // set the cluster chain map entry to the value requested
-            if (part->clusterEntrySize == 2)
-                bufferIO.Write((WORD)value);
-            else
-                bufferIO.Write((DWORD)value);
-
-            if (i + 1 == clusters.size())
-            {
-                ++i;
-                break;
-            }
-
-            // calculate the value of the next cluster entry
-            clusterEntryOffset = (part->address + 0x1000 + clusters.at(++i) * part->clusterEntrySize) -
-                    DOWN_TO_NEAREST_SECTOR(clusterEntryAddr);
-        }
-        --i;
+    return part->freeClusters.Allocate(count);
+}
 
-        // once we're done then Write the block of memory back
-        device->SetPosition(DOWN_TO_NEAREST_SECTOR(clusterEntryAddr));
-        device->WriteBytes(buffer, 0x10000);
-    }
+void FatxIO::SetAllClusters(BaseIO *device, Partition *part, std::vector<DWORD> &clusters,
+        DWORD value)
+{
+    for (DWORD cluster : clusters)
+        part->chainmap->Set(cluster, value);
 
-    // flush the device just to be safe
+    // only the pages of the chainmap that changed are written back
+    part->chainmap->Flush();
     device->Flush();
 }
 
@@ -344,8 +301,13 @@ void FatxIO::WriteEntryToDisk(std::vector<DWORD> *clusterChain)
     }
 }
 
-void FatxIO::ReplaceFile(std::string sourcePath, void (*progress)(void *, DWORD, DWORD), void *arg)
+void FatxIO::ReplaceFile(std::string sourcePath, void (*progress)(void *, DWORD, DWORD), void *arg,
+        OperationContext *context)
 {
+    // once the old file starts getting overwritten it has to be finished, so it can only be cancelled up front
+    if (context)
+        context->ThrowIfCancelled();
+
     // open the file to replace the current one with
     FileIO inFile(sourcePath);
 
@@ -353,16 +315,22 @@ void FatxIO::ReplaceFile(std::string sourcePath, void (*progress)(void *, DWORD,
     inFile.SetPosition(0, std::ios_base::end);
     UINT64 fileSize = inFile.GetPosition();
 
+    if (context)
+        context->BeginItem(fileSize);
+
     if (fileSize == 0)
     {
         inFile.Close();
         if (progress)
             progress(arg, 1, 1);
+        if (context)
+            context->EndItem();
         return;
     }
 
     // reset the position
     inFile.SetPosition(0);
+    entry->partition->cachedHeaders.erase(entry->address);
 
     // calculate the amount of clusters for the file
     DWORD clusterCount = (fileSize / entry->partition->clusterSize) + ((fileSize %
@@ -379,9 +347,12 @@ void FatxIO::ReplaceFile(std::string sourcePath, void (*progress)(void *, DWORD,
 
         // set all of those clusters to free
         SetAllClusters(device, entry->partition, clustersToFree, FAT_CLUSTER_AVAILABLE);
+        if (entry->partition->freeClusters.IsBuilt())
+            entry->partition->freeClusters.Free(clustersToFree);
 
         // erase the now freed ones from the chain
         entry->clusterChain.erase(entry->clusterChain.begin() + clusterCount, entry->clusterChain.end());
+        ChainChanged(entry);
     }
     // if the file is bigger then we need to allocate clustes
     else if (clusterCount > entry->clusterChain.size())
@@ -403,55 +374,31 @@ void FatxIO::ReplaceFile(std::string sourcePath, void (*progress)(void *, DWORD,
     else if (bufferSize > 0x100000)
         bufferSize = 0x100000;
 
-    std::vector<Range> WriteRanges;
-    std::vector<BYTE> buffer(bufferSize);
-    UINT64 pos;
-
-    // generate the read ranges
-    for (DWORD i = 0; i < entry->clusterChain.size() - 1; i++)
-    {
-        // calculate cluster's address
-        pos = FatxIO::ClusterToOffset(entry->partition, entry->clusterChain.at(i));
-
-        Range range = { pos, 0 };
-        do
-        {
-            range.len += entry->partition->clusterSize;
+    BufferLease buffer = BufferPool::Shared().Acquire(bufferSize);
+    std::vector<std::vector<Extent>> batches = AsyncIO::SplitExtents(fileExtents(), bufferSize);
 
-            i++;
-        }
-        while ((entry->clusterChain.at(i - 1) + 1) == entry->clusterChain.at(i) &&
-                i < (entry->clusterChain.size() - 2) && (range.len + entry->partition->clusterSize) <= bufferSize);
-        i--;
-
-        WriteRanges.push_back(range);
-    }
-
-    DWORD finalClusterSize = entry->fileSize % entry->partition->clusterSize;
-    UINT64 finalClusterOffset = FatxIO::ClusterToOffset(entry->partition,
-            entry->clusterChain.at(entry->clusterChain.size() - 1));
-    Range lastRange = { finalClusterOffset , (finalClusterSize == 0) ? entry->partition->clusterSize : finalClusterSize };
-    WriteRanges.push_back(lastRange);
-
-    DWORD modulus = WriteRanges.size() / 100;
+    DWORD modulus = batches.size() / 100;
     if (modulus == 0)
         modulus = 1;
     else if (modulus > 3)
         modulus = 3;
 
-    // read all the data in
-    for (DWORD i = 0; i < WriteRanges.size(); i++)
+    // Write all the data out, a buffer at a time scattered across the clusters it covers
+    for (DWORD i = 0; i < batches.size(); i++)
     {
-        // seek to the beginning of the range
-        device->SetPosition(WriteRanges.at(i).start);
+        DWORD batchLength = 0;
+        for (const Extent &extent : batches.at(i))
+            batchLength += extent.length;
+
+        inFile.ReadBytes(buffer.Data(), batchLength);
+        device->WriteV(batches.at(i), buffer.Data());
 
-        // get the range from the device
-    inFile.ReadBytes(buffer.data(), WriteRanges.at(i).len);
-    device->WriteBytes(buffer.data(), WriteRanges.at(i).len);
+        if (context)
+            context->AddBytes(batchLength);
 
         // update progress if needed
         if (progress && i % modulus == 0)
-            progress(arg, i, WriteRanges.size());
+            progress(arg, i, batches.size());
     }
 
     // clean up
@@ -459,7 +406,9 @@ void FatxIO::ReplaceFile(std::string sourcePath, void (*progress)(void *, DWORD,
 
     // make sure it hits the end
     if (progress)
-        progress(arg, WriteRanges.size(), WriteRanges.size());
+        progress(arg, batches.size(), batches.size());
+    if (context)
+        context->EndItem();
 }
 
 void FatxIO::WriteClusterChain(Partition *part, DWORD startingCluster,
@@ -470,72 +419,14 @@ void FatxIO::WriteClusterChain(Partition *part, DWORD startingCluster,
     else if (startingCluster > part->clusterCount)
         throw std::string("FATX: Cluster is greater than cluster count.\n");
 
-    bool clusterSizeIs16 = part->clusterEntrySize == FAT16;
-
-    clusterChain.push_back(FAT_CLUSTER_LAST);
-
-    // we'll work with the clusters in 0x10000 chunks to minimize the amount of reads
-    BYTE buffer[0x10000];
+    // link every cluster to the one after it, the last one ends the chain
+    for (size_t i = 0; i + 1 < clusterChain.size(); i++)
+        part->chainmap->Set(clusterChain.at(i), clusterChain.at(i + 1));
+    part->chainmap->Set(clusterChain.back(), FAT_CLUSTER_LAST);
 
-    for (DWORD i = 1; i < clusterChain.size(); i++)
-    {
-        // seek to the lowest cluster in the chainmap, but round to get a fast read
-        UINT64 clusterEntryAddr = (part->address + 0x1000 + clusterChain.at(i - 1) *
-                part->clusterEntrySize);
-        device->SetPosition(DOWN_TO_NEAREST_SECTOR(clusterEntryAddr));
-
-        // read in a chunk of the chainmap
-        device->ReadBytes(buffer, 0x10000);
-
-        // open a MemoryIO on the memory for easier access
-        MemoryIO bufferIO(buffer, 0x10000);
-
-        // calculate the offset of the cluster in the buffer
-        UINT64 clusterEntryOffset = clusterEntryAddr - DOWN_TO_NEAREST_SECTOR(clusterEntryAddr);
-
-        // loop while still in the bounds of the buffer
-        while (clusterEntryOffset < 0x10000)
-        {
-            // seek to the address of the cluster in the buffer
-            bufferIO.SetPosition(clusterEntryOffset);
-
-            // set the cluster chain map entry to the value requested
-            if (clusterSizeIs16)
-                bufferIO.Write((WORD)clusterChain.at(i));
-            else
-                bufferIO.Write((DWORD)clusterChain.at(i));
-
-            if (i + 1 == clusterChain.size())
-            {
-                ++i;
-                break;
-            }
-
-            // calculate the value of the next cluster entry
-            clusterEntryOffset = (part->address + 0x1000 + clusterChain.at(i++) * part->clusterEntrySize) -
-                    DOWN_TO_NEAREST_SECTOR(clusterEntryAddr);
-        }
-        --i;
-
-        // once we're done then Write the block of memory back
-        device->SetPosition(DOWN_TO_NEAREST_SECTOR(clusterEntryAddr));
-        device->WriteBytes(buffer, 0x10000);
-    }
-
-    // flush the device just to be safe
+    // only the pages of the chainmap that changed are written back
+    part->chainmap->Flush();
     device->Flush();
-
-    /*for (int i = 0; i < clusterChain.size(); i++)
-    {
-        device->SetPosition(part->address + 0x1000 + (previousCluster * part->clusterEntrySize));
-
-        if (clusterSizeIs16)
-            device->Write((WORD)clusterChain.at(i));
-        else
-            device->Write((DWORD)clusterChain.at(i));
-
-        previousCluster = clusterChain.at(i);
-    }*/
 }
 
 void FatxIO::GetConsecutive(std::vector<DWORD> &list, std::vector<Range> &outRanges,
@@ -561,10 +452,16 @@ void FatxIO::GetConsecutive(std::vector<DWORD> &list, std::vector<Range> &outRan
     }
 }
 
-void FatxIO::SaveFile(std::string savePath, void(*progress)(void*, DWORD, DWORD), void *arg)
+void FatxIO::SaveFile(std::string savePath, void(*progress)(void*, DWORD, DWORD), void *arg,
+        OperationContext *context)
 {
+    if (context)
+    {
+        context->ThrowIfCancelled();
+        context->BeginItem(entry->fileSize);
+    }
+
     // get the current position
-    UINT64 pos;
     UINT64 originalPos = device->GetPosition();
 
     // seek to the beggining of the file
@@ -577,75 +474,100 @@ void FatxIO::SaveFile(std::string savePath, void(*progress)(void*, DWORD, DWORD)
     else if (bufferSize > 0x100000)
         bufferSize = 0x100000;
 
-    std::vector<Range> readRanges;
-    std::vector<BYTE> buffer(bufferSize);
+    // open the new file
+    FileIO outFile(savePath, true);
 
-    // generate the read ranges
-    for (DWORD i = 0; i < entry->clusterChain.size() - 1; i++)
+    if (entry->fileSize == 0)
     {
-        // calculate cluster's address
-        pos = ClusterToOffset(entry->partition, entry->clusterChain.at(i));
-
-        Range range = { pos, 0 };
-        do
-        {
-            range.len += entry->partition->clusterSize;
-
-            i++;
-        }
-        while ((entry->clusterChain.at(i - 1) + 1) == entry->clusterChain.at(i) &&
-                i < (entry->clusterChain.size() - 2) && (range.len + entry->partition->clusterSize) <= bufferSize);
-        i--;
-
-        readRanges.push_back(range);
+        outFile.Close();
+        if (progress)
+            progress(arg, 1, 1);
+        if (context)
+            context->EndItem();
+        return;
     }
 
-    DWORD finalClusterSize = entry->fileSize % entry->partition->clusterSize;
-    UINT64 finalClusterOffset = ClusterToOffset(entry->partition,
-            entry->clusterChain.at(entry->clusterChain.size() - 1));
-    Range lastRange = { finalClusterOffset , (finalClusterSize == 0) ? entry->partition->clusterSize : finalClusterSize};
-    readRanges.push_back(lastRange);
+    std::vector<std::vector<Extent>> batches = AsyncIO::SplitExtents(fileExtents(), bufferSize);
 
-    DWORD modulus = readRanges.size() / 100;
+    DWORD modulus = batches.size() / 100;
     if (modulus == 0)
         modulus = 1;
     else if (modulus > 3)
         modulus = 3;
 
-    // open the new file
-    FileIO outFile(savePath, true);
-
-    if (entry->fileSize == 0)
+    // update progress if needed, every batch but the last fills a whole buffer
+    CopyPipeline pipeline(bufferSize);
+    if (progress)
     {
-        outFile.Close();
-        if (progress)
-            progress(arg, 1, 1);
-        return;
+        pipeline.SetProgress([&](UINT64 bytesWritten)
+        {
+            DWORD batchesWritten = (DWORD)(bytesWritten / bufferSize);
+            if (batchesWritten % modulus == 0)
+                progress(arg, batchesWritten, batches.size());
+        });
     }
 
-    // read all the data in
-    for (DWORD i = 0; i < readRanges.size(); i++)
+    pipeline.SetContext(context);
+
+    // read a buffer's worth of the file at a time, every run of clusters in it is in flight at once,
+    // while the batches before it are written out
+    bool finished = pipeline.Run([&](UINT64 i, BYTE *buffer)
     {
-        // seek to the beginning of the range
-        device->SetPosition(readRanges.at(i).start);
+        if (i >= batches.size())
+            return (DWORD)0;
 
-        // get the range from the device
-    device->ReadBytes(buffer.data(), readRanges.at(i).len);
-    outFile.WriteBytes(buffer.data(), readRanges.at(i).len);
+        DWORD batchLength = 0;
+        for (const Extent &extent : batches.at(i))
+            batchLength += extent.length;
 
-        // update progress if needed
-        if (progress && i % modulus == 0)
-            progress(arg, i + 1, readRanges.size());
+        device->ReadV(batches.at(i), buffer);
+        return batchLength;
+    },
+    [&](UINT64, const BYTE *buffer, DWORD len)
+    {
+        outFile.WriteBytes(const_cast<BYTE*>(buffer), len);
+    });
+
+    // don't leave half a file behind when it was cancelled
+    if (!finished)
+    {
+        outFile.Close();
+        remove(savePath.c_str());
+        device->SetPosition(originalPos);
+        context->ThrowIfCancelled();
     }
 
     // make sure it hits the end
     if (progress)
-        progress(arg, readRanges.size(), readRanges.size());
+        progress(arg, batches.size(), batches.size());
 
     outFile.Flush();
     outFile.Close();
 
     device->SetPosition(originalPos);
+
+    if (context)
+        context->EndItem();
+}
+
+std::vector<Extent> FatxIO::fileExtents()
+{
+    updateChainExtents();
+
+    // the runs of the chain, cut off at the end of the file
+    std::vector<Extent> extents;
+    UINT64 remaining = entry->fileSize;
+    for (const Extent &run : chainExtents)
+    {
+        if (remaining == 0)
+            break;
+
+        DWORD length = (DWORD)std::min<UINT64>(remaining, run.length);
+        extents.push_back({ run.offset, length });
+        remaining -= length;
+    }
+
+    return extents;
 }
 
 UINT64 FatxIO::ClusterToOffset(Partition *part, DWORD cluster)
@@ -653,9 +575,7 @@ UINT64 FatxIO::ClusterToOffset(Partition *part, DWORD cluster)
     return part->clusterStartingAddress + (part->clusterSize * (INT64)(cluster - 1));
 }
 
-bool compareRanges(Range a, Range b)
+void FatxIO::ChainChanged(FatxFileEntry *entry)
 {
-    return a.len > b.len;
+    entry->chainGeneration = ++lastChainGeneration;
 }
-
-
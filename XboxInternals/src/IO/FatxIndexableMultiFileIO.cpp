@@ -16,14 +16,12 @@ FatxIndexableMultiFileIO::FatxIndexableMultiFileIO(std::string fileDirectory, Fa
         throw std::string("MultiFileIO: Directory is empty\n");
     }
 
-    currentIO = openFile(files.front());
+    currentIO = acquireFile(0);
 }
 
 FatxIndexableMultiFileIO::~FatxIndexableMultiFileIO()
 {
-    if (currentIO) {
-        currentIO->Close();
-    }
+    Close();
 }
 
 void FatxIndexableMultiFileIO::loadDirectories(std::string path)
@@ -1,8 +1,15 @@
 #include <XboxInternals/IO/FileIO.h>
 #include <vector>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 FileIO::FileIO(string path, bool truncate) :
-    BaseIO(), filePath(path)
+    BaseIO(), filePath(path), fd(-1), streamDirty(false), readaheadSegmentSize(0), readaheadSegmentCount(0)
 {
     fstr = std::make_unique<fstream>(path.c_str(),
             fstream::in | fstream::out | fstream::binary | (truncate ? fstream::trunc :
@@ -22,6 +29,11 @@ FileIO::FileIO(string path, bool truncate) :
     fstr->seekp(0, std::ios_base::end);
     length = fstr->tellp();
     fstr->seekp(0);
+
+#ifndef _WIN32
+    // a second descriptor for positional io, so it doesn't disturb the stream's position
+    fd = open(path.c_str(), O_RDWR);
+#endif
 }
 
 void FileIO::SetPosition(UINT64 pos, ios_base::seekdir dir)
@@ -41,14 +53,26 @@ UINT64 FileIO::Length()
 
 void FileIO::Close()
 {
+    // the helper thread reads through the descriptor, so it has to go first
+    readahead.reset();
+
     if (fstr)
         fstr->close();
+
+#ifndef _WIN32
+    if (fd != -1)
+    {
+        close(fd);
+        fd = -1;
+    }
+#endif
 }
 
 void FileIO::Flush()
 {
     if (fstr)
         fstr->flush();
+    streamDirty = false;
 }
 
 void FileIO::ReverseGenericArray(void *arr, int elemSize, int len)
@@ -73,6 +97,20 @@ string FileIO::GetFilePath()
 
 void FileIO::ReadBytes(BYTE *outBuffer, DWORD len)
 {
+    if (readahead && len >= READAHEAD_MIN_READ_SIZE)
+    {
+        // the helper reads through the descriptor, so it has to see everything the stream was holding
+        if (streamDirty)
+            Flush();
+
+        UINT64 position = GetPosition();
+        if (readahead->Read(position, outBuffer, len))
+        {
+            fstr->seekp(position + len);
+            return;
+        }
+    }
+
     fstr->read((fstream::char_type*)outBuffer, len);
     if (fstr->fail())
         throw string("FileIO: Error reading from file.\n");
@@ -80,15 +118,166 @@ void FileIO::ReadBytes(BYTE *outBuffer, DWORD len)
 
 void FileIO::WriteBytes(BYTE *buffer, DWORD len)
 {
+    // while a stream is being prefetched, writes go through the descriptor so the helper sees them
+    if (readahead && readahead->IsStreaming())
+    {
+        UINT64 position = GetPosition();
+        WriteAt(position, buffer, len);
+        fstr->seekp(position + len);
+        return;
+    }
+
     fstr->write((fstream::char_type*)buffer, len);
     if (fstr->fail())
         throw string("FileIO: Error writing to file.\n");
+    streamDirty = true;
+}
+
+void FileIO::ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len)
+{
+#ifndef _WIN32
+    if (fd != -1)
+    {
+        // make sure the descriptor sees anything still sitting in the stream's buffer
+        if (streamDirty)
+            Flush();
+
+        while (len > 0)
+        {
+            ssize_t bytesRead = pread(fd, outBuffer, len, offset);
+            if (bytesRead < 0 && errno == EINTR)
+                continue;
+            if (bytesRead <= 0)
+                throw string("FileIO: Error reading from file.\n");
+
+            outBuffer += bytesRead;
+            offset += bytesRead;
+            len -= bytesRead;
+        }
+        return;
+    }
+#endif
+
+    BaseIO::ReadAt(offset, outBuffer, len);
+}
+
+void FileIO::WriteAt(UINT64 offset, BYTE *buffer, DWORD len)
+{
+#ifndef _WIN32
+    if (fd != -1)
+    {
+        if (streamDirty)
+            Flush();
+
+        UINT64 startingOffset = offset;
+        UINT64 endingOffset = offset + len;
+        while (len > 0)
+        {
+            ssize_t bytesWritten = pwrite(fd, buffer, len, offset);
+            if (bytesWritten < 0 && errno == EINTR)
+                continue;
+            if (bytesWritten <= 0)
+                throw string("FileIO: Error writing to file.\n");
+
+            buffer += bytesWritten;
+            offset += bytesWritten;
+            len -= bytesWritten;
+        }
+
+        if (endingOffset > length)
+            length = endingOffset;
+
+        if (readahead)
+            readahead->Invalidate(startingOffset, endingOffset - startingOffset);
+
+        // re-seeking to the same position drops whatever the stream had buffered, which may be stale now
+        fstr->seekp(fstr->tellp());
+        return;
+    }
+#endif
+
+    BaseIO::WriteAt(offset, buffer, len);
+}
+
+void FileIO::SetReadahead(DWORD segmentSize, DWORD segmentCount)
+{
+    readahead.reset();
+    readaheadSegmentSize = segmentSize;
+    readaheadSegmentCount = segmentCount;
+
+    // without a descriptor there's no way to read without moving the stream
+    if (fd == -1 || segmentCount == 0)
+        return;
+
+    readahead = std::make_unique<Readahead>([this](UINT64 offset, BYTE *outBuffer, DWORD len)
+    {
+        return readUpTo(offset, outBuffer, len);
+    }, segmentSize, segmentCount);
+}
+
+FileIO::ReadaheadScope::ReadaheadScope(FileIO *file, DWORD segmentSize, DWORD segmentCount) :
+    file(file), previousSegmentSize(0), previousSegmentCount(0)
+{
+    if (!file)
+        return;
+
+    previousSegmentSize = file->readaheadSegmentSize;
+    previousSegmentCount = file->readaheadSegmentCount;
+    file->SetReadahead(segmentSize, segmentCount);
+}
+
+FileIO::ReadaheadScope::~ReadaheadScope()
+{
+    if (file)
+        file->SetReadahead(previousSegmentSize, previousSegmentCount);
+}
+
+DWORD FileIO::readUpTo(UINT64 offset, BYTE *outBuffer, DWORD len)
+{
+    DWORD totalRead = 0;
+#ifndef _WIN32
+    while (totalRead < len)
+    {
+        ssize_t bytesRead = pread(fd, outBuffer + totalRead, len - totalRead, offset + totalRead);
+        if (bytesRead < 0 && errno == EINTR)
+            continue;
+        if (bytesRead < 0)
+            throw string("FileIO: Error reading from file.\n");
+        if (bytesRead == 0)
+            break;
+
+        totalRead += bytesRead;
+    }
+#endif
+    return totalRead;
+}
+
+ReadCompletion FileIO::SubmitReads(std::vector<ReadRequest> requests)
+{
+    // without a descriptor the reads would all share the stream's position
+    if (fd == -1)
+        return BaseIO::SubmitReads(std::move(requests));
+
+    if (streamDirty)
+        Flush();
+
+    return AsyncIO::SubmitToDescriptor(fd, std::move(requests), [this](const ReadRequest &request)
+    {
+        ReadAt(request.offset, request.buffer, request.length);
+    });
 }
 
 FileIO::~FileIO(void)
 {
+    readahead.reset();
+
     if (fstr && fstr->is_open())
         fstr->close();
+
+#ifndef _WIN32
+    if (fd != -1)
+        close(fd);
+#endif
 }
 
 
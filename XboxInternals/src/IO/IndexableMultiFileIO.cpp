@@ -1,47 +1,124 @@
 #include <XboxInternals/IO/IndexableMultiFileIO.h>
 
 #include <algorithm>
+#include <iterator>
 
 IndexableMultiFileIO::IndexableMultiFileIO()
-    : addressInFile(0), fileIndex(0), currentIO(nullptr) {}
+    : addressInFile(0), fileIndex(0), currentIO(nullptr), maxOpenFiles(INDEXABLEMULTIFILEIO_DEFAULT_MAX_OPEN_FILES),
+      readahead(false) {}
 
 IndexableMultiFileIO::~IndexableMultiFileIO() = default;
 
 void IndexableMultiFileIO::SetPosition(DWORD newAddressInFile, int desiredFileIndex)
 {
-    if (currentIO == nullptr && files.empty()) {
+    if (files.empty()) {
         throw std::string("MultiFileIO: No files are loaded.");
     }
 
-    if (desiredFileIndex == -1 || static_cast<DWORD>(desiredFileIndex) == fileIndex) {
-        if (newAddressInFile >= CurrentFileLength()) {
-            throw std::string("MultiFileIO: Cannot seek beyond the end of the file\n");
-        }
-
-        currentIO->SetPosition(newAddressInFile);
-        addressInFile = newAddressInFile;
-        return;
+    if (desiredFileIndex == -1) {
+        desiredFileIndex = static_cast<int>(fileIndex);
     }
 
     if (desiredFileIndex < 0 || static_cast<size_t>(desiredFileIndex) >= files.size()) {
         throw std::string("MultiFileIO: Specified file index is out of range\n");
     }
 
-    if (currentIO != nullptr) {
-        currentIO->Close();
-        currentIO.reset();
-    }
-
-    currentIO = openFile(files.at(static_cast<size_t>(desiredFileIndex)));
-    if (newAddressInFile >= CurrentFileLength()) {
+    // switching parts only costs an open when the part has fallen out of the pool
+    BaseIO *file = acquireFile(static_cast<DWORD>(desiredFileIndex));
+    if (newAddressInFile >= openFiles.at(static_cast<DWORD>(desiredFileIndex)).length) {
         throw std::string("MultiFileIO: Cannot seek beyond the end of the file\n");
     }
 
+    currentIO = file;
     addressInFile = newAddressInFile;
     fileIndex = static_cast<DWORD>(desiredFileIndex);
     currentIO->SetPosition(addressInFile);
 }
 
+BaseIO *IndexableMultiFileIO::acquireFile(DWORD index)
+{
+    auto open = openFiles.find(index);
+    if (open != openFiles.end()) {
+        lru.splice(lru.begin(), lru, open->second.lruPosition);
+        return open->second.io.get();
+    }
+
+    // close the least recently used parts to make room. The current part stays open, so if the caller's seek
+    // into the new part fails the position is still where it was.
+    while (openFiles.size() >= maxOpenFiles) {
+        auto victim = std::find_if(lru.rbegin(), lru.rend(), [this](DWORD open) {
+            return openFiles.at(open).io.get() != currentIO;
+        });
+        if (victim == lru.rend()) {
+            break;
+        }
+
+        auto evicted = openFiles.find(*victim);
+        evicted->second.io->Close();
+        openFiles.erase(evicted);
+        lru.erase(std::next(victim).base());
+    }
+
+    std::unique_ptr<BaseIO> io = openFile(files.at(index));
+
+    // the parts don't change size, so they're only measured once
+    io->SetPosition(0, std::ios_base::end);
+    DWORD length = static_cast<DWORD>(io->GetPosition());
+    io->SetPosition(0);
+
+    if (readahead) {
+        setReadahead(io.get(), true);
+    }
+
+    lru.push_front(index);
+    OpenFile &entry = openFiles[index];
+    entry.io = std::move(io);
+    entry.length = length;
+    entry.lruPosition = lru.begin();
+    return entry.io.get();
+}
+
+void IndexableMultiFileIO::SetMaxOpenFiles(DWORD count)
+{
+    maxOpenFiles = std::max<DWORD>(count, 1);
+
+    while (openFiles.size() > maxOpenFiles) {
+        auto evicted = openFiles.find(lru.back());
+
+        // keep the current part open, it's the most recently used one anyway
+        if (evicted->second.io.get() == currentIO) {
+            break;
+        }
+
+        evicted->second.io->Close();
+        openFiles.erase(evicted);
+        lru.pop_back();
+    }
+}
+
+void IndexableMultiFileIO::SetReadahead(bool enabled)
+{
+    readahead = enabled;
+    for (auto &open : openFiles) {
+        setReadahead(open.second.io.get(), enabled);
+    }
+}
+
+void IndexableMultiFileIO::setReadahead(BaseIO *, bool)
+{
+}
+
+IndexableMultiFileIO::ReadaheadScope::ReadaheadScope(IndexableMultiFileIO *io) :
+    io(io), previous(io->readahead)
+{
+    io->SetReadahead(true);
+}
+
+IndexableMultiFileIO::ReadaheadScope::~ReadaheadScope()
+{
+    io->SetReadahead(previous);
+}
+
 void IndexableMultiFileIO::GetPosition(DWORD *addressOut, DWORD *fileIndexOut)
 {
     if (addressOut) {
@@ -58,24 +135,24 @@ DWORD IndexableMultiFileIO::CurrentFileLength()
         throw std::string("MultiFileIO: No current file is open\n");
     }
 
-    currentIO->SetPosition(0, std::ios_base::end);
-    DWORD fileLen = static_cast<DWORD>(currentIO->GetPosition());
-    currentIO->SetPosition(addressInFile);
-    return fileLen;
+    return openFiles.at(fileIndex).length;
 }
 
 void IndexableMultiFileIO::ReadBytes(BYTE *outBuffer, DWORD len)
 {
     while (len > 0) {
         DWORD bytesLeft = CurrentFileLength() - addressInFile;
-        DWORD amountToRead = (bytesLeft > len) ? len : bytesLeft;
+        if (bytesLeft == 0) {
+            throw std::string("MultiFileIO: Cannot read beyond the end of the last file\n");
+        }
 
+        DWORD amountToRead = (bytesLeft > len) ? len : bytesLeft;
         currentIO->ReadBytes(outBuffer, amountToRead);
+        addressInFile += amountToRead;
 
-        if (len >= bytesLeft && (fileIndex + 1) < FileCount()) {
+        // carry on at the start of the next file once this one runs out
+        if (amountToRead == bytesLeft && (fileIndex + 1) < FileCount()) {
             SetPosition(static_cast<DWORD>(0), static_cast<int>(fileIndex + 1));
-        } else if (len < bytesLeft) {
-            SetPosition(addressInFile + len);
         }
 
         len -= amountToRead;
@@ -87,14 +164,16 @@ void IndexableMultiFileIO::WriteBytes(BYTE *buffer, DWORD len)
 {
     while (len > 0) {
         DWORD bytesLeft = CurrentFileLength() - addressInFile;
-        DWORD amountToWrite = (bytesLeft > len) ? len : bytesLeft;
+        if (bytesLeft == 0) {
+            throw std::string("MultiFileIO: Cannot write beyond the end of the last file\n");
+        }
 
+        DWORD amountToWrite = (bytesLeft > len) ? len : bytesLeft;
         currentIO->Write(buffer, amountToWrite);
+        addressInFile += amountToWrite;
 
-        if (len >= bytesLeft) {
+        if (amountToWrite == bytesLeft && (fileIndex + 1) < FileCount()) {
             SetPosition(static_cast<DWORD>(0), static_cast<int>(fileIndex + 1));
-        } else {
-            SetPosition(addressInFile + len);
         }
 
         len -= amountToWrite;
@@ -102,17 +181,39 @@ void IndexableMultiFileIO::WriteBytes(BYTE *buffer, DWORD len)
     }
 }
 
+void IndexableMultiFileIO::ReadAt(DWORD address, DWORD desiredFileIndex, BYTE *outBuffer, DWORD len)
+{
+    if (currentIO == nullptr || desiredFileIndex != fileIndex) {
+        SetPosition(address, static_cast<int>(desiredFileIndex));
+    }
+
+    currentIO->ReadAt(address, outBuffer, len);
+}
+
+void IndexableMultiFileIO::WriteAt(DWORD address, DWORD desiredFileIndex, BYTE *buffer, DWORD len)
+{
+    if (currentIO == nullptr || desiredFileIndex != fileIndex) {
+        SetPosition(address, static_cast<int>(desiredFileIndex));
+    }
+
+    currentIO->WriteAt(address, buffer, len);
+}
+
 void IndexableMultiFileIO::Close()
 {
-    if (currentIO) {
-        currentIO->Close();
+    for (auto &open : openFiles) {
+        open.second.io->Close();
     }
+
+    openFiles.clear();
+    lru.clear();
+    currentIO = nullptr;
 }
 
 void IndexableMultiFileIO::Flush()
 {
-    if (currentIO) {
-        currentIO->Flush();
+    for (auto &open : openFiles) {
+        open.second.io->Flush();
     }
 }
 
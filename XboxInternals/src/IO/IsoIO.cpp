@@ -16,26 +16,33 @@ IsoIO::IsoIO(BaseIO *isoIO, std::string isoFilePath, XboxInternals::Iso::IsoImag
 
 void IsoIO::ReadBytes(BYTE *outBuffer, DWORD len)
 {
-    SetPosition(GetPosition());
+    // the ISO's io is shared between files, so read positionally instead of re-seeking it
+    ReadAt(GetPosition(), outBuffer, len);
+    virtualPosition += len;
+}
+
+void IsoIO::WriteBytes(BYTE *buffer, DWORD len)
+{
+    WriteAt(GetPosition(), buffer, len);
+    virtualPosition += len;
+}
 
+void IsoIO::ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len)
+{
     // check for end of file
-    if (GetPosition() + len > Length())
+    if (offset + len > Length())
         throw std::string("IsoIO: Cannot read beyond end of file.");
 
-    isoIO->ReadBytes(outBuffer, len);
-    virtualPosition += len;
+    isoIO->ReadAt(iso->SectorToAddress(entry->sector) + offset, outBuffer, len);
 }
 
-void IsoIO::WriteBytes(BYTE *buffer, DWORD len)
+void IsoIO::WriteAt(UINT64 offset, BYTE *buffer, DWORD len)
 {
-    SetPosition(GetPosition());
-
     // check for end of file
-    if (GetPosition() + len > Length())
+    if (offset + len > Length())
         throw std::string("IsoIO: Cannot write beyond end of file.");
 
-    isoIO->WriteBytes(buffer, len);
-    virtualPosition += len;
+    isoIO->WriteAt(iso->SectorToAddress(entry->sector) + offset, buffer, len);
 }
 
 UINT64 IsoIO::GetPosition()
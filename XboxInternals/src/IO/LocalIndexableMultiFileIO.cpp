@@ -7,6 +7,10 @@
 #include <XboxInternals/IO/FileIO.h>
 #include <XboxInternals/Utils.h>
 
+// readahead ring for each part, kept small since many parts can be open at once
+#define LOCALINDEXABLEMULTIFILEIO_READAHEAD_SEGMENT_SIZE 0x40000
+#define LOCALINDEXABLEMULTIFILEIO_READAHEAD_SEGMENT_COUNT 2
+
 LocalIndexableMultiFileIO::LocalIndexableMultiFileIO(std::string fileDirectory)
 {
     loadDirectories(std::move(fileDirectory));
@@ -15,14 +19,12 @@ LocalIndexableMultiFileIO::LocalIndexableMultiFileIO(std::string fileDirectory)
         throw std::string("MultiFileIO: Directory is empty\n");
     }
 
-    currentIO = std::make_unique<FileIO>(files.front());
+    currentIO = acquireFile(0);
 }
 
 LocalIndexableMultiFileIO::~LocalIndexableMultiFileIO()
 {
-    if (currentIO) {
-        currentIO->Close();
-    }
+    Close();
 }
 
 void LocalIndexableMultiFileIO::loadDirectories(std::string path)
@@ -35,3 +37,9 @@ std::unique_ptr<BaseIO> LocalIndexableMultiFileIO::openFile(std::string path)
 {
     return std::make_unique<FileIO>(std::move(path));
 }
+
+void LocalIndexableMultiFileIO::setReadahead(BaseIO *file, bool enabled)
+{
+    static_cast<FileIO*>(file)->SetReadahead(LOCALINDEXABLEMULTIFILEIO_READAHEAD_SEGMENT_SIZE,
+            enabled ? LOCALINDEXABLEMULTIFILEIO_READAHEAD_SEGMENT_COUNT : 0);
+}
@@ -0,0 +1,277 @@
+#include <XboxInternals/IO/MappedFileIO.h>
+
+#include <algorithm>
+#include <string.h>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+class MappedFileIO::Impl
+{
+public:
+#ifdef _WIN32
+    Impl() : fileHandle(INVALID_HANDLE_VALUE), mappingHandle(NULL) {}
+    HANDLE fileHandle;
+    HANDLE mappingHandle;
+#else
+    Impl() : fd(-1) {}
+    int fd;
+#endif
+};
+
+MappedFileIO::MappedFileIO(std::string path, bool readOnly) :
+    BaseIO(), impl(std::make_unique<Impl>()), filePath(std::move(path)), readOnly(readOnly),
+    data(nullptr), length(0), mappedLength(0), pos(0)
+{
+    UINT64 fileLength;
+
+#ifdef _WIN32
+    // the path is utf-8, like everywhere else
+    int wideLength = MultiByteToWideChar(CP_UTF8, 0, filePath.c_str(), -1, NULL, 0);
+    if (wideLength == 0)
+        throw std::string("MappedFileIO: Invalid file path.\n");
+    std::wstring widePath(wideLength, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, filePath.c_str(), -1, &widePath[0], wideLength);
+    impl->fileHandle = CreateFileW(widePath.c_str(), GENERIC_READ | (readOnly ? 0 : GENERIC_WRITE),
+            FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (impl->fileHandle == INVALID_HANDLE_VALUE)
+        throw std::string("MappedFileIO: Error opening the file.\n");
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(impl->fileHandle, &size))
+    {
+        Close();
+        throw std::string("MappedFileIO: Error getting the file size.\n");
+    }
+    fileLength = (UINT64)size.QuadPart;
+#else
+    impl->fd = open(filePath.c_str(), readOnly ? O_RDONLY : O_RDWR);
+    if (impl->fd == -1)
+        throw std::string("MappedFileIO: Error opening the file. ") + strerror(errno) + "\n";
+
+    struct stat fileStats;
+    if (fstat(impl->fd, &fileStats) != 0)
+    {
+        Close();
+        throw std::string("MappedFileIO: Error getting the file size.\n");
+    }
+    fileLength = (UINT64)fileStats.st_size;
+#endif
+
+    try
+    {
+        map(fileLength);
+        length = fileLength;
+    }
+    catch (std::string&)
+    {
+        Close();
+        throw;
+    }
+}
+
+MappedFileIO::~MappedFileIO()
+{
+    Close();
+}
+
+void MappedFileIO::map(UINT64 newMappedLength)
+{
+    mappedLength = newMappedLength;
+    if (mappedLength == 0)
+        return;
+
+#ifdef _WIN32
+    impl->mappingHandle = CreateFileMappingW(impl->fileHandle, NULL, readOnly ? PAGE_READONLY :
+            PAGE_READWRITE, 0, 0, NULL);
+    if (impl->mappingHandle == NULL)
+        throw std::string("MappedFileIO: Error mapping the file.\n");
+
+    data = (BYTE*)MapViewOfFile(impl->mappingHandle, readOnly ? FILE_MAP_READ : FILE_MAP_WRITE, 0, 0,
+            (SIZE_T)mappedLength);
+    if (data == nullptr)
+        throw std::string("MappedFileIO: Error mapping the file.\n");
+#else
+    void *mapping = mmap(nullptr, (size_t)mappedLength, PROT_READ | (readOnly ? 0 : PROT_WRITE), MAP_SHARED,
+            impl->fd, 0);
+    if (mapping == MAP_FAILED)
+        throw std::string("MappedFileIO: Error mapping the file. ") + strerror(errno) + "\n";
+    data = (BYTE*)mapping;
+#endif
+}
+
+void MappedFileIO::unmap()
+{
+#ifdef _WIN32
+    if (data != nullptr)
+        UnmapViewOfFile(data);
+    if (impl->mappingHandle != NULL)
+    {
+        CloseHandle(impl->mappingHandle);
+        impl->mappingHandle = NULL;
+    }
+#else
+    if (data != nullptr)
+        munmap(data, (size_t)mappedLength);
+#endif
+
+    data = nullptr;
+    mappedLength = 0;
+}
+
+void MappedFileIO::grow(UINT64 newLength)
+{
+    if (readOnly)
+        throw std::string("MappedFileIO: Cannot Write to a read only file.\n");
+
+    // there's still room in the mapping from the last time it grew
+    if (newLength <= mappedLength)
+    {
+        length = newLength;
+        return;
+    }
+
+    UINT64 newMappedLength = std::max(newLength, mappedLength + std::max<UINT64>(mappedLength / 2,
+            MAPPEDFILEIO_MIN_GROWTH));
+
+    unmap();
+    resize(newMappedLength);
+    map(newMappedLength);
+    length = newLength;
+}
+
+void MappedFileIO::resize(UINT64 newLength)
+{
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    size.QuadPart = (LONGLONG)newLength;
+    if (!SetFilePointerEx(impl->fileHandle, size, NULL, FILE_BEGIN) || !SetEndOfFile(impl->fileHandle))
+        throw std::string("MappedFileIO: Error resizing the file.\n");
+#else
+    if (ftruncate(impl->fd, (off_t)newLength) != 0)
+        throw std::string("MappedFileIO: Error resizing the file. ") + strerror(errno) + "\n";
+#endif
+}
+
+std::span<const BYTE> MappedFileIO::View(UINT64 offset, UINT64 len)
+{
+    if (offset + len > length)
+        throw std::string("MappedFileIO: Cannot view beyond the end of the file.\n");
+
+    return std::span<const BYTE>(data + offset, (size_t)len);
+}
+
+void MappedFileIO::SetPosition(UINT64 position, std::ios_base::seekdir dir)
+{
+    if (dir == std::ios_base::cur)
+        position += pos;
+    else if (dir == std::ios_base::end)
+        position += length;
+
+    pos = position;
+}
+
+UINT64 MappedFileIO::GetPosition()
+{
+    return pos;
+}
+
+UINT64 MappedFileIO::Length()
+{
+    return length;
+}
+
+void MappedFileIO::ReadBytes(BYTE *outBuffer, DWORD len)
+{
+    ReadAt(pos, outBuffer, len);
+    pos += len;
+}
+
+void MappedFileIO::WriteBytes(BYTE *buffer, DWORD len)
+{
+    WriteAt(pos, buffer, len);
+    pos += len;
+}
+
+void MappedFileIO::ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len)
+{
+    if (offset + len > length)
+        throw std::string("MappedFileIO: Cannot read beyond the end of the file.\n");
+
+    memcpy(outBuffer, data + offset, len);
+}
+
+void MappedFileIO::WriteAt(UINT64 offset, BYTE *buffer, DWORD len)
+{
+    if (readOnly)
+        throw std::string("MappedFileIO: Cannot Write to a read only file.\n");
+
+    if (offset + len > length)
+        grow(offset + len);
+
+    memcpy(data + offset, buffer, len);
+}
+
+void MappedFileIO::Flush()
+{
+    if (data == nullptr || readOnly)
+        return;
+
+#ifdef _WIN32
+    FlushViewOfFile(data, 0);
+#else
+    msync(data, (size_t)mappedLength, MS_ASYNC);
+#endif
+}
+
+void MappedFileIO::Close()
+{
+    bool trim = !readOnly && mappedLength > length;
+    unmap();
+
+    // cut off the space the file was grown by that never got written, if that fails the file just keeps it
+    if (trim)
+    {
+        try
+        {
+            resize(length);
+        }
+        catch (std::string&)
+        {
+        }
+    }
+    length = 0;
+
+#ifdef _WIN32
+    if (impl->fileHandle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(impl->fileHandle);
+        impl->fileHandle = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (impl->fd != -1)
+    {
+        close(impl->fd);
+        impl->fd = -1;
+    }
+#endif
+}
+
+std::string MappedFileIO::GetFilePath()
+{
+    return filePath;
+}
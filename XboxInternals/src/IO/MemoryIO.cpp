@@ -1,11 +1,46 @@
 #include <XboxInternals/IO/MemoryIO.h>
+#include <XboxInternals/IO/FileIO.h>
+
+#include <algorithm>
+#include <utility>
+
+// the largest piece copied in or out of another io at once
+#define MEMORYIO_COPY_SIZE 0x100000
 
 MemoryIO::MemoryIO(BYTE *data, size_t length) :
-    BaseIO(), memory(data), length(length), pos(0)
+    BaseIO(), growable(false), memory(data), length(length), pos(0)
 {
     SetPosition(0);
 }
 
+MemoryIO::MemoryIO(std::vector<BYTE> data) :
+    BaseIO(), ownedMemory(std::move(data)), growable(true), pos(0)
+{
+    memory = ownedMemory.data();
+    length = ownedMemory.size();
+}
+
+MemoryIO::MemoryIO(BaseIO *source) :
+    BaseIO(), growable(true), pos(0)
+{
+    if (source == nullptr)
+        throw std::string("MemoryIO: Cannot copy a null io.\n");
+
+    byteOrder = source->GetEndian();
+
+    source->SetPosition(0, std::ios_base::end);
+    ownedMemory.resize(source->GetPosition());
+
+    for (UINT64 offset = 0; offset < ownedMemory.size(); offset += MEMORYIO_COPY_SIZE)
+    {
+        DWORD len = (DWORD)std::min<UINT64>(ownedMemory.size() - offset, MEMORYIO_COPY_SIZE);
+        source->ReadAt(offset, ownedMemory.data() + offset, len);
+    }
+
+    memory = ownedMemory.data();
+    length = ownedMemory.size();
+}
+
 MemoryIO::~MemoryIO()
 {
     SetPosition(0);
@@ -13,7 +48,7 @@ MemoryIO::~MemoryIO()
 
 void MemoryIO::SetPosition(UINT64 pos, std::ios_base::seekdir dir)
 {
-    DWORD newPos;
+    UINT64 newPos;
     switch (dir)
     {
         case std::ios_base::beg:
@@ -29,7 +64,8 @@ void MemoryIO::SetPosition(UINT64 pos, std::ios_base::seekdir dir)
             throw std::string("MemoryIO: Unsupported seek direction\n");
     }
 
-    if (newPos > length)
+    // a growable buffer can be seeked past the end, writing there fills the gap with zeros
+    if (newPos > length && !growable)
         throw std::string("MemoryIO: Cannot seek beyond the end of the stream\n");
     this->pos = newPos;
 }
@@ -46,18 +82,47 @@ UINT64 MemoryIO::Length()
 
 void MemoryIO::ReadBytes(BYTE *outBuffer, DWORD len)
 {
-    if (pos + len > length)
-        throw std::string("MemoryIO: Cannot read beyond the end of the stream\n");
-    memcpy(outBuffer, memory + pos, len);
+    ReadAt(pos, outBuffer, len);
     pos += len;
 }
 
 void MemoryIO::WriteBytes(BYTE *buffer, DWORD len)
 {
-    memcpy(memory + pos, buffer, len);
+    WriteAt(pos, buffer, len);
     pos += len;
 }
 
+void MemoryIO::ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len)
+{
+    if (offset > length || len > length - offset)
+        throw std::string("MemoryIO: Cannot read beyond the end of the stream\n");
+    memcpy(outBuffer, memory + offset, len);
+}
+
+void MemoryIO::WriteAt(UINT64 offset, BYTE *buffer, DWORD len)
+{
+    reserveRange(offset, len);
+    memcpy(memory + offset, buffer, len);
+}
+
+void MemoryIO::reserveRange(UINT64 offset, DWORD len)
+{
+    UINT64 end = offset + len;
+    if (end <= length)
+        return;
+
+    if (!growable)
+        throw std::string("MemoryIO: Cannot write beyond the end of the stream\n");
+
+    // grow geometrically so appending a little at a time doesn't copy the whole buffer every time
+    if (end > ownedMemory.capacity())
+        ownedMemory.reserve((size_t)std::max<UINT64>(end, ownedMemory.capacity() * 2));
+
+    ownedMemory.resize((size_t)end);
+    memory = ownedMemory.data();
+    length = end;
+}
+
 void MemoryIO::Close()
 {
 
@@ -68,5 +133,32 @@ void MemoryIO::Flush()
 
 }
 
+bool MemoryIO::IsGrowable()
+{
+    return growable;
+}
+
+BYTE *MemoryIO::GetBuffer()
+{
+    return memory;
+}
+
+void MemoryIO::SaveToIO(BaseIO *io)
+{
+    if (io == nullptr)
+        throw std::string("MemoryIO: Cannot save to a null io.\n");
 
+    for (UINT64 offset = 0; offset < length; offset += MEMORYIO_COPY_SIZE)
+    {
+        DWORD len = (DWORD)std::min<UINT64>(length - offset, MEMORYIO_COPY_SIZE);
+        io->WriteAt(offset, memory + offset, len);
+    }
+    io->Flush();
+}
 
+void MemoryIO::SaveToFile(std::string path)
+{
+    FileIO file(path, true);
+    SaveToIO(&file);
+    file.Close();
+}
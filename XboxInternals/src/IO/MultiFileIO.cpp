@@ -1,8 +1,9 @@
 #include <XboxInternals/IO/MultiFileIO.h>
 
+#include <algorithm>
 #include <memory>
 
-MultiFileIO::MultiFileIO(std::vector<std::string> filePaths) : pos(0), currentIOIndex(0)
+MultiFileIO::MultiFileIO(std::vector<std::string> filePaths) : pos(0)
 {
     files.reserve(filePaths.size());
     for (const auto &path : filePaths)
@@ -13,7 +14,7 @@ MultiFileIO::MultiFileIO(std::vector<std::string> filePaths) : pos(0), currentIO
     calculateLengthOfAllFiles();
 }
 
-MultiFileIO::MultiFileIO(std::vector<BaseIO*> ownedFiles) : pos(0), currentIOIndex(0)
+MultiFileIO::MultiFileIO(std::vector<BaseIO*> ownedFiles) : pos(0)
 {
     files.reserve(ownedFiles.size());
     for (auto *io : ownedFiles)
@@ -31,25 +32,13 @@ MultiFileIO::~MultiFileIO()
 
 void MultiFileIO::SetPosition(UINT64 position, std::ios_base::seekdir dir)
 {
-    if (dir == std::ios_base::end)
-        throw std::string("MultiFileIO: Unsupported seek dir.");
-    else if (dir == std::ios_base::cur)
+    if (dir == std::ios_base::cur)
         position += pos;
+    else if (dir == std::ios_base::end)
+        position += lengthOfFiles;
 
+    // the file it lands in is looked up when it's actually read from or written to
     pos = position;
-
-    // calculate which stream we should use
-    for (size_t i = 0; i < files.size(); i++)
-    {
-        if (position >= files.at(i)->Length())
-            position -= files.at(i)->Length();
-        else
-        {
-            currentIOIndex = i;
-            files.at(i)->SetPosition(position);
-            break;
-        }
-    }
 }
 
 UINT64 MultiFileIO::GetPosition()
@@ -64,62 +53,74 @@ UINT64 MultiFileIO::Length()
 
 void MultiFileIO::WriteBytes(BYTE *buffer, DWORD len)
 {
-    if (len > lengthOfFiles - pos)
-        throw std::string("MultiFileIO: Requested Write length is too large.\n");
-
-    DWORD offset = 0;
-
-    // check to see if we can Write straight from the current stream
-    if (files.at(currentIOIndex)->GetPosition() + len > files.at(currentIOIndex)->Length())
-    {
-        // if we can't, we must calculate how much we should read each time
-        while (len > 0)
-        {
-        DWORD WriteCount = (files.at(currentIOIndex)->Length() > files.at(currentIOIndex)->GetPosition() +
-            len) ? len : (files.at(currentIOIndex)->Length() - files.at(currentIOIndex)->GetPosition());
-        files.at(currentIOIndex)->WriteBytes(buffer + offset, WriteCount);
-            offset += WriteCount;
-            len -= WriteCount;
-            SetPosition(pos + WriteCount);
-        }
-    }
-    else
-    {
-        files.at(currentIOIndex)->WriteBytes(buffer, len);
-        pos += len;
-    }
+    WriteAt(pos, buffer, len);
+    pos += len;
 }
 
 void MultiFileIO::Flush()
 {
-    files.at(currentIOIndex)->Flush();
+    for (auto &file : files)
+        file->Flush();
 }
 
 void MultiFileIO::ReadBytes(BYTE *outBuffer, DWORD len)
 {
-    DWORD offset = 0;
+    ReadAt(pos, outBuffer, len);
+    pos += len;
+}
+
+void MultiFileIO::ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len)
+{
+    if (offset > lengthOfFiles || len > lengthOfFiles - offset)
+        throw std::string("MultiFileIO: Cannot read beyond the end of the files.\n");
 
-    // check to see if we can read straight from the current stream
-    if (files.at(currentIOIndex)->GetPosition() + len > files.at(currentIOIndex)->Length())
+    forEachPiece(offset, outBuffer, len, [](BaseIO *file, UINT64 offsetInFile, BYTE *piece, DWORD pieceLength)
     {
-        // if we can't, we must calculate how much we should read each time
-        while (len > 0)
-        {
-        DWORD readCount = (files.at(currentIOIndex)->Length() > files.at(currentIOIndex)->GetPosition() +
-            len) ? len : (files.at(currentIOIndex)->Length() - files.at(currentIOIndex)->GetPosition());
-        files.at(currentIOIndex)->ReadBytes(outBuffer + offset, readCount);
-            offset += readCount;
-            len -= readCount;
-            SetPosition(pos + readCount);
-        }
-    }
-    else
+        file->ReadAt(offsetInFile, piece, pieceLength);
+    });
+}
+
+void MultiFileIO::WriteAt(UINT64 offset, BYTE *buffer, DWORD len)
+{
+    if (offset > lengthOfFiles || len > lengthOfFiles - offset)
+        throw std::string("MultiFileIO: Requested Write length is too large.\n");
+
+    forEachPiece(offset, buffer, len, [](BaseIO *file, UINT64 offsetInFile, BYTE *piece, DWORD pieceLength)
     {
-        files.at(currentIOIndex)->ReadBytes(outBuffer, len);
-        pos += len;
+        file->WriteAt(offsetInFile, piece, pieceLength);
+    });
+}
+
+template <typename Function>
+void MultiFileIO::forEachPiece(UINT64 offset, BYTE *buffer, DWORD len, Function ioFunction)
+{
+    if (len == 0)
+        return;
+
+    // find the first file once, the rest of the range carries on into the ones after it
+    size_t index = fileIndexAt(offset);
+    while (len > 0)
+    {
+        UINT64 offsetInFile = offset - fileOffsets[index];
+        DWORD pieceLength = (DWORD)std::min<UINT64>(len, fileOffsets[index + 1] - offset);
+
+        if (pieceLength != 0)
+            ioFunction(files[index].get(), offsetInFile, buffer, pieceLength);
+
+        offset += pieceLength;
+        buffer += pieceLength;
+        len -= pieceLength;
+        index++;
     }
 }
 
+size_t MultiFileIO::fileIndexAt(UINT64 offset)
+{
+    // the last file starting at or before the offset, empty files share their start with the next one
+    auto next = std::upper_bound(fileOffsets.begin(), fileOffsets.end() - 1, offset);
+    return (size_t)(next - fileOffsets.begin()) - 1;
+}
+
 void MultiFileIO::Close()
 {
     if (isClosed)
@@ -135,8 +136,12 @@ void MultiFileIO::calculateLengthOfAllFiles()
     isClosed = false;
     lengthOfFiles = 0;
 
+    fileOffsets.clear();
+    fileOffsets.reserve(files.size() + 1);
     for (size_t i = 0; i < files.size(); i++)
+    {
+        fileOffsets.push_back(lengthOfFiles);
         lengthOfFiles += files.at(i)->Length();
+    }
+    fileOffsets.push_back(lengthOfFiles);
 }
-
-
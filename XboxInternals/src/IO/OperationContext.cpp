@@ -0,0 +1,88 @@
+#include <XboxInternals/IO/OperationContext.h>
+
+#include <string>
+
+OperationContext::OperationContext()
+{
+    Reset();
+}
+
+void OperationContext::SetTotals(UINT64 bytes, UINT64 items)
+{
+    bytesTotal = bytes;
+    itemsTotal = items;
+}
+
+void OperationContext::BeginItem(UINT64 itemBytes)
+{
+    itemBytesDone = 0;
+    itemBytesTotal = itemBytes;
+}
+
+void OperationContext::EndItem()
+{
+    itemsDone.fetch_add(1, std::memory_order_relaxed);
+}
+
+void OperationContext::AddBytes(UINT64 bytes)
+{
+    itemBytesDone.fetch_add(bytes, std::memory_order_relaxed);
+    bytesDone.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+UINT64 OperationContext::BytesDone()
+{
+    return bytesDone.load(std::memory_order_relaxed);
+}
+
+UINT64 OperationContext::BytesTotal()
+{
+    return bytesTotal.load(std::memory_order_relaxed);
+}
+
+UINT64 OperationContext::ItemsDone()
+{
+    return itemsDone.load(std::memory_order_relaxed);
+}
+
+UINT64 OperationContext::ItemsTotal()
+{
+    return itemsTotal.load(std::memory_order_relaxed);
+}
+
+UINT64 OperationContext::ItemBytesDone()
+{
+    return itemBytesDone.load(std::memory_order_relaxed);
+}
+
+UINT64 OperationContext::ItemBytesTotal()
+{
+    return itemBytesTotal.load(std::memory_order_relaxed);
+}
+
+void OperationContext::Cancel()
+{
+    cancelled = true;
+}
+
+bool OperationContext::IsCancelled()
+{
+    return cancelled.load(std::memory_order_relaxed);
+}
+
+void OperationContext::ThrowIfCancelled()
+{
+    if (IsCancelled())
+        throw std::string("OperationContext: The operation was cancelled.\n");
+}
+
+void OperationContext::Reset()
+{
+    bytesDone = 0;
+    bytesTotal = 0;
+    itemsDone = 0;
+    itemsTotal = 0;
+    itemBytesDone = 0;
+    itemBytesTotal = 0;
+    cancelled = false;
+}
@@ -0,0 +1,211 @@
+#include <XboxInternals/IO/Readahead.h>
+
+#include <algorithm>
+#include <string>
+#include <string.h>
+#include <utility>
+
+Readahead::Readahead(std::function<DWORD(UINT64, BYTE*, DWORD)> readFunction, DWORD segmentSize,
+        DWORD segmentCount, DWORD alignment) :
+    readFunction(std::move(readFunction)), segmentSize(segmentSize), segmentCount(segmentCount),
+    alignment(alignment), head(0), windowStart(0), streaming(false), exhausted(false), lastEnd(0),
+    sequentialReads(0), quit(false)
+{
+    if (segmentSize == 0 || segmentCount == 0 || alignment == 0 || segmentSize % alignment != 0)
+        throw std::string("Readahead: Invalid ring geometry.\n");
+}
+
+Readahead::~Readahead()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    changed.notify_all();
+
+    if (helper.joinable())
+        helper.join();
+}
+
+bool Readahead::Read(UINT64 offset, BYTE *outBuffer, DWORD len)
+{
+    if (len < READAHEAD_MIN_READ_SIZE)
+        return false;
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    bool sequential = (offset == lastEnd);
+    lastEnd = offset + len;
+
+    if (streaming)
+    {
+        if (offset >= windowStart && offset + len <= windowStart + (UINT64)segmentCount * segmentSize &&
+                copyFromWindow(offset, outBuffer, len, lock))
+        {
+            // hand back every segment the reader has moved past so the helper can fill it further ahead
+            while (windowStart + segmentSize <= offset + len)
+            {
+                Segment &passed = segments[head];
+                waitForFill(passed, lock);
+                passed.state = SegmentEmpty;
+
+                head = (head + 1) % segmentCount;
+                windowStart += segmentSize;
+            }
+            changed.notify_all();
+            return true;
+        }
+
+        // the reader left the window, or the data wasn't there
+        stopStream(lock);
+        sequentialReads = 0;
+        return false;
+    }
+
+    sequentialReads = sequential ? sequentialReads + 1 : 0;
+    if (sequentialReads + 1 >= READAHEAD_TRIGGER_COUNT)
+        startStream(offset + len);
+
+    return false;
+}
+
+void Readahead::Invalidate(UINT64 offset, UINT64 len)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!streaming)
+        return;
+
+    // once the end of the data was hit, a Write anywhere could be growing it
+    UINT64 windowEnd = windowStart + (UINT64)segmentCount * segmentSize;
+    if (exhausted || (offset < windowEnd && offset + len > windowStart))
+        stopStream(lock);
+}
+
+void Readahead::Reset()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (streaming)
+        stopStream(lock);
+
+    sequentialReads = 0;
+    lastEnd = 0;
+}
+
+bool Readahead::IsStreaming()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return streaming;
+}
+
+void Readahead::startStream(UINT64 offset)
+{
+    // the buffers are only allocated once something actually streams
+    if (segments.empty())
+    {
+        segments.resize(segmentCount);
+        for (Segment &segment : segments)
+            segment.data.resize(segmentSize);
+    }
+
+    head = 0;
+    windowStart = offset - (offset % alignment);
+    streaming = true;
+    exhausted = false;
+
+    if (!helper.joinable())
+        helper = std::thread(&Readahead::helperLoop, this);
+    changed.notify_all();
+}
+
+void Readahead::stopStream(std::unique_lock<std::mutex> &lock)
+{
+    streaming = false;
+    for (Segment &segment : segments)
+    {
+        waitForFill(segment, lock);
+        segment.state = SegmentEmpty;
+    }
+    exhausted = false;
+}
+
+bool Readahead::copyFromWindow(UINT64 offset, BYTE *outBuffer, DWORD len, std::unique_lock<std::mutex> &lock)
+{
+    while (len > 0)
+    {
+        UINT64 index = (offset - windowStart) / segmentSize;
+        UINT64 segmentStart = windowStart + index * segmentSize;
+        Segment &segment = segments[(head + index) % segmentCount];
+
+        // wait for the helper to get to it, unless it's never going to
+        changed.wait(lock, [&]()
+        {
+            return !streaming || segment.state == SegmentReady || segment.state == SegmentFailed ||
+                    (segment.state == SegmentEmpty && exhausted);
+        });
+
+        DWORD offsetInSegment = (DWORD)(offset - segmentStart);
+        if (!streaming || segment.state != SegmentReady || offsetInSegment >= segment.validLength)
+            return false;
+
+        DWORD bytesToCopy = std::min(len, segment.validLength - offsetInSegment);
+        memcpy(outBuffer, segment.data.data() + offsetInSegment, bytesToCopy);
+
+        offset += bytesToCopy;
+        outBuffer += bytesToCopy;
+        len -= bytesToCopy;
+    }
+
+    return true;
+}
+
+void Readahead::waitForFill(Segment &segment, std::unique_lock<std::mutex> &lock)
+{
+    changed.wait(lock, [&]() { return segment.state != SegmentFilling; });
+}
+
+void Readahead::helperLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // the empty segments are always the tail of the window, so the first one found is the next to fill
+    auto nextEmpty = [this]()
+    {
+        for (DWORD i = 0; i < segments.size(); i++)
+            if (segments[(head + i) % segmentCount].state == SegmentEmpty)
+                return (int)i;
+        return -1;
+    };
+
+    while (true)
+    {
+        changed.wait(lock, [&]() { return quit || (streaming && !exhausted && nextEmpty() != -1); });
+        if (quit)
+            return;
+
+        DWORD index = (DWORD)nextEmpty();
+        Segment &segment = segments[(head + index) % segmentCount];
+        UINT64 offset = windowStart + (UINT64)index * segmentSize;
+        segment.state = SegmentFilling;
+
+        // a segment that's filling is left alone by the reader, so the read can happen without the lock
+        lock.unlock();
+        DWORD bytesRead = 0;
+        bool failed = false;
+        try
+        {
+            bytesRead = readFunction(offset, segment.data.data(), segmentSize);
+        }
+        catch (...)
+        {
+            failed = true;
+        }
+        lock.lock();
+
+        segment.state = failed ? SegmentFailed : SegmentReady;
+        segment.validLength = failed ? 0 : bytesRead;
+        if (failed || bytesRead < segmentSize)
+            exhausted = true;
+
+        changed.notify_all();
+    }
+}
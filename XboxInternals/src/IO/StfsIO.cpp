@@ -115,6 +115,68 @@ void StfsIO::WriteBytes(BYTE *buffer, DWORD len)
     SetPosition(endingPosition);
 }
 
+void StfsIO::ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len)
+{
+    if (offset + len > Length())
+        throw std::string("StfsIO: Cannot read beyond the end of the file.\n");
+
+    while (len > 0)
+    {
+        UINT64 packageAddress;
+        DWORD bytesToRead = getContiguousRun(offset, len, &packageAddress);
+
+        io->ReadAt(packageAddress, outBuffer, bytesToRead);
+
+        offset += bytesToRead;
+        outBuffer += bytesToRead;
+        len -= bytesToRead;
+    }
+}
+
+void StfsIO::WriteAt(UINT64 offset, BYTE *buffer, DWORD len)
+{
+    // growing the file needs blocks allocated, which the stateful path handles
+    if (offset + len > Length())
+    {
+        BaseIO::WriteAt(offset, buffer, len);
+        return;
+    }
+
+    while (len > 0)
+    {
+        UINT64 packageAddress;
+        DWORD bytesToWrite = getContiguousRun(offset, len, &packageAddress);
+
+        io->WriteAt(packageAddress, buffer, bytesToWrite);
+
+        offset += bytesToWrite;
+        buffer += bytesToWrite;
+        len -= bytesToWrite;
+    }
+}
+
+DWORD StfsIO::getContiguousRun(UINT64 offset, DWORD len, UINT64 *packageAddress)
+{
+    size_t blockIndex = offset / 0x1000;
+    *packageAddress = this->package->BlockToAddress(entry.blockChain.at(blockIndex)) + (offset % 0x1000);
+
+    // blocks that are next to each other in the package can be read together, unless a hash table is between them
+    UINT64 runLength = 0x1000 - (offset % 0x1000);
+    UINT64 blockAddress = *packageAddress - (offset % 0x1000);
+    while (runLength < len && blockIndex + 1 < entry.blockChain.size())
+    {
+        UINT64 nextBlockAddress = this->package->BlockToAddress(entry.blockChain.at(blockIndex + 1));
+        if (nextBlockAddress != blockAddress + 0x1000)
+            break;
+
+        runLength += 0x1000;
+        blockAddress = nextBlockAddress;
+        blockIndex++;
+    }
+
+    return (runLength < len) ? (DWORD)runLength : len;
+}
+
 void StfsIO::Flush()
 {
     if (didChangeSize)
@@ -1,6 +1,8 @@
 #include <XboxInternals/IO/SvodIO.h>
 #include <XboxInternals/IO/FileIO.h>
 
+#include <stdio.h>
+
 SvodIO::SvodIO(XContentHeader *metadata, GdfxFileEntry entry, IndexableMultiFileIO *io) :
     BaseIO(), io(io), metadata(metadata), fileEntry(entry), pos(0)
 {
@@ -36,6 +38,16 @@ void SvodIO::SetPosition(UINT64 address, ios_base::seekdir dir)
     if (dir != std::ios_base::beg)
         throw std::string("SvodIO: Unsupported seek direction\n");
 
+    DWORD addr, index;
+    FileOffsetToAddress(address, &addr, &index);
+
+    // seek to the position
+    io->SetPosition(addr, static_cast<int>(index));
+    pos = address;
+}
+
+void SvodIO::FileOffsetToAddress(UINT64 address, DWORD *addressInDataFile, DWORD *dataFileIndex)
+{
     /* DISCLAIMER: This function is not perfect and will not work for all SVOD systems. If the
        system has more than 204 (0xCC) data files, then this function may not work. */
 
@@ -59,9 +71,19 @@ void SvodIO::SetPosition(UINT64 address, ios_base::seekdir dir)
         addr = (addr % 0xA290000) + 0x2000;
     }
 
-    // seek to the position
-    io->SetPosition(addr, static_cast<int>(index));
-    pos = address;
+    *addressInDataFile = addr;
+    *dataFileIndex = index;
+}
+
+DWORD SvodIO::BytesUntilHashTable(DWORD addressInDataFile, DWORD len)
+{
+    // calculate the amount of bytes until the next hash table, or the end of the data file
+    DWORD bytesUntilTable = 0xCC000 - ((addressInDataFile - 0x2000) % 0xCD000);
+    DWORD bytesUntilEnd = 0xA290000 - addressInDataFile;
+    if (bytesUntilEnd < bytesUntilTable)
+        bytesUntilTable = bytesUntilEnd;
+
+    return (bytesUntilTable > len) ? len : bytesUntilTable;
 }
 
 UINT64 SvodIO::GetPosition()
@@ -76,104 +98,60 @@ UINT64 SvodIO::Length()
 
 void SvodIO::ReadBytes(BYTE *outBuffer, DWORD len)
 {
-    // all the SvodIOs are using the same IO underneath, so we have to make sure we're at the correct pos
-    SetPosition(pos);
+    // all the SvodIOs are using the same IO underneath, so read positionally rather than re-seeking it
+    ReadAt(pos, outBuffer, len);
     pos += len;
-
-    // get the current position
-    DWORD addr, index;
-    io->GetPosition(&addr, &index);
-
-    // calculate the amount of bytes until the next hash table
-    DWORD bytesUntilTable = 0xCC000 - ((addr - 0x2000) % 0xCD000);
-
-    // calculate the amount of bytes to read
-    DWORD bytesToRead = (bytesUntilTable > len) ? len : bytesUntilTable;
-
-    // read the bytes before the table
-    io->ReadBytes(outBuffer, bytesToRead);
-    outBuffer += bytesToRead;
-    len -= bytesToRead;
-
-    // read in between all the hash tables
-    while (len >= 0xCC000)
-    {
-        // check to see if we're at the end of a data file
-        io->GetPosition(&addr, &index);
-        if (addr == 0)
-            io->SetPosition((DWORD)0x2000, static_cast<int>(index));
-        else
-            io->SetPosition((DWORD)addr + 0x1000);
-
-        io->ReadBytes(outBuffer, 0xCC000);
-        outBuffer += 0xCC000;
-        len -= 0xCC000;
-    }
-
-    if (len != 0)
-    {
-        // check to see if we're at the end of a data file
-        io->GetPosition(&addr, &index);
-        if (addr == 0)
-            io->SetPosition((DWORD)0x2000, static_cast<int>(index));
-        else
-            io->SetPosition((DWORD)(addr + 0x1000));
-
-        io->ReadBytes(outBuffer, len);
-    }
 }
 
 void SvodIO::WriteBytes(BYTE *buffer, DWORD len)
 {
-    // all the SvodIOs are using the same IO underneath, so we have to make sure we're at the correct pos
-    SetPosition(pos);
+    WriteAt(pos, buffer, len);
     pos += len;
+}
 
-    // get the current position
-    DWORD addr, index;
-    io->GetPosition(&addr, &index);
-
-    // calculate the amount of bytes until the next hash table
-    DWORD bytesUntilTable = 0xCC000 - ((addr - 0x2000) % 0xCD000);
+void SvodIO::ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len)
+{
+    // read in between all the hash tables
+    while (len > 0)
+    {
+        DWORD addr, index;
+        FileOffsetToAddress(offset, &addr, &index);
 
-    // calculate the amount of bytes to read
-    DWORD bytesToWrite = (bytesUntilTable > len) ? len : bytesUntilTable;
+        DWORD bytesToRead = BytesUntilHashTable(addr, len);
+        io->ReadAt(addr, index, outBuffer, bytesToRead);
 
-    // Write the bytes before the table
-    io->WriteBytes(buffer, bytesToWrite);
-    buffer += bytesToWrite;
-    len -= bytesToWrite;
+        offset += bytesToRead;
+        outBuffer += bytesToRead;
+        len -= bytesToRead;
+    }
+}
 
+void SvodIO::WriteAt(UINT64 offset, BYTE *buffer, DWORD len)
+{
     // Write in between all the hash tables
-    while (len >= 0xCC000)
+    while (len > 0)
     {
-        // check to see if we're at the end of a data file
-        io->GetPosition(&addr, &index);
-        if (addr == 0xA290000)
-            io->SetPosition((DWORD)0, static_cast<int>(index + 1));
-        else
-            io->SetPosition(addr + 0x1000);
-
-        io->WriteBytes(buffer, 0xCC000);
-        buffer += 0xCC000;
-        len -= 0xCC000;
-    }
+        DWORD addr, index;
+        FileOffsetToAddress(offset, &addr, &index);
 
-    if (len != 0)
-    {
-        // check to see if we're at the end of a data file
-        io->GetPosition(&addr, &index);
-        if (addr == 0xA290000)
-            io->SetPosition((DWORD)0, static_cast<int>(index + 1));
-        else
-            io->SetPosition((DWORD)(addr + 0x1000));
-
-        io->WriteBytes(buffer, len);
+        DWORD bytesToWrite = BytesUntilHashTable(addr, len);
+        io->WriteAt(addr, index, buffer, bytesToWrite);
+
+        offset += bytesToWrite;
+        buffer += bytesToWrite;
+        len -= bytesToWrite;
     }
 }
 
-void SvodIO::SaveFile(string savePath, void(*progress)(void*, DWORD, DWORD), void *arg)
+void SvodIO::SaveFile(string savePath, void(*progress)(void*, DWORD, DWORD), void *arg,
+        OperationContext *context)
 {
+    if (context)
+    {
+        context->ThrowIfCancelled();
+        context->BeginItem(fileEntry.size);
+    }
+
     FileIO outFile(savePath, true);
     std::vector<BYTE> buffer(0x10000);
     DWORD fileLen = fileEntry.size;
@@ -182,24 +160,39 @@ void SvodIO::SaveFile(string savePath, void(*progress)(void*, DWORD, DWORD), voi
 
     while (fileLen >= 0x10000)
     {
+        // don't leave half a file behind when it's cancelled
+        if (context && context->IsCancelled())
+        {
+            outFile.Close();
+            remove(savePath.c_str());
+            context->ThrowIfCancelled();
+        }
+
         ReadBytes(buffer.data(), 0x10000);
         outFile.Write(buffer.data(), 0x10000);
         fileLen -= 0x10000;
 
         if (progress)
             progress(arg, cur++, total);
+        if (context)
+            context->AddBytes(0x10000);
     }
 
     if (fileLen != 0)
     {
         ReadBytes(buffer.data(), fileLen);
         outFile.Write(buffer.data(), fileLen);
+        if (context)
+            context->AddBytes(fileLen);
     }
 
     if (progress)
         progress(arg, total, total);
 
     outFile.Close();
+
+    if (context)
+        context->EndItem();
 }
 
 void SvodIO::OverWriteFile(string inPath, void (*progress)(void *, DWORD, DWORD), void *arg)
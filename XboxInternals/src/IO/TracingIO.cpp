@@ -0,0 +1,310 @@
+#include <XboxInternals/IO/TracingIO.h>
+
+#include <atomic>
+#include <chrono>
+#include <ctype.h>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdlib.h>
+#include <utility>
+
+namespace
+{
+
+// label for io calls made outside of any operation
+const char *const defaultOperation = "unlabelled";
+
+thread_local const char *currentOperation = defaultOperation;
+
+// get the value of the environment variable, or an empty string if it isn't set
+std::string traceDestination()
+{
+    static const std::string destination = []()
+    {
+        const char *value = getenv(TRACINGIO_ENVIRONMENT_VARIABLE);
+        return std::string(value ? value : "");
+    }();
+    return destination;
+}
+
+std::string escapeJson(const std::string &str)
+{
+    std::string escaped;
+    for (char c : str)
+    {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+
+        if ((unsigned char)c < 0x20)
+            escaped += ' ';
+        else
+            escaped += c;
+    }
+    return escaped;
+}
+
+// times a single call, from construction until Stop is called
+class CallTimer
+{
+public:
+    CallTimer() : start(std::chrono::steady_clock::now())
+    {
+    }
+
+    UINT64 Stop()
+    {
+        return (UINT64)std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+}
+
+TracingIO::Operation::Operation(const char *label) : previousLabel(currentOperation)
+{
+    currentOperation = label;
+}
+
+TracingIO::Operation::~Operation()
+{
+    currentOperation = previousLabel;
+}
+
+const char *TracingIO::Operation::Current()
+{
+    return currentOperation;
+}
+
+void TracingIO::Histogram::Add(UINT64 microseconds)
+{
+    // bucket n holds calls that took less than 2^n microseconds
+    int bucket = 0;
+    while (bucket < TRACINGIO_LATENCY_BUCKETS - 1 && microseconds >= (1ULL << bucket))
+        bucket++;
+
+    buckets[bucket]++;
+}
+
+TracingIO::TracingIO(BaseIO *io, std::string name) :
+    BaseIO(), io(io), name(std::move(name)), dumped(false)
+{
+    if (io == nullptr)
+        throw std::string("TracingIO: Cannot trace a null io.\n");
+
+    byteOrder = io->GetEndian();
+}
+
+TracingIO::TracingIO(std::unique_ptr<BaseIO> io, std::string name) : TracingIO(io.get(), std::move(name))
+{
+    ownedIO = std::move(io);
+}
+
+TracingIO::~TracingIO()
+{
+    dump();
+}
+
+bool TracingIO::Enabled()
+{
+    return !traceDestination().empty();
+}
+
+BaseIO *TracingIO::Inner()
+{
+    return io;
+}
+
+TracingIO::OperationStats &TracingIO::currentStats()
+{
+    return stats[currentOperation];
+}
+
+void TracingIO::SetPosition(UINT64 position, std::ios_base::seekdir dir)
+{
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        currentStats().seeks++;
+    }
+    io->SetPosition(position, dir);
+}
+
+UINT64 TracingIO::GetPosition()
+{
+    return io->GetPosition();
+}
+
+UINT64 TracingIO::Length()
+{
+    return io->Length();
+}
+
+void TracingIO::ReadBytes(BYTE *outBuffer, DWORD len)
+{
+    CallTimer timer;
+    io->ReadBytes(outBuffer, len);
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    OperationStats &op = currentStats();
+    op.reads++;
+    op.bytesRead += len;
+    op.readLatency.Add(timer.Stop());
+}
+
+void TracingIO::WriteBytes(BYTE *buffer, DWORD len)
+{
+    CallTimer timer;
+    io->WriteBytes(buffer, len);
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    OperationStats &op = currentStats();
+    op.writes++;
+    op.bytesWritten += len;
+    op.writeLatency.Add(timer.Stop());
+}
+
+void TracingIO::ReadAt(UINT64 offset, BYTE *outBuffer, DWORD len)
+{
+    CallTimer timer;
+    io->ReadAt(offset, outBuffer, len);
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    OperationStats &op = currentStats();
+    op.reads++;
+    op.bytesRead += len;
+    op.readLatency.Add(timer.Stop());
+}
+
+void TracingIO::WriteAt(UINT64 offset, BYTE *buffer, DWORD len)
+{
+    CallTimer timer;
+    io->WriteAt(offset, buffer, len);
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    OperationStats &op = currentStats();
+    op.writes++;
+    op.bytesWritten += len;
+    op.writeLatency.Add(timer.Stop());
+}
+
+ReadCompletion TracingIO::SubmitReads(std::vector<ReadRequest> requests)
+{
+    // the batch finishes on its own time, so only what was asked for is counted
+    std::lock_guard<std::mutex> lock(statsMutex);
+    OperationStats &op = currentStats();
+    for (const ReadRequest &request : requests)
+    {
+        op.reads++;
+        op.bytesRead += request.length;
+    }
+
+    return io->SubmitReads(std::move(requests));
+}
+
+void TracingIO::Flush()
+{
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        currentStats().flushes++;
+    }
+    io->Flush();
+}
+
+void TracingIO::Close()
+{
+    dump();
+    io->Close();
+}
+
+std::string TracingIO::ToJson()
+{
+    auto writeHistogram = [](std::stringstream &json, const Histogram &histogram)
+    {
+        json << "[";
+        bool first = true;
+        for (int i = 0; i < TRACINGIO_LATENCY_BUCKETS; i++)
+        {
+            if (histogram.buckets[i] == 0)
+                continue;
+
+            if (!first)
+                json << ", ";
+            first = false;
+
+            json << "{ \"underMicroseconds\": ";
+            if (i == TRACINGIO_LATENCY_BUCKETS - 1)
+                json << "null";
+            else
+                json << (1ULL << i);
+            json << ", \"count\": " << histogram.buckets[i] << " }";
+        }
+        json << "]";
+    };
+
+    std::stringstream json;
+    json << "{\n  \"name\": \"" << escapeJson(name) << "\",\n  \"operations\": {";
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    bool first = true;
+    for (const auto &operation : stats)
+    {
+        const OperationStats &op = operation.second;
+
+        json << (first ? "\n" : ",\n");
+        first = false;
+
+        json << "    \"" << escapeJson(operation.first) << "\": {\n";
+        json << "      \"seeks\": " << op.seeks << ",\n";
+        json << "      \"reads\": " << op.reads << ",\n";
+        json << "      \"bytesRead\": " << op.bytesRead << ",\n";
+        json << "      \"writes\": " << op.writes << ",\n";
+        json << "      \"bytesWritten\": " << op.bytesWritten << ",\n";
+        json << "      \"flushes\": " << op.flushes << ",\n";
+        json << "      \"readLatency\": ";
+        writeHistogram(json, op.readLatency);
+        json << ",\n      \"writeLatency\": ";
+        writeHistogram(json, op.writeLatency);
+        json << "\n    }";
+    }
+
+    json << "\n  }\n}\n";
+    return json.str();
+}
+
+void TracingIO::dump()
+{
+    if (dumped)
+        return;
+    dumped = true;
+
+    std::string destination = traceDestination();
+    if (destination.empty())
+        return;
+
+    std::string json = ToJson();
+    if (destination == "stderr")
+    {
+        std::cerr << json;
+        return;
+    }
+
+    // one file per traced io, named after it so several dumps from one run can be told apart
+    static std::atomic<unsigned> dumpCount(0);
+    std::string fileName;
+    for (char c : name)
+        fileName += isalnum((unsigned char)c) ? c : '_';
+
+    std::stringstream suffix;
+    suffix << "-" << std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count() << "-" << dumpCount++ << ".json";
+
+    std::error_code error;
+    std::filesystem::create_directories(destination, error);
+
+    std::ofstream out(std::filesystem::path(destination) / (fileName + suffix.str()));
+    out << json;
+}
@@ -2,6 +2,7 @@
 #include <XboxInternals/Xex/Xex.h>
 
 #include <cstring>
+#include <vector>
 
 
 XexAesIO::XexAesIO(BaseIO *io, Xex *xex, const BYTE *key) :
@@ -46,28 +47,33 @@ void XexAesIO::ReadBytes(BYTE *outBuffer, DWORD readLength)
         bytesLeft -= bytesToRead;
     }
 
-    // as long as there are bytes left to read, read them in
+    // read all the encrypted blocks that are left in one go, so long reads reach the io as one sequential read
     BYTE encryptedBuffer[XEX_AES_BLOCK_SIZE];
-    while (bytesLeft != 0)
+    if (bytesLeft != 0)
     {
-        // seek to the beginning of the next AES block to read
+        DWORD blockCount = (bytesLeft + XEX_AES_BLOCK_SIZE - 1) / XEX_AES_BLOCK_SIZE;
+        std::vector<BYTE> encryptedBlocks(blockCount * XEX_AES_BLOCK_SIZE);
+
         UINT64 nextAesBlockAddress = xex->header.dataAddress + curAesBlockAddress + XEX_AES_BLOCK_SIZE;
         xex->io->SetPosition(nextAesBlockAddress);
+        xex->io->ReadBytes(encryptedBlocks.data(), (DWORD)encryptedBlocks.size());
 
-        xex->io->ReadBytes(encryptedBuffer, XEX_AES_BLOCK_SIZE);
-        AesCbcDecrypt(encryptedBuffer);
-        curAesBlockAddress += XEX_AES_BLOCK_SIZE;
+        for (DWORD i = 0; i < blockCount; i++)
+        {
+            AesCbcDecrypt(encryptedBlocks.data() + i * XEX_AES_BLOCK_SIZE);
+            curAesBlockAddress += XEX_AES_BLOCK_SIZE;
 
-        // calculate the amount of bytes to copy over
-        DWORD bytesToCopy = XEX_AES_BLOCK_SIZE;
-        if (bytesLeft < XEX_AES_BLOCK_SIZE)
-            bytesToCopy = bytesLeft;
+            // calculate the amount of bytes to copy over
+            DWORD bytesToCopy = XEX_AES_BLOCK_SIZE;
+            if (bytesLeft < XEX_AES_BLOCK_SIZE)
+                bytesToCopy = bytesLeft;
 
-        memcpy(outBuffer + bytesRead, curDecryptedBlock, bytesToCopy);
+            memcpy(outBuffer + bytesRead, curDecryptedBlock, bytesToCopy);
 
-        bytesRead += bytesToCopy;
-        position += bytesToCopy;
-        bytesLeft -= bytesToCopy;
+            bytesRead += bytesToCopy;
+            position += bytesToCopy;
+            bytesLeft -= bytesToCopy;
+        }
     }
 
     // check if we need to decrypt the next block, make sure we're not at the end of the file
@@ -1,6 +1,11 @@
 #include <XboxInternals/Stfs/StfsPackage.h>
 #include <XboxInternals/Stfs/XContentHeader.h>
 #include <XboxInternals/IO/StfsIO.h>
+#include <XboxInternals/IO/MappedFileIO.h>
+#include <XboxInternals/IO/MemoryIO.h>
+#include <XboxInternals/IO/BufferedIO.h>
+#include <XboxInternals/IO/CopyPipeline.h>
+#include <XboxInternals/IO/TracingIO.h>
 
 #include <stdio.h>
 #include <memory>
@@ -14,7 +19,7 @@ constexpr DWORD dataBlocksPerHashTreeLevel[3] = {1, 0xAA, 0x70E4};
 }
 
 StfsPackage::StfsPackage(BaseIO* io, DWORD flags) :
-    io(io), flags(flags)
+    io(io), mappedIO(nullptr), flags(flags)
 {
     if ((flags & StfsPackageDeleteIO) && io != nullptr)
     {
@@ -34,9 +39,12 @@ StfsPackage::StfsPackage(BaseIO* io, DWORD flags) :
 }
 
 StfsPackage::StfsPackage(string packagePath, DWORD flags) :
-    io(nullptr), flags(flags)
+    io(nullptr), mappedIO(nullptr), flags(flags)
 {
-    ownedIO = std::make_unique<FileIO>(packagePath, (bool)(flags & StfsPackageCreate));
+    if ((flags & StfsPackageMapFile) && !(flags & StfsPackageCreate))
+        ownedIO = std::make_unique<MappedFileIO>(packagePath);
+    else
+        ownedIO = std::make_unique<FileIO>(packagePath, (bool)(flags & StfsPackageCreate));
     io = ownedIO.get();
     try
     {
@@ -52,6 +60,24 @@ StfsPackage::StfsPackage(string packagePath, DWORD flags) :
 
 void StfsPackage::Init()
 {
+    mappedIO = dynamic_cast<MappedFileIO*>(io);
+
+    // see what the package is being asked for when tracing is turned on, beneath the write buffering
+    if (TracingIO::Enabled())
+    {
+        FileIO *file = dynamic_cast<FileIO*>(io);
+        tracingIO = std::make_unique<TracingIO>(io, file ? file->GetFilePath() : "StfsPackage");
+        io = tracingIO.get();
+    }
+    TracingIO::Operation trace("StfsPackage::Open");
+
+    // gather the field sized writes made while modifying the package, a mapped file doesn't need it
+    if (!mappedIO)
+    {
+        bufferedIO = std::make_unique<BufferedIO>(io);
+        io = bufferedIO.get();
+    }
+
     if (flags & StfsPackageCreate)
     {
         DWORD headerSize = (flags & StfsPackagePEC) ? ((flags & StfsPackageFemale) ? 0x2000 : 0x1000) : ((
@@ -76,12 +102,16 @@ void StfsPackage::Cleanup()
         io->Close();
     }
 
+    bufferedIO.reset();
+    tracingIO.reset();
+
     if (ownedIO)
     {
         ownedIO.reset();
     }
 
     io = nullptr;
+    mappedIO = nullptr;
 
     if (metaData)
     {
@@ -211,12 +241,7 @@ void StfsPackage::Parse()
         (metaData->stfsVolumeDescriptor.allocatedBlockCount % 0xAA != 0))
         topTable.entryCount++;
 
-    for (DWORD i = 0; i < topTable.entryCount; i++)
-    {
-        io->ReadBytes(topTable.entries[i].blockHash, 0x14);
-        topTable.entries[i].status = io->ReadByte();
-        topTable.entries[i].nextBlock = io->ReadInt24();
-    }
+    ReadHashEntries(topTable.entries, topTable.entryCount);
 
     // set default values for the root of the file listing
     StfsFileEntry fe;
@@ -329,28 +354,59 @@ DWORD StfsPackage::GetHashAddressOfBlock(DWORD blockNum)
         DWORD level1Off = ((topTable.entries[blockNum / 0x70E4].status & 0x40) << 6);
         DWORD pos = ((ComputeLevel1BackingHashBlockNumber(blockNum) << 0xC) + firstHashTableAddress +
             level1Off) + ((blockNum % 0xAA) * 0x18);
-        io->SetPosition(pos + 0x14);
-        hashAddr += ((io->ReadByte() & 0x40) << 6);
+        BYTE status;
+        hashAddr += ((*ViewBytes(pos + 0x14, 1, &status) & 0x40) << 6);
         break;
     }
     return hashAddr;
 }
 
+void StfsPackage::ReadHashEntries(HashEntry *entries, DWORD count)
+{
+    if (count > 0xAA)
+        throw string("STFS: Invalid hash table entry count.\n");
+
+    // read the whole table in one go and decode it from memory
+    BYTE copy[0xAA * 0x18];
+    UINT64 address = io->GetPosition();
+    const BYTE *table = ViewBytes(address, count * 0x18, copy);
+    io->SetPosition(address + count * 0x18);
+
+    for (DWORD i = 0; i < count; i++)
+    {
+        const BYTE *rawEntry = table + (i * 0x18);
+        memcpy(entries[i].blockHash, rawEntry, 0x14);
+        entries[i].status = rawEntry[0x14];
+        entries[i].nextBlock = (rawEntry[0x15] << 16) | (rawEntry[0x16] << 8) | rawEntry[0x17];
+    }
+}
+
 HashEntry StfsPackage::GetBlockHashEntry(DWORD blockNum)
 {
     if (blockNum >= metaData->stfsVolumeDescriptor.allocatedBlockCount)
         throw string("STFS: Reference to illegal block number.\n");
 
-    io->SetPosition(GetHashAddressOfBlock(blockNum));
+    // read the whole entry in one go, the next block is a big endian INT24 at the end
+    BYTE copy[0x18];
+    const BYTE *rawEntry = ViewBytes(GetHashAddressOfBlock(blockNum), 0x18, copy);
 
     HashEntry he;
-    io->ReadBytes(he.blockHash, 0x14);
-    he.status = io->ReadByte();
-    he.nextBlock = io->ReadInt24();
+    memcpy(he.blockHash, rawEntry, 0x14);
+    he.status = rawEntry[0x14];
+    he.nextBlock = (rawEntry[0x15] << 16) | (rawEntry[0x16] << 8) | rawEntry[0x17];
 
     return he;
 }
 
+const BYTE *StfsPackage::ViewBytes(UINT64 address, DWORD len, BYTE *copy)
+{
+    if (mappedIO)
+        return mappedIO->View(address, len).data();
+
+    io->ReadAt(address, copy, len);
+    return copy;
+}
+
 void StfsPackage::ExtractBlock(DWORD blockNum, BYTE* data, DWORD length)
 {
     if (blockNum >= metaData->stfsVolumeDescriptor.allocatedBlockCount)
@@ -382,7 +438,10 @@ void StfsPackage::ReadFileListing()
     for (DWORD x = 0; x < metaData->stfsVolumeDescriptor.fileTableBlockCount; x++)
     {
         currentAddr = BlockToAddress(block);
-        io->SetPosition(currentAddr);
+
+        // parse the block's entries from memory, straight out of the mapping when there is one
+        BYTE copy[0x1000];
+        MemoryIO blockIO(const_cast<BYTE*>(ViewBytes(currentAddr, 0x1000, copy)), 0x1000);
 
         for (DWORD i = 0; i < 0x40; i++)
         {
@@ -395,28 +454,28 @@ void StfsPackage::ReadFileListing()
             fe.entryIndex = (x * 0x40) + i;
 
             // read the name, if the length is 0 then break
-            fe.name = io->ReadString(0x28);
+            fe.name = blockIO.ReadString(0x28);
 
             // read the name length
-            fe.nameLen = io->ReadByte();
+            fe.nameLen = blockIO.ReadByte();
             if ((fe.nameLen & 0x3F) == 0)
             {
-                io->SetPosition(currentAddr + ((i + 1) * 0x40));
+                blockIO.SetPosition((i + 1) * 0x40);
                 continue;
             }
             else if (fe.name.length() == 0)
                 break;
 
             // check for a mismatch in the total allocated blocks for the file
-            fe.blocksForFile = io->ReadInt24(LittleEndian);
-            io->SetPosition(3, ios_base::cur);
+            fe.blocksForFile = blockIO.ReadInt24(LittleEndian);
+            blockIO.SetPosition(3, ios_base::cur);
 
             // read more information
-            fe.startingBlockNum = io->ReadInt24(LittleEndian);
-            fe.pathIndicator = io->ReadWord();
-            fe.fileSize = io->ReadDword();
-            fe.createdTimeStamp = io->ReadDword();
-            fe.accessTimeStamp = io->ReadDword();
+            fe.startingBlockNum = blockIO.ReadInt24(LittleEndian);
+            fe.pathIndicator = blockIO.ReadWord();
+            fe.fileSize = blockIO.ReadDword();
+            fe.createdTimeStamp = blockIO.ReadDword();
+            fe.accessTimeStamp = blockIO.ReadDword();
 
             // get the flags
             fe.flags = fe.nameLen >> 6;
@@ -464,18 +523,20 @@ DWORD StfsPackage::GetFileMagic(StfsFileEntry entry)
 }
 
 void StfsPackage::ExtractFile(string pathInPackage, string outPath, void (*extractProgress)(void*,
-    DWORD, DWORD), void* arg)
+    DWORD, DWORD), void* arg, OperationContext *context)
 {
     // get the given path's file entry
     StfsFileEntry entry = GetFileEntry(pathInPackage);
 
     // extract the file
-    ExtractFile(&entry, outPath, extractProgress, arg);
+    ExtractFile(&entry, outPath, extractProgress, arg, context);
 }
 
 void StfsPackage::ExtractFile(StfsFileEntry* entry, string outPath, void (*extractProgress)(void*,
-    DWORD, DWORD), void* arg)
+    DWORD, DWORD), void* arg, OperationContext *context)
 {
+    TracingIO::Operation trace("StfsPackage::ExtractFile");
+
     if (!entry)
         throw std::string("STFS: NULL file entry pointer");
     
@@ -496,6 +557,12 @@ void StfsPackage::ExtractFile(StfsFileEntry* entry, string outPath, void (*extra
         throw;
     }
 
+    if (context)
+    {
+        context->ThrowIfCancelled();
+        context->BeginItem(entry->fileSize);
+    }
+
     // create/truncate our out file
     FileIO outFile(outPath, true);
 
@@ -510,6 +577,8 @@ void StfsPackage::ExtractFile(StfsFileEntry* entry, string outPath, void (*extra
         // update progress if needed
         if (extractProgress != NULL)
             extractProgress(arg, 1, 1);
+        if (context)
+            context->EndItem();
 
         return;
     }
@@ -549,14 +618,28 @@ void StfsPackage::ExtractFile(StfsFileEntry* entry, string outPath, void (*extra
             useOptimizedPath = false;
     }
 
+    // the package is read and the file is written on their own threads, 0xAA blocks (the optimal read
+    // size) at a time
+    CopyPipeline pipeline(0xAA000);
+    if (extractProgress != NULL)
+    {
+        pipeline.SetProgress([&](UINT64 bytesWritten)
+        {
+            extractProgress(arg, (DWORD)((bytesWritten + 0xFFF) >> 0xC), entry->blocksForFile);
+        });
+    }
+
+    CopyPipeline::ReadFunction readChunk;
+    std::vector<std::vector<Extent>> batches;
+    DWORD block = entry->startingBlockNum;
+    std::unordered_set<DWORD> visitedBlocks;
+
     if (useOptimizedPath)
     {
-        // Allocate buffer for 0xAA blocks (optimal read size)
-        std::vector<BYTE> buffer(0xAA000);
+        // work out where the file's data sits between the hash tables
+        std::vector<Extent> extents;
 
-        // seek to the beginning of the file
         DWORD startAddress = BlockToAddress(entry->startingBlockNum);
-        io->SetPosition(startAddress);
 
         // calculate the number of blocks to read before we hit a table
         DWORD blockCount = (ComputeLevel0BackingHashBlockNumber(entry->startingBlockNum) + blockStep[0])
@@ -564,116 +647,89 @@ void StfsPackage::ExtractFile(StfsFileEntry* entry, string outPath, void (*extra
 
         // pick up the change at the beginning, until we hit a hash table
         if ((DWORD)entry->blocksForFile <= blockCount)
-        {
-            io->ReadBytes(buffer.data(), entry->fileSize);
-            outFile.Write(buffer.data(), entry->fileSize);
-
-            // update progress if needed
-            if (extractProgress != NULL)
-                extractProgress(arg, entry->blocksForFile, entry->blocksForFile);
-
-            outFile.Close();
-            return;
-        }
+            extents.push_back({ startAddress, entry->fileSize });
         else
         {
-            io->ReadBytes(buffer.data(), blockCount << 0xC);
-            outFile.Write(buffer.data(), blockCount << 0xC);
-
-            // update progress if needed
-            if (extractProgress != NULL)
-                extractProgress(arg, blockCount, entry->blocksForFile);
-        }
-
-        // extract the blocks inbetween the tables
-        DWORD tempSize = (entry->fileSize - (blockCount << 0xC));
-        while (tempSize >= 0xAA000)
-        {
-            // skip past the hash table(s)
-            DWORD currentPos = io->GetPosition();
-            io->SetPosition(currentPos + GetHashTableSkipSize(currentPos));
-
-            // read in the 0xAA blocks between the tables
-            io->ReadBytes(buffer.data(), 0xAA000);
+            extents.push_back({ startAddress, blockCount << 0xC });
 
-            // Write the bytes to the out file
-            outFile.Write(buffer.data(), 0xAA000);
+            // the blocks inbetween the tables, 0xAA at a time, then the change at the end
+            DWORD tempSize = (entry->fileSize - (blockCount << 0xC));
+            DWORD currentPos = startAddress + (blockCount << 0xC);
+            while (tempSize != 0)
+            {
+                // skip past the hash table(s)
+                currentPos += GetHashTableSkipSize(currentPos);
 
-            tempSize -= 0xAA000;
-            blockCount += 0xAA;
+                DWORD length = (tempSize >= 0xAA000) ? 0xAA000 : tempSize;
+                extents.push_back({ currentPos, length });
 
-            // update progress if needed
-            if (extractProgress != NULL)
-                extractProgress(arg, blockCount, entry->blocksForFile);
+                tempSize -= length;
+                currentPos += length;
+            }
         }
 
-        // pick up the change at the end
-        if (tempSize != 0)
+        // every run of blocks in a buffer's worth is in flight at once
+        batches = AsyncIO::SplitExtents(extents, 0xAA000);
+        readChunk = [&](UINT64 i, BYTE *buffer)
         {
-            // skip past the hash table(s)
-            DWORD currentPos = io->GetPosition();
-            io->SetPosition(currentPos + GetHashTableSkipSize(currentPos));
-
-            // Read trailing data after hash tables
-            io->ReadBytes(buffer.data(), tempSize);
+            if (i >= batches.size())
+                return (DWORD)0;
 
-            // Write it to the out file
-            outFile.Write(buffer.data(), tempSize);
+            DWORD batchLength = 0;
+            for (const Extent &extent : batches.at(i))
+                batchLength += extent.length;
 
-            // update progress if needed
-            if (extractProgress != NULL)
-                extractProgress(arg, entry->blocksForFile, entry->blocksForFile);
-        }
+            io->ReadV(batches.at(i), buffer);
+            return batchLength;
+        };
     }
     else
     {
-        // generate the block chain which we have to extract
-        DWORD fullReadCounts = fileSize / 0x1000;
-
-        fileSize -= (fullReadCounts * 0x1000);
-
-        DWORD block = entry->startingBlockNum;
-
-        // allocate data for the blocks
-        BYTE data[0x1000];
-
-        // read all the full blocks the file allocates
-        std::unordered_set<DWORD> visitedBlocks;
-        for (DWORD i = 0; i < fullReadCounts; i++)
+        // follow the block chain, filling the buffer a block at a time
+        readChunk = [&](UINT64, BYTE *buffer)
         {
-            // Detect cycles
-            if (!visitedBlocks.insert(block).second)
+            DWORD length = 0;
+            while (fileSize != 0 && length < 0xAA000)
             {
-                outFile.Close();
-                except.str(std::string());
-                except << "STFS: Block chain cycle detected at block " << block
-                       << " while extracting '" << entry->name << "'";
-                throw except.str();
-            }
+                // Detect cycles
+                if (!visitedBlocks.insert(block).second)
+                {
+                    except.str(std::string());
+                    except << "STFS: Block chain cycle detected at block " << block
+                           << " while extracting '" << entry->name << "'";
+                    throw except.str();
+                }
 
-            ExtractBlock(block, data);
-            outFile.Write(data, 0x1000);
+                DWORD blockLength = (fileSize >= 0x1000) ? 0x1000 : fileSize;
+                ExtractBlock(block, buffer + length, blockLength);
 
-            block = GetBlockHashEntry(block).nextBlock;
+                length += blockLength;
+                fileSize -= blockLength;
 
-            // call the extract progress function if needed
-            if (extractProgress != NULL)
-                extractProgress(arg, i + 1, entry->blocksForFile);
-        }
+                if (fileSize != 0)
+                    block = GetBlockHashEntry(block).nextBlock;
+            }
+            return length;
+        };
+    }
 
-        // read the remaining data
-        if (fileSize != 0)
-        {
-            ExtractBlock(block, data, fileSize);
-            outFile.Write(data, fileSize);
+    pipeline.SetContext(context);
+    bool finished = pipeline.Run(readChunk, [&](UINT64, const BYTE *buffer, DWORD len)
+    {
+        outFile.Write(const_cast<BYTE*>(buffer), len);
+    });
 
-            // call the extract progress function if needed
-            if (extractProgress != NULL)
-                extractProgress(arg, entry->blocksForFile, entry->blocksForFile);
-        }
+    outFile.Close();
+
+    // don't leave half a file behind when it was cancelled
+    if (!finished)
+    {
+        remove(outPath.c_str());
+        context->ThrowIfCancelled();
     }
 
-    outFile.Close();
+    if (context)
+        context->EndItem();
 }
 
 DWORD StfsPackage::GetHashTableSkipSize(DWORD tableAddress)
@@ -899,12 +955,7 @@ HashTable StfsPackage::GetLevelNHashTable(DWORD index, Level lvl)
     toReturn.addressInFile = baseHashAddress;
     io->SetPosition(toReturn.addressInFile);
 
-    for (DWORD i = 0; i < toReturn.entryCount; i++)
-    {
-        io->ReadBytes(toReturn.entries[i].blockHash, 0x14);
-        toReturn.entries[i].status = io->ReadByte();
-        toReturn.entries[i].nextBlock = io->ReadInt24();
-    }
+    ReadHashEntries(toReturn.entries, toReturn.entryCount);
 
     return toReturn;
 }
@@ -935,6 +986,8 @@ DWORD StfsPackage::GetHashTableEntryCount(DWORD index, Level lvl)
 
 void StfsPackage::Rehash()
 {
+    TracingIO::Operation trace("StfsPackage::Rehash");
+
     // Invalidate the cached hash table since we're rebuilding everything
     cached.trueBlockNumber = 0xFFFFFFFF;
     
@@ -942,16 +995,12 @@ void StfsPackage::Rehash()
     switch (topLevel)
     {
     case Zero:
-        // set the position to the first data block in the file
-        io->SetPosition(BlockToAddress(0));
-        // iterate through all of the data blocks
+        // iterate through all of the data blocks, they start at the first data block in the file
         for (DWORD i = 0; i < topTable.entryCount; i++)
         {
-            // read in the current data block
-            io->ReadBytes(blockBuffer, 0x1000);
-
-            // hash the block
-            HashBlock(blockBuffer, topTable.entries[i].blockHash);
+            // hash the current data block, in place when the package is mapped
+            HashBlock(ViewBytes(BlockToAddress(0) + ((UINT64)i << 0xC), 0x1000, blockBuffer),
+                    topTable.entries[i].blockHash);
         }
 
         break;
@@ -963,17 +1012,15 @@ void StfsPackage::Rehash()
             // get the current level0 hash table
             HashTable level0Table = GetLevelNHashTable(i, Zero);
 
-            // set the position to the first data block in this table
-            io->SetPosition(BlockToAddress(i * 0xAA));
+            // the data blocks this table hashes follow each other from here
+            UINT64 dataAddress = BlockToAddress(i * 0xAA);
 
             // iterate through all of the data blocks this table hashes
             for (DWORD x = 0; x < level0Table.entryCount; x++)
             {
-                // read in the current data block
-                io->ReadBytes(blockBuffer, 0x1000);
-
-                // hash the block
-                HashBlock(blockBuffer, level0Table.entries[x].blockHash);
+                // hash the current data block, in place when the package is mapped
+                HashBlock(ViewBytes(dataAddress + ((UINT64)x << 0xC), 0x1000, blockBuffer),
+                        level0Table.entries[x].blockHash);
             }
 
             // build the table for hashing and writing
@@ -1001,17 +1048,15 @@ void StfsPackage::Rehash()
                 // get the current level0 hash table
                 HashTable level0Table = GetLevelNHashTable((i * 0xAA) + x, Zero);
 
-                // set the position to the first data block in this table
-                io->SetPosition(BlockToAddress((i * 0x70E4) + (x * 0xAA)));
+                // the data blocks hashed in this table follow each other from here
+                UINT64 dataAddress = BlockToAddress((i * 0x70E4) + (x * 0xAA));
 
                 // iterate through all of the data blocks hashed in this table
                 for (DWORD y = 0; y < level0Table.entryCount; y++)
                 {
-                    // read the current data block
-                    io->ReadBytes(blockBuffer, 0x1000);
-
-                    // hash the data block
-                    HashBlock(blockBuffer, level0Table.entries[y].blockHash);
+                    // hash the data block, in place when the package is mapped
+                    HashBlock(ViewBytes(dataAddress + ((UINT64)y << 0xC), 0x1000, blockBuffer),
+                            level0Table.entries[y].blockHash);
                 }
 
                 // build the table for hashing and writing
@@ -1081,17 +1126,17 @@ void StfsPackage::Rehash()
     DWORD calculated = ((metaData->headerSize + 0xFFF) & 0xF000);
     DWORD headerSize = calculated - headerStart;
 
-    // read the data to hash
-    std::vector<BYTE> buffer(headerSize);
-    io->SetPosition(headerStart);
-    io->ReadBytes(buffer.data(), headerSize);
+    // get the data to hash, a mapped package is hashed in place
+    std::vector<BYTE> copy(mappedIO ? 0 : headerSize);
+    const BYTE *header = ViewBytes(headerStart, headerSize, copy.data());
 
     // hash the header
     const auto sha1 = Botan::HashFunction::create_or_throw("SHA-1");
-    sha1->update(buffer.data(), headerSize);
+    sha1->update(header, headerSize);
     sha1->final(metaData->headerHash);
 
     metaData->WriteMetaData();
+    io->Flush();
 }
 
 void StfsPackage::ReloadHashTable()
@@ -1118,12 +1163,7 @@ void StfsPackage::ReloadHashTable()
         topTable.entryCount++;
 
     // Re-read all hash entries from disk
-    for (DWORD i = 0; i < topTable.entryCount; i++)
-    {
-        io->ReadBytes(topTable.entries[i].blockHash, 0x14);
-        topTable.entries[i].status = io->ReadByte();
-        topTable.entries[i].nextBlock = io->ReadInt24();
-    }
+    ReadHashEntries(topTable.entries, topTable.entryCount);
 
     DWORD headerStart;
 
@@ -1137,17 +1177,17 @@ void StfsPackage::ReloadHashTable()
     DWORD calculated = ((metaData->headerSize + 0xFFF) & 0xF000);
     DWORD headerSize = calculated - headerStart;
 
-    // read the data to hash
-    std::vector<BYTE> buffer(headerSize);
-    io->SetPosition(headerStart);
-    io->ReadBytes(buffer.data(), headerSize);
+    // get the data to hash, a mapped package is hashed in place
+    std::vector<BYTE> copy(mappedIO ? 0 : headerSize);
+    const BYTE *header = ViewBytes(headerStart, headerSize, copy.data());
 
     // hash the header
     const auto sha1 = Botan::HashFunction::create_or_throw("SHA-1");
-    sha1->update(buffer.data(), headerSize);
+    sha1->update(header, headerSize);
     sha1->final(metaData->headerHash);
 
     metaData->WriteMetaData();
+    io->Flush();
 }
 
 void StfsPackage::SwapTable(DWORD index, Level lvl)
@@ -1252,12 +1292,18 @@ DWORD StfsPackage::GetTableHashAddress(DWORD index, Level lvl)
 
 void StfsPackage::Resign(string kvPath)
 {
+    TracingIO::Operation trace("StfsPackage::Resign");
+
     metaData->ResignHeader(kvPath);
+    io->Flush();
 }
 
 void StfsPackage::Resign(BYTE* kvData, size_t length)
 {
+    TracingIO::Operation trace("StfsPackage::Resign");
+
     metaData->ResignHeader(kvData, length);
+    io->Flush();
 }
 
 void StfsPackage::SetBlockStatus(DWORD blockNum, BlockStatusLevelZero status)
@@ -1270,7 +1316,7 @@ void StfsPackage::SetBlockStatus(DWORD blockNum, BlockStatusLevelZero status)
     io->Write((BYTE)status);
 }
 
-void StfsPackage::HashBlock(BYTE* block, BYTE* outBuffer)
+void StfsPackage::HashBlock(const BYTE* block, BYTE* outBuffer)
 {
     // hash the block
     const auto sha1 = Botan::HashFunction::create_or_throw("SHA-1");
@@ -1296,6 +1342,8 @@ void StfsPackage::BuildTableInMemory(HashTable* table, BYTE* outBuffer)
 
 void StfsPackage::RemoveFile(StfsFileEntry entry)
 {
+    TracingIO::Operation trace("StfsPackage::RemoveFile");
+
     bool found = false;
 
     vector<StfsFileEntry> files, folders;
@@ -1450,6 +1498,9 @@ void StfsPackage::WriteFileListing(bool usePassed, vector<StfsFileEntry>* outFis
         metaData->stfsVolumeDescriptor.fileTableBlockCount--;
     metaData->WriteVolumeDescriptor();
 
+    // Write out everything the modification touched
+    io->Flush();
+
     ReadFileListing();
 }
 
@@ -1464,8 +1515,6 @@ void StfsPackage::SetNextBlock(DWORD blockNum, INT24 nextBlockNum)
 
     if (topLevel == Zero)
         topTable.entries[blockNum].nextBlock = nextBlockNum;
-
-    io->Flush();
 }
 
 void StfsPackage::WriteFileEntry(StfsFileEntry* entry)
@@ -1723,8 +1772,14 @@ void StfsPackage::UpdateEntry(string pathInPackage, StfsFileEntry entry)
 }
 
 StfsFileEntry StfsPackage::InjectFile(string path, string pathInPackage,
-    void(*injectProgress)(void*, DWORD, DWORD), void* arg)
+    void(*injectProgress)(void*, DWORD, DWORD), void* arg, OperationContext *context)
 {
+    TracingIO::Operation trace("StfsPackage::InjectFile");
+
+    // once blocks start getting allocated the file has to be finished, so it can only be cancelled up front
+    if (context)
+        context->ThrowIfCancelled();
+
     if (FileExists(pathInPackage))
         throw string("STFS: File already exists in the package.\n");
 
@@ -1775,6 +1830,8 @@ StfsFileEntry StfsPackage::InjectFile(string path, string pathInPackage,
     // update the progress if needed
     if (injectProgress != NULL)
         injectProgress(arg, 0, entry.blocksForFile);
+    if (context)
+        context->BeginItem(fileSize);
 
     UINT24 block = 0;
     UINT24 prevBlock = BLOCK_CHAIN_TERMINATOR;
@@ -1803,6 +1860,8 @@ StfsFileEntry StfsPackage::InjectFile(string path, string pathInPackage,
         // update the progress if needed
         if (injectProgress != NULL)
             injectProgress(arg, ++counter, entry.blocksForFile);
+        if (context)
+            context->AddBytes(0x1000);
     }
 
     if (fileSize != 0)
@@ -1820,6 +1879,8 @@ StfsFileEntry StfsPackage::InjectFile(string path, string pathInPackage,
         io->SetPosition(BlockToAddress(block));
     io->Write(data.data(), fileSize);
 
+        if (context)
+            context->AddBytes(fileSize);
         fileSize = 0;
 
         // update the progress if needed
@@ -1839,19 +1900,19 @@ StfsFileEntry StfsPackage::InjectFile(string path, string pathInPackage,
 
         topTable.entryCount = metaData->stfsVolumeDescriptor.allocatedBlockCount;
 
-        for (DWORD i = 0; i < topTable.entryCount; i++)
-        {
-            io->ReadBytes(topTable.entries[i].blockHash, 0x14);
-            topTable.entries[i].status = io->ReadByte();
-            topTable.entries[i].nextBlock = io->ReadInt24();
-        }
+        ReadHashEntries(topTable.entries, topTable.entryCount);
     }
+
+    if (context)
+        context->EndItem();
     return entry;
 }
 
 StfsFileEntry StfsPackage::InjectData(BYTE* data, DWORD length, string pathInPackage,
     void (*injectProgress)(void*, DWORD, DWORD), void* arg)
 {
+    TracingIO::Operation trace("StfsPackage::InjectData");
+
     if (FileExists(pathInPackage))
         throw string("STFS: File already exists in the package.\n");
 
@@ -1949,12 +2010,7 @@ StfsFileEntry StfsPackage::InjectData(BYTE* data, DWORD length, string pathInPac
 
         topTable.entryCount = metaData->stfsVolumeDescriptor.allocatedBlockCount;
 
-        for (DWORD i = 0; i < topTable.entryCount; i++)
-        {
-            io->ReadBytes(topTable.entries[i].blockHash, 0x14);
-            topTable.entries[i].status = io->ReadByte();
-            topTable.entries[i].nextBlock = io->ReadInt24();
-        }
+        ReadHashEntries(topTable.entries, topTable.entryCount);
     }
 
     return entry;
@@ -1963,6 +2019,8 @@ StfsFileEntry StfsPackage::InjectData(BYTE* data, DWORD length, string pathInPac
 void StfsPackage::ReplaceFile(string path, StfsFileEntry* entry, string pathInPackage,
     void (*replaceProgress)(void*, DWORD, DWORD), void* arg)
 {
+    TracingIO::Operation trace("StfsPackage::ReplaceFile");
+
     if (entry->nameLen == 0)
         throw string("STFS: File doesn't exists in the package.\n");
 
@@ -2089,16 +2147,13 @@ void StfsPackage::ReplaceFile(string path, StfsFileEntry* entry, string pathInPa
     {
         io->SetPosition(topTable.addressInFile);
 
-        for (DWORD i = 0; i < topTable.entryCount; i++)
-        {
-            io->ReadBytes(topTable.entries[i].blockHash, 0x14);
-            topTable.entries[i].status = io->ReadByte();
-            topTable.entries[i].nextBlock = io->ReadInt24();
-        }
+        ReadHashEntries(topTable.entries, topTable.entryCount);
     }
 
     // Clear cached block chains since we just modified this file's chain
     ClearCachedBlockChains();
+
+    io->Flush();
 }
 
 void StfsPackage::ReplaceFile(string path, string pathInPackage, void (*replaceProgress)(void*,
@@ -2110,6 +2165,8 @@ void StfsPackage::ReplaceFile(string path, string pathInPackage, void (*replaceP
 
 void StfsPackage::RenameFile(string newName, string pathInPackage)
 {
+    TracingIO::Operation trace("StfsPackage::RenameFile");
+
     StfsFileEntry entry = GetFileEntry(pathInPackage, true);
     entry.name = newName;
 
@@ -2118,6 +2175,7 @@ void StfsPackage::RenameFile(string newName, string pathInPackage)
 
     io->SetPosition(entry.fileEntryAddress);
     WriteFileEntry(&entry);
+    io->Flush();
 }
 
 void StfsPackage::Close()
@@ -2127,6 +2185,8 @@ void StfsPackage::Close()
 
 void StfsPackage::CreateFolder(string pathInPackage)
 {
+    TracingIO::Operation trace("StfsPackage::CreateFolder");
+
     // split the string and open a io
     vector<string> split = SplitString(pathInPackage, "\\");
 
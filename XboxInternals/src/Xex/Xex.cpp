@@ -1,6 +1,9 @@
 #include <XboxInternals/Xex/Xex.h>
 #include <XboxInternals/IO/XexZeroBasedCompressionIO.h>
 #include <XboxInternals/IO/XexAesIO.h>
+#include <XboxInternals/IO/BufferPool.h>
+#include <XboxInternals/IO/CopyPipeline.h>
+#include <XboxInternals/IO/MappedFileIO.h>
 
 #include <algorithm>
 #include <chrono>
@@ -22,8 +25,9 @@ Xex::Xex(BaseIO *io) :
     Parse();
 }
 
-Xex::Xex(std::string fileName) :
-    io(nullptr), ownedIO(std::make_unique<FileIO>(fileName)), firstResourceFileAddr(0xFFFFFFFF), imageBaseAddress(0),
+Xex::Xex(std::string fileName, bool mapFile) :
+    io(nullptr), ownedIO(mapFile ? std::unique_ptr<BaseIO>(std::make_unique<MappedFileIO>(fileName)) :
+            std::unique_ptr<BaseIO>(std::make_unique<FileIO>(fileName))), firstResourceFileAddr(0xFFFFFFFF), imageBaseAddress(0),
     entryPoint(0), originalBaseAddress(0), defaultStackSize(0), defaultFileSystemCacheSize(0),
     defaultHeapSize(0), titleWorkspaceSize(0), esrbRating(ESRB_RP), pegiRating(PEGI_Unrated),
     pegifiRating(PEGIFI_Unrated), pegiptRating(PEGIPT_Unrated), pegibbfcRating(PEGIBBF_Unrated),
@@ -279,7 +283,6 @@ void Xex::ExtractDecryptedData(std::string path) const
 
 void Xex::ExtractDecompressedData(std::string path)
 {
-    std::vector<BYTE> copyBuffer(XEX_COPY_BUFFER_SIZE);
     FileIO outFile(path, true);
 
     // if it's encrypted we'll have to decrypt it
@@ -287,63 +290,63 @@ void Xex::ExtractDecompressedData(std::string path)
     BYTE iv[XEX_AES_BLOCK_SIZE] = {0};
     aes->set_key(decryptedKey, XEX_AES_BLOCK_SIZE);
 
-    // seek to the beginning of the data
-    io->SetPosition(header.dataAddress);
-
-    // decompress the data
-    for (DWORD i = 0; i < compressionBlocks.size(); i++)
+    // a buffer's worth of the output, either data from the file or part of a run of null data
+    struct CopyPiece
+    {
+        UINT64 address;
+        DWORD length;
+        bool null;
+    };
+
+    // work out every piece up front, the data of each block directly follows the data of the one before it
+    std::vector<CopyPiece> pieces;
+    UINT64 address = header.dataAddress;
+    for (const XexCompressionBlock &block : compressionBlocks)
     {
-        XexCompressionBlock block = compressionBlocks.at(i);
+        for (DWORD copied = 0; copied < block.size; copied += XEX_COPY_BUFFER_SIZE)
+            pieces.push_back({ address + copied, std::min<DWORD>(block.size - copied, XEX_COPY_BUFFER_SIZE), false });
+        address += block.size;
 
-        // determine how many copy iterations it will take
-        DWORD copyIterations = block.size / XEX_COPY_BUFFER_SIZE;
-        if (block.size % XEX_COPY_BUFFER_SIZE != 0)
-            copyIterations++;
+        for (DWORD copied = 0; copied < block.nullSize; copied += XEX_COPY_BUFFER_SIZE)
+            pieces.push_back({ 0, std::min<DWORD>(block.nullSize - copied, XEX_COPY_BUFFER_SIZE), true });
+    }
 
-        // copy over the data
-        for (DWORD x = 0; x < copyIterations; x++)
+    // the data is read, decrypted and written out at the same time, each a piece apart
+    CopyPipeline pipeline(XEX_COPY_BUFFER_SIZE);
+    if (IsEncrypted())
+    {
+        pipeline.SetTransform([&](UINT64 i, BYTE *buffer, DWORD len)
         {
-            // determine the amount of bytes to copy
-            DWORD bytesToCopy = XEX_COPY_BUFFER_SIZE;
-            if (x + 1 == copyIterations && block.size % XEX_COPY_BUFFER_SIZE != 0)
-                bytesToCopy = block.size % XEX_COPY_BUFFER_SIZE;
-
-            // read in the data
-            io->ReadBytes(copyBuffer.data(), bytesToCopy);
+            if (pieces.at(i).null)
+                return;
 
-            // decrypt it if necessary
-            if (IsEncrypted())
+            // could be problematic
+            DWORD aesBlocksInBuffer = len / XEX_AES_BLOCK_SIZE;
+            for (DWORD y = 0; y < aesBlocksInBuffer; y++)
             {
-                // could be problematic
-                DWORD aesBlocksInBuffer = bytesToCopy / XEX_AES_BLOCK_SIZE;
-                for (DWORD y = 0; y < aesBlocksInBuffer; y++)
-                {
-                    BYTE *currentAesBlock = copyBuffer.data() + y * XEX_AES_BLOCK_SIZE;
-                    AesCbcDecrypt(aes.get(), iv, currentAesBlock, currentAesBlock);
-                }
+                BYTE *currentAesBlock = buffer + y * XEX_AES_BLOCK_SIZE;
+                AesCbcDecrypt(aes.get(), iv, currentAesBlock, currentAesBlock);
             }
-
-            outFile.WriteBytes(copyBuffer.data(), bytesToCopy);
-        }
-
-        // calculate the copy iterations for the null data
-        std::fill(copyBuffer.begin(), copyBuffer.end(), 0);
-        copyIterations = block.nullSize / XEX_COPY_BUFFER_SIZE;
-        if (block.nullSize % XEX_COPY_BUFFER_SIZE != 0)
-            copyIterations++;
-
-        // write all the null data
-        for (DWORD x = 0; x < copyIterations; x++)
-        {
-            // determine the amount of bytes to copy
-            DWORD bytesToCopy = XEX_COPY_BUFFER_SIZE;
-            if (x + 1 == copyIterations && block.nullSize % XEX_COPY_BUFFER_SIZE != 0)
-                bytesToCopy = block.nullSize % XEX_COPY_BUFFER_SIZE;
-
-            outFile.WriteBytes(copyBuffer.data(), bytesToCopy);
-        }
+        });
     }
 
+    pipeline.Run([&](UINT64 i, BYTE *buffer)
+    {
+        if (i >= pieces.size())
+            return (DWORD)0;
+
+        const CopyPiece &piece = pieces.at(i);
+        if (piece.null)
+            memset(buffer, 0, piece.length);
+        else
+            io->ReadAt(piece.address, buffer, piece.length);
+        return piece.length;
+    },
+    [&](UINT64, const BYTE *buffer, DWORD len)
+    {
+        outFile.WriteBytes(const_cast<BYTE*>(buffer), len);
+    });
+
     outFile.Close();
 }
 
@@ -353,6 +356,9 @@ void Xex::ExtractData2(std::string path)
     BaseIO *plaintextDataIO = io;
     plaintextDataIO->SetPosition(header.dataAddress);
 
+    // the data is read front to back, so the next chunk can be read while this one is written out
+    FileIO::ReadaheadScope readahead(dynamic_cast<FileIO*>(io));
+
     std::unique_ptr<BaseIO> aesIO;
     std::unique_ptr<BaseIO> decompressedIO;
 
@@ -390,7 +396,7 @@ void Xex::ExtractData2(std::string path)
     if (dataSize % XEX_COPY_BUFFER_SIZE != 0)
         copyIterations++;
 
-    std::vector<BYTE> copyBuffer(XEX_COPY_BUFFER_SIZE);
+    BufferLease copyBuffer = BufferPool::Shared().Acquire(XEX_COPY_BUFFER_SIZE);
 
     // copy the data over in chunks
     FileIO outFile(path, true);
@@ -402,8 +408,8 @@ void Xex::ExtractData2(std::string path)
             bytesToCopy = dataSize % XEX_COPY_BUFFER_SIZE;
 
         // copy the bytes to the out file
-    plaintextDataIO->ReadBytes(copyBuffer.data(), bytesToCopy);
-    outFile.Write(copyBuffer.data(), bytesToCopy);
+        plaintextDataIO->ReadBytes(copyBuffer.Data(), bytesToCopy);
+        outFile.Write(copyBuffer.Data(), bytesToCopy);
     }
 
     // cleanup handled by unique_ptr wrappers
@@ -535,37 +541,52 @@ void Xex::Parse()
     header.headerAddress = io->ReadDword();
     header.optionalHeaderEntryCount = io->ReadDword();
 
+    // the rest of the header is all in front of the data, so it's parsed from memory. A mapped file is parsed
+    // in place, anything else is read in one go
+    std::vector<BYTE> headerCopy;
+    BYTE *headerData;
+    MappedFileIO *mappedIO = dynamic_cast<MappedFileIO*>(io);
+    if (mappedIO)
+    {
+        headerData = const_cast<BYTE*>(mappedIO->View(0, header.dataAddress).data());
+    }
+    else
+    {
+        headerCopy.resize(header.dataAddress);
+        io->ReadAt(0, headerCopy.data(), header.dataAddress);
+        headerData = headerCopy.data();
+    }
+    MemoryIO headerIO(headerData, header.dataAddress);
+    headerIO.SetEndian(BigEndian);
+
     // read in all the optional header entries
     for (DWORD i = 0; i < header.optionalHeaderEntryCount; i++)
     {
         XexOptionalHeaderEntry entry;
-        ParseOptionalHeaderEntry(&entry, i);
+        ParseOptionalHeaderEntry(&headerIO, &entry, i);
     }
 
     // read the security info
-    io->SetPosition(header.headerAddress);
-    securityInfo.size = io->ReadDword();
-    securityInfo.imageSize = io->ReadDword();
-    io->ReadBytes(securityInfo.pirsRsaSignature, 0x100);
-    securityInfo.imageInfoSize = io->ReadDword();
-    securityInfo.imageFlags = io->ReadDword();
-    securityInfo.loadAddress = io->ReadDword();
-    io->ReadBytes(securityInfo.sectionHash, 0x14);
-    securityInfo.importTableSize = io->ReadDword();
-    io->ReadBytes(securityInfo.importTableHash, 0x14);
-    io->ReadBytes(securityInfo.mediaID, 0x10);
-    io->ReadBytes(securityInfo.key, XEX_AES_BLOCK_SIZE);
-    securityInfo.exportTableSize = io->ReadDword();
-    io->ReadBytes(securityInfo.headerHash, 0x14);
-    securityInfo.regions = io->ReadDword();
-    securityInfo.allowedMediaTypes = io->ReadDword();
+    headerIO.SetPosition(header.headerAddress);
+    securityInfo.size = headerIO.ReadDword();
+    securityInfo.imageSize = headerIO.ReadDword();
+    headerIO.ReadBytes(securityInfo.pirsRsaSignature, 0x100);
+    securityInfo.imageInfoSize = headerIO.ReadDword();
+    securityInfo.imageFlags = headerIO.ReadDword();
+    securityInfo.loadAddress = headerIO.ReadDword();
+    headerIO.ReadBytes(securityInfo.sectionHash, 0x14);
+    securityInfo.importTableSize = headerIO.ReadDword();
+    headerIO.ReadBytes(securityInfo.importTableHash, 0x14);
+    headerIO.ReadBytes(securityInfo.mediaID, 0x10);
+    headerIO.ReadBytes(securityInfo.key, XEX_AES_BLOCK_SIZE);
+    securityInfo.exportTableSize = headerIO.ReadDword();
+    headerIO.ReadBytes(securityInfo.headerHash, 0x14);
+    securityInfo.regions = headerIO.ReadDword();
+    securityInfo.allowedMediaTypes = headerIO.ReadDword();
 
     // Always try to determine which encryption key is used
     // Note: Some XEX files have encrypted=0 in BaseFileDescriptor but are still encrypted!
     const BYTE *key = XEX_RETAIL_KEY;
-    
-    // preserve the position in the file, TryKey() changes it
-    UINT64 position = io->GetPosition();
 
     // I don't think it says in the header which key it uses so we'll just try both
     if (TryKey(XEX_RETAIL_KEY))
@@ -585,8 +606,6 @@ void Xex::Parse()
         // Keep key as RETAIL_KEY for the session key decryption below
     }
 
-    io->SetPosition(position);
-
     // decrypt the key in the file (always done, even if data isn't encrypted)
     auto aes = Botan::BlockCipher::create("AES-128");
     aes->set_key(key, XEX_AES_BLOCK_SIZE);
@@ -600,47 +619,47 @@ void Xex::Parse()
         pageSize = 0x10000;
 
     // read the sections
-    DWORD sectionCount = io->ReadDword();
+    DWORD sectionCount = headerIO.ReadDword();
     for (DWORD i = 0; i < sectionCount; i++)
     {
         XexSectionEntry entry;
 
         // the bottom 4 bits are the type, the rest are the size of the entry in pages
-        DWORD entryInfo = io->ReadDword();
+        DWORD entryInfo = headerIO.ReadDword();
 
         entry.type = (XexSectionType)(entryInfo & 0x0F);
         entry.totalSize = (entryInfo >> 4) * pageSize;
 
-        io->ReadBytes(entry.hash, 0x14);
+        headerIO.ReadBytes(entry.hash, 0x14);
         sections.push_back(entry);
     }
 }
 
-void Xex::ParseOptionalHeaderEntry(XexOptionalHeaderEntry *entry, int index)
+void Xex::ParseOptionalHeaderEntry(BaseIO *headerIO, XexOptionalHeaderEntry *entry, int index)
 {
     // seek to the beginning of the entry
-    io->SetPosition(XEX_HEADER_SIZE + index * XEX_OPTIONAL_HEADER_ENTRY_SIZE);
+    headerIO->SetPosition(XEX_HEADER_SIZE + index * XEX_OPTIONAL_HEADER_ENTRY_SIZE);
 
     XexOptionalHeaderEntry headerEntry;
-    headerEntry.id = (XexOptionHeaderEntryID)io->ReadDword();
-    headerEntry.data = io->ReadDword();
+    headerEntry.id = (XexOptionHeaderEntryID)headerIO->ReadDword();
+    headerEntry.data = headerIO->ReadDword();
 
     switch (headerEntry.id)
     {
         case SystemImportLibraries:
-            ParseSystemImportLibraryTable(headerEntry.data);
+            ParseSystemImportLibraryTable(headerIO, headerEntry.data);
             break;
         case RatingInformation:
-            ParseRatingInformation(headerEntry.data);
+            ParseRatingInformation(headerIO, headerEntry.data);
             break;
         case StaticLibraries:
-            ParseStaticLibraryTable(headerEntry.data);
+            ParseStaticLibraryTable(headerIO, headerEntry.data);
             break;
         case OriginalPEImageName:
-            ParseOriginalPEImageName(headerEntry.data);
+            ParseOriginalPEImageName(headerIO, headerEntry.data);
             break;
         case ResourceInfo:
-            ParseResourceFileTable(headerEntry.data);
+            ParseResourceFileTable(headerIO, headerEntry.data);
             break;
         case ChecksumInformation:
         case TLSData:
@@ -651,13 +670,13 @@ void Xex::ParseOptionalHeaderEntry(XexOptionalHeaderEntry *entry, int index)
             // These optional headers are not currently processed
             break;
         case BaseFileDescriptor:
-            ParseBaseFileDescriptor(headerEntry.data);
+            ParseBaseFileDescriptor(headerIO, headerEntry.data);
             break;
         case ExecutionInfo:
-            ParseExecutionInfo(headerEntry.data);
+            ParseExecutionInfo(headerIO, headerEntry.data);
             break;
         case LANKey:
-            ParseLANKey(headerEntry.data);
+            ParseLANKey(headerIO, headerEntry.data);
             break;
         case ImageBaseAddress:
             imageBaseAddress = headerEntry.data;
@@ -683,82 +702,82 @@ void Xex::ParseOptionalHeaderEntry(XexOptionalHeaderEntry *entry, int index)
     }
 }
 
-void Xex::ParseSystemImportLibraryTable(DWORD address)
+void Xex::ParseSystemImportLibraryTable(BaseIO *headerIO, DWORD address)
 {
-    io->SetPosition(address);
+    headerIO->SetPosition(address);
 
     // unknown
-    io->ReadDword();
+    headerIO->ReadDword();
 
-    /*DWORD totalLength = */ io->ReadDword();
-    DWORD importLibraryCount = io->ReadDword();
+    /*DWORD totalLength = */ headerIO->ReadDword();
+    DWORD importLibraryCount = headerIO->ReadDword();
 
     // read the import library names
     for (DWORD i = 0; i < importLibraryCount; i++)
-        systemImportLibraries.push_back(io->ReadString());
+        systemImportLibraries.push_back(headerIO->ReadString());
 }
 
-void Xex::ParseRatingInformation(DWORD address)
+void Xex::ParseRatingInformation(BaseIO *headerIO, DWORD address)
 {
-    io->SetPosition(address);
+    headerIO->SetPosition(address);
 
-    esrbRating = (ESRBRating)io->ReadByte();
-    pegiRating = (PEGIRating)io->ReadByte();
-    pegifiRating = (PEGIFIRating)io->ReadByte();
-    pegiptRating = (PEGIPTRating)io->ReadByte();
-    pegibbfcRating = (PEGIBBFCRating)io->ReadByte();
+    esrbRating = (ESRBRating)headerIO->ReadByte();
+    pegiRating = (PEGIRating)headerIO->ReadByte();
+    pegifiRating = (PEGIFIRating)headerIO->ReadByte();
+    pegiptRating = (PEGIPTRating)headerIO->ReadByte();
+    pegibbfcRating = (PEGIBBFCRating)headerIO->ReadByte();
 
-    /*Cero*/	io->ReadByte();
-    /*USK*/		io->ReadByte();
+    /*Cero*/	headerIO->ReadByte();
+    /*USK*/		headerIO->ReadByte();
 
-    oflcAURating = (OFLCAURating)io->ReadByte();
-    oflcNZRating = (OFLCNZRating)io->ReadByte();
+    oflcAURating = (OFLCAURating)headerIO->ReadByte();
+    oflcNZRating = (OFLCNZRating)headerIO->ReadByte();
 
     // there are more
 }
 
-void Xex::ParseStaticLibraryTable(DWORD address)
+void Xex::ParseStaticLibraryTable(BaseIO *headerIO, DWORD address)
 {
-    io->SetPosition(address);
+    headerIO->SetPosition(address);
 
-    DWORD staticLibraryStructSize = io->ReadDword();
+    DWORD staticLibraryStructSize = headerIO->ReadDword();
     DWORD libraryCount = (staticLibraryStructSize - 4) / XEX_STATIC_LIBRARY_ENTRY_SIZE;
 
     for (DWORD i = 0; i < libraryCount; i++)
     {
         XexStaticLibraryInfo staticLibInfo;
-        staticLibInfo.name = io->ReadString(8);
+        staticLibInfo.name = headerIO->ReadString(8);
 
-        staticLibInfo.version.major = io->ReadWord();
-        staticLibInfo.version.minor = io->ReadWord();
-        staticLibInfo.version.build = io->ReadWord();
-        staticLibInfo.version.revision = io->ReadWord();
+        staticLibInfo.version.major = headerIO->ReadWord();
+        staticLibInfo.version.minor = headerIO->ReadWord();
+        staticLibInfo.version.build = headerIO->ReadWord();
+        staticLibInfo.version.revision = headerIO->ReadWord();
 
         staticLibraries.push_back(staticLibInfo);
     }
 }
 
-void Xex::ParseOriginalPEImageName(DWORD address)
+void Xex::ParseOriginalPEImageName(BaseIO *headerIO, DWORD address)
 {
     // seek past the length at the beginning
-    io->SetPosition(address + 4);
+    headerIO->SetPosition(address + 4);
 
-    originalPEImageName = io->ReadString();
+    originalPEImageName = headerIO->ReadString();
 }
 
-void Xex::ParseResourceFileTable(DWORD address)
+void Xex::ParseResourceFileTable(BaseIO *headerIO, DWORD address)
 {
-    io->SetPosition(address);
-    DWORD tableSize = io->ReadDword();
+    headerIO->SetPosition(address);
+    DWORD tableSize = headerIO->ReadDword();
     DWORD entryCount = (tableSize - 4) / XEX_RESOURCE_FILE_ENTRY_SIZE;
 
     for (DWORD i = 0; i < entryCount; i++)
     {
         // read the info from the file table
         XexResourceFileEntry entry;
-        entry.name = io->ReadString(8);
-        entry.address = io->ReadDword();
-        entry.size = io->ReadDword();
+        entry.name = headerIO->ReadString(8);
+        entry.address = headerIO->ReadDword();
+        entry.size = headerIO->ReadDword();
 
         if (entry.address < firstResourceFileAddr)
             firstResourceFileAddr = entry.address;
@@ -767,46 +786,46 @@ void Xex::ParseResourceFileTable(DWORD address)
     }
 }
 
-void Xex::ParseBaseFileDescriptor(DWORD address)
+void Xex::ParseBaseFileDescriptor(BaseIO *headerIO, DWORD address)
 {
-    io->SetPosition(address);
+    headerIO->SetPosition(address);
 
-    DWORD baseFileDescriptorSize = io->ReadDword();
+    DWORD baseFileDescriptorSize = headerIO->ReadDword();
 
-    encrypted = !!(io->ReadWord());
-    compressionState = (XexCompressionState)io->ReadWord();
+    encrypted = !!(headerIO->ReadWord());
+    compressionState = (XexCompressionState)headerIO->ReadWord();
 
     // read all the compression blocks
     DWORD blockCount = (baseFileDescriptorSize - 8) / XEX_COMPRESSION_BLOCK_SIZE;
     for (DWORD i = 0; i < blockCount; i++)
     {
         XexCompressionBlock block;
-        block.size = io->ReadDword();
-        block.nullSize = io->ReadDword();
+        block.size = headerIO->ReadDword();
+        block.nullSize = headerIO->ReadDword();
 
         compressionBlocks.push_back(block);
     }
 }
 
-void Xex::ParseLANKey(DWORD address)
+void Xex::ParseLANKey(BaseIO *headerIO, DWORD address)
 {
-    io->SetPosition(address);
-    io->ReadBytes(lanKey, XEX_LAN_KEY_SIZE);
+    headerIO->SetPosition(address);
+    headerIO->ReadBytes(lanKey, XEX_LAN_KEY_SIZE);
 }
 
-void Xex::ParseExecutionInfo(DWORD address)
+void Xex::ParseExecutionInfo(BaseIO *headerIO, DWORD address)
 {
-    io->SetPosition(address);
+    headerIO->SetPosition(address);
 
-    executionInfo.mediaID = io->ReadDword();
-    executionInfo.version = io->ReadDword();
-    executionInfo.baseVersion = io->ReadDword();
-    executionInfo.titleID = io->ReadDword();
-    executionInfo.executionTable = io->ReadByte();
-    executionInfo.platform = io->ReadByte();
-    executionInfo.discNumber = io->ReadByte();
-    executionInfo.discCount = io->ReadByte();
-    executionInfo.savegameID = io->ReadDword();
+    executionInfo.mediaID = headerIO->ReadDword();
+    executionInfo.version = headerIO->ReadDword();
+    executionInfo.baseVersion = headerIO->ReadDword();
+    executionInfo.titleID = headerIO->ReadDword();
+    executionInfo.executionTable = headerIO->ReadByte();
+    executionInfo.platform = headerIO->ReadByte();
+    executionInfo.discNumber = headerIO->ReadByte();
+    executionInfo.discCount = headerIO->ReadByte();
+    executionInfo.savegameID = headerIO->ReadDword();
 }
 
 void Xex::ExtractFromRawData(std::string outPath, DWORD address, DWORD size)
@@ -817,7 +836,7 @@ void Xex::ExtractFromRawData(std::string outPath, DWORD address, DWORD size)
     rawDataIO->SetPosition(offset + address);
 
     // extract the data
-    std::vector<BYTE> copyBuffer(XEX_COPY_BUFFER_SIZE);
+    BufferLease copyBuffer = BufferPool::Shared().Acquire(XEX_COPY_BUFFER_SIZE);
 
     // determine how many copy iterations it will take
     DWORD copyIterations = size / XEX_COPY_BUFFER_SIZE;
@@ -832,8 +851,8 @@ void Xex::ExtractFromRawData(std::string outPath, DWORD address, DWORD size)
         if (i + 1 == copyIterations && size % XEX_COPY_BUFFER_SIZE != 0)
             bytesToCopy = size % XEX_COPY_BUFFER_SIZE;
 
-    rawDataIO->ReadBytes(copyBuffer.data(), bytesToCopy);
-    outFile.WriteBytes(copyBuffer.data(), bytesToCopy);
+        rawDataIO->ReadBytes(copyBuffer.Data(), bytesToCopy);
+        outFile.WriteBytes(copyBuffer.Data(), bytesToCopy);
     }
 
     outFile.Close();